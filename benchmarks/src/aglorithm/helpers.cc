@@ -0,0 +1,110 @@
+#include "dictool/Aglorithm.h"
+#include <benchmark/benchmark.h>
+#include <map>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+using namespace dictool;
+
+// keys entries whose values take `distinct` different values: the fewer
+// distinct values, the more keys each reversed entry collects
+template <typename Dict> static Dict make_dict(int keys, int distinct) {
+  std::mt19937 rng(42);
+  Dict dict;
+  for (int k = 0; k < keys; ++k) {
+    dict.emplace(k, static_cast<int>(rng() % static_cast<unsigned>(distinct)));
+  }
+  return dict;
+}
+
+template <typename Dict> static void BM_Reverse(benchmark::State &state) {
+  auto dict = make_dict<Dict>(state.range(0), state.range(1));
+  for (auto _ : state) {
+    auto reversed = reverse(dict);
+    benchmark::DoNotOptimize(reversed.size());
+  }
+  state.SetItemsProcessed(state.iterations() * dict.size());
+}
+
+template <typename Dict>
+static void BM_ReverseCounted(benchmark::State &state) {
+  auto dict = make_dict<Dict>(state.range(0), state.range(1));
+  for (auto _ : state) {
+    auto reversed = reverse_counted(dict);
+    benchmark::DoNotOptimize(reversed.size());
+  }
+  state.SetItemsProcessed(state.iterations() * dict.size());
+}
+
+// Threads come from the last argument; 0 uses all hardware threads
+template <typename Dict>
+static void BM_ReverseParallel(benchmark::State &state) {
+  auto dict = make_dict<Dict>(state.range(0), state.range(1));
+  auto threads = static_cast<size_t>(state.range(2));
+  for (auto _ : state) {
+    auto reversed = reverse_parallel(dict, threads);
+    benchmark::DoNotOptimize(reversed.size());
+  }
+  state.SetItemsProcessed(state.iterations() * dict.size());
+}
+
+// Inverting a MultiMap whose keys hold `keys / distinct` values on average
+template <typename Dict>
+static void BM_ReverseMultiMap(benchmark::State &state) {
+  auto dict = make_dict<Dict>(state.range(0), state.range(1));
+  MultiMap<int, int, std::vector, std::map> mm;
+  for (const auto &[key, value] : dict) {
+    mm.emplace(value, key);
+  }
+  for (auto _ : state) {
+    auto inverted = reverse(mm);
+    benchmark::DoNotOptimize(inverted.size());
+  }
+  state.SetItemsProcessed(state.iterations() * mm.size());
+}
+
+template <typename Dict> static void BM_Transform(benchmark::State &state) {
+  auto dict = make_dict<Dict>(state.range(0), state.range(1));
+  std::function<long(int, int)> func = [](int k, int v) {
+    return static_cast<long>(k) * v;
+  };
+  for (auto _ : state) {
+    auto out = transform<int, int, long>(dict, func);
+    benchmark::DoNotOptimize(out.size());
+  }
+  state.SetItemsProcessed(state.iterations() * dict.size());
+}
+
+template <typename Dict> static void BM_ValuesOf(benchmark::State &state) {
+  auto dict = make_dict<Dict>(state.range(0), state.range(1));
+  for (auto _ : state) {
+    auto values = values_of<int, int>(dict);
+    benchmark::DoNotOptimize(values.size());
+  }
+  state.SetItemsProcessed(state.iterations() * dict.size());
+}
+
+using IntMap = std::map<int, int>;
+using IntHash = std::unordered_map<int, int>;
+
+#define HELPER_ARGS                                                            \
+  ArgNames({"keys", "distinct"})                                               \
+      ->Args({1 << 10, 1 << 10})                                               \
+      ->Args({1 << 16, 1 << 16})                                               \
+      ->Args({1 << 16, 1 << 6})
+
+BENCHMARK_TEMPLATE(BM_Reverse, IntMap)->HELPER_ARGS;
+BENCHMARK_TEMPLATE(BM_Reverse, IntHash)->HELPER_ARGS;
+BENCHMARK_TEMPLATE(BM_ReverseCounted, IntMap)->HELPER_ARGS;
+BENCHMARK_TEMPLATE(BM_ReverseCounted, IntHash)->HELPER_ARGS;
+BENCHMARK_TEMPLATE(BM_ReverseParallel, IntMap)
+    ->ArgNames({"keys", "distinct", "threads"})
+    ->Args({1 << 16, 1 << 16, 1})
+    ->Args({1 << 16, 1 << 16, 0})
+    ->Args({1 << 16, 1 << 6, 0});
+BENCHMARK_TEMPLATE(BM_ReverseMultiMap, IntMap)->HELPER_ARGS;
+BENCHMARK_TEMPLATE(BM_Transform, IntMap)->HELPER_ARGS;
+BENCHMARK_TEMPLATE(BM_Transform, IntHash)->HELPER_ARGS;
+BENCHMARK_TEMPLATE(BM_ValuesOf, IntMap)->HELPER_ARGS;
+BENCHMARK_TEMPLATE(BM_ValuesOf, IntHash)->HELPER_ARGS;
@@ -0,0 +1,71 @@
+#include "dictool/ParallelMultiMapBuilder.h"
+#include <benchmark/benchmark.h>
+#include <random>
+#include <unordered_map>
+
+using namespace dictool;
+
+// The slice of a total-value input produced by one of n workers, with
+// ten values per key on average
+static std::vector<std::pair<int, int>> make_slice(int total, int worker,
+                                                   int n) {
+  std::mt19937 rng(42 + worker);
+  std::vector<std::pair<int, int>> pairs(total / n);
+  for (auto &[key, value] : pairs) {
+    key = static_cast<int>(rng() % (total / 10));
+    value = static_cast<int>(rng());
+  }
+  return pairs;
+}
+
+// One thread emplacing range(0) values into one MultiMap
+template <template <typename...> class DTemplate>
+static void BM_SerialBuild(benchmark::State &state) {
+  auto pairs = make_slice(static_cast<int>(state.range(0)), 0, 1);
+  for (auto _ : state) {
+    MultiMap<int, int, std::vector, DTemplate> mm;
+    for (const auto &[key, value] : pairs) {
+      mm.try_emplace(key, value);
+    }
+    benchmark::DoNotOptimize(mm);
+  }
+  state.SetItemsProcessed(state.iterations() * pairs.size());
+}
+
+// range(1) workers each appending their slice of range(0) values, then
+// finish(). Past the core count, the serial splice at the end of finish()
+// and the per-partition overhead are what is left to measure.
+template <template <typename...> class DTemplate>
+static void BM_ParallelBuild(benchmark::State &state) {
+  int total = static_cast<int>(state.range(0));
+  int n = static_cast<int>(state.range(1));
+  std::vector<std::vector<std::pair<int, int>>> slices;
+  for (int w = 0; w < n; ++w) {
+    slices.push_back(make_slice(total, w, n));
+  }
+  for (auto _ : state) {
+    ParallelMultiMapBuilder<int, int, std::vector, DTemplate> builder(n);
+    builder.run([&](size_t w, auto &worker) {
+      for (const auto &[key, value] : slices[w]) {
+        worker.emplace(key, value);
+      }
+    });
+    auto mm = builder.finish();
+    benchmark::DoNotOptimize(mm);
+  }
+  state.SetItemsProcessed(state.iterations() * n * slices[0].size());
+}
+
+#define SERIAL_ARGS                                                            \
+  ArgName("values")->Arg(2000000)->Arg(16000000)->Unit(benchmark::kMillisecond)
+
+#define PARALLEL_ARGS                                                          \
+  ArgNames({"values", "threads"})                                              \
+      ->ArgsProduct({{2000000, 16000000}, {1, 2, 4, 8, 16, 32, 64}})           \
+      ->UseRealTime()                                                          \
+      ->Unit(benchmark::kMillisecond)
+
+BENCHMARK_TEMPLATE(BM_SerialBuild, std::map)->SERIAL_ARGS;
+BENCHMARK_TEMPLATE(BM_SerialBuild, std::unordered_map)->SERIAL_ARGS;
+BENCHMARK_TEMPLATE(BM_ParallelBuild, std::map)->PARALLEL_ARGS;
+BENCHMARK_TEMPLATE(BM_ParallelBuild, std::unordered_map)->PARALLEL_ARGS;
@@ -0,0 +1,60 @@
+#include "dictool/ConcurrentMultiMap.h"
+#include <benchmark/benchmark.h>
+#include <mutex>
+#include <random>
+
+using namespace dictool;
+
+// MultiMap behind one external mutex, the setup ConcurrentMultiMap replaces
+struct LockedMultiMap {
+  std::mutex lock;
+  MultiMap<int, int> map;
+
+  void emplace(int key, int value) {
+    std::lock_guard<std::mutex> guard(lock);
+    map.try_emplace(key, value);
+  }
+};
+
+// Random keys for one writer thread
+static std::vector<int> make_keys(int thread) {
+  std::mt19937 rng(42 + thread);
+  std::vector<int> keys(1024);
+  for (int &k : keys) {
+    k = static_cast<int>(rng() % 100000);
+  }
+  return keys;
+}
+
+static LockedMultiMap *locked_map = nullptr;
+static ConcurrentMultiMap<int, int> *sharded_map = nullptr;
+
+// Every thread emplaces 1024 random pairs per iteration into a shared map
+template <typename Map>
+static void BM_Ingest(benchmark::State &state, Map *&shared) {
+  if (state.thread_index() == 0) {
+    shared = new Map();
+  }
+  auto keys = make_keys(state.thread_index());
+  for (auto _ : state) {
+    for (int key : keys) {
+      shared->emplace(key, key);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * keys.size());
+  if (state.thread_index() == 0) {
+    delete shared;
+    shared = nullptr;
+  }
+}
+
+static void BM_LockedIngest(benchmark::State &state) {
+  BM_Ingest(state, locked_map);
+}
+
+static void BM_ShardedIngest(benchmark::State &state) {
+  BM_Ingest(state, sharded_map);
+}
+
+BENCHMARK(BM_LockedIngest)->ThreadRange(1, 16)->UseRealTime();
+BENCHMARK(BM_ShardedIngest)->ThreadRange(1, 16)->UseRealTime();
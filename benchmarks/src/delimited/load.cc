@@ -0,0 +1,87 @@
+#include "dictool/Delimited.h"
+#include <benchmark/benchmark.h>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <unordered_map>
+
+using namespace dictool;
+
+// Tab-separated file of 2M "key<TAB>value" lines, written once per process
+static const std::string &text_path() {
+  static const std::string path = [] {
+    auto p = (std::filesystem::temp_directory_path() / "dictool_bench.tsv")
+                 .string();
+    std::mt19937 rng(42);
+    std::ofstream out(p, std::ios::binary);
+    for (int i = 0; i < 2000000; ++i) {
+      out << rng() % 200000 << '\t' << rng() << '\n';
+    }
+    return p;
+  }();
+  return path;
+}
+
+static void set_bytes(benchmark::State &state) {
+  state.SetBytesProcessed(state.iterations() *
+                          std::filesystem::file_size(text_path()));
+}
+
+// The loader being replaced: iostreams feeding emplace()
+template <typename Map> static void BM_IostreamLoad(benchmark::State &state) {
+  for (auto _ : state) {
+    Map mm;
+    std::ifstream in(text_path());
+    typename Map::key_type key;
+    typename Map::mapped_type value;
+    while (in >> key >> value) {
+      mm.emplace(key, value);
+    }
+    benchmark::DoNotOptimize(mm);
+  }
+  set_bytes(state);
+}
+
+// load_delimited on range(0) threads
+template <typename Map> static void BM_LoadDelimited(benchmark::State &state) {
+  DelimitedOptions options;
+  options.threads = static_cast<size_t>(state.range(0));
+  for (auto _ : state) {
+    auto mm = load_delimited<Map>(text_path(), options);
+    benchmark::DoNotOptimize(mm);
+  }
+  set_bytes(state);
+}
+
+// Scanning and parsing alone, without building a map
+static void BM_ParseOnly(benchmark::State &state) {
+  MappedFile file(text_path());
+  for (auto _ : state) {
+    long sum = 0;
+    detail::parse_lines<int, long>(
+        file.data(), file.data(), file.data() + file.size(), text_path(),
+        '\t', [&](int key, long value) { sum += key + value; });
+    benchmark::DoNotOptimize(sum);
+  }
+  set_bytes(state);
+}
+
+using HashedMultiMap = MultiMap<int, long, std::vector, std::unordered_map>;
+
+BENCHMARK(BM_ParseOnly)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_IostreamLoad, MultiMap<int, long>)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_IostreamLoad, HashedMultiMap)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_LoadDelimited, MultiMap<int, long>)
+    ->ArgName("threads")
+    ->Arg(1)
+    ->Arg(4)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_LoadDelimited, HashedMultiMap)
+    ->ArgName("threads")
+    ->Arg(1)
+    ->Arg(4)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,109 @@
+#include "dictool/FlatHashMap.h"
+#include "dictool/MultiDict.h"
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <random>
+#include <unordered_map>
+
+using namespace dictool;
+
+template <typename K, typename V>
+using StdHashMap = std::unordered_map<K, V>;
+
+// n distinct keys in an order given by seed
+static std::vector<int> make_keys(size_t n, unsigned seed = 42) {
+  std::mt19937 rng(seed);
+  std::vector<int> keys(n);
+  for (size_t i = 0; i < n; ++i) {
+    keys[i] = static_cast<int>(i * 2);
+  }
+  std::shuffle(keys.begin(), keys.end(), rng);
+  return keys;
+}
+
+// Insert n keys into an empty map
+template <typename Map> static void BM_Insert(benchmark::State &state) {
+  auto keys = make_keys(state.range(0));
+  for (auto _ : state) {
+    Map m;
+    for (int key : keys) {
+      m[key] = key;
+    }
+    benchmark::DoNotOptimize(m);
+  }
+  state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+// Look up keys, half of them missing
+template <typename Map> static void BM_Find(benchmark::State &state) {
+  auto keys = make_keys(state.range(0));
+  Map m;
+  for (int key : keys) {
+    m[key] = key;
+  }
+  // Probe in another order than insertion so node-based maps do not
+  // benefit from allocation order
+  std::vector<int> probes = make_keys(state.range(0), 7);
+  for (int &p : probes) {
+    p += p % 4 == 0;
+  }
+  for (auto _ : state) {
+    long sum = 0;
+    for (int key : probes) {
+      auto it = m.find(key);
+      if (it != m.end()) {
+        sum += it->second;
+      }
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * probes.size());
+}
+
+// Build a MultiMap with 4 values per key through emplace
+template <template <typename...> class DTemplate>
+static void BM_MultiMapEmplace(benchmark::State &state) {
+  auto keys = make_keys(state.range(0));
+  for (auto _ : state) {
+    MultiMap<int, int, std::vector, DTemplate> mm;
+    for (int round = 0; round < 4; ++round) {
+      for (int key : keys) {
+        mm.emplace(key, round);
+      }
+    }
+    benchmark::DoNotOptimize(mm);
+  }
+  state.SetItemsProcessed(state.iterations() * keys.size() * 4);
+}
+
+// Query values of every key of a MultiMap
+template <template <typename...> class DTemplate>
+static void BM_MultiMapView(benchmark::State &state) {
+  auto keys = make_keys(state.range(0));
+  MultiMap<int, int, std::vector, DTemplate> mm;
+  for (int key : keys) {
+    mm.emplace(key, key);
+  }
+  std::vector<int> probes = make_keys(state.range(0), 7);
+  for (auto _ : state) {
+    long sum = 0;
+    for (int key : probes) {
+      for (int value : mm.view(key)) {
+        sum += value;
+      }
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+#define TABLE_ARGS ArgName("keys")->Arg(1000)->Arg(100000)->Arg(1000000)
+
+BENCHMARK_TEMPLATE(BM_Insert, StdHashMap<int, int>)->TABLE_ARGS;
+BENCHMARK_TEMPLATE(BM_Insert, flat_hash_map<int, int>)->TABLE_ARGS;
+BENCHMARK_TEMPLATE(BM_Find, StdHashMap<int, int>)->TABLE_ARGS;
+BENCHMARK_TEMPLATE(BM_Find, flat_hash_map<int, int>)->TABLE_ARGS;
+BENCHMARK_TEMPLATE(BM_MultiMapEmplace, StdHashMap)->TABLE_ARGS;
+BENCHMARK_TEMPLATE(BM_MultiMapEmplace, flat_hash_map)->TABLE_ARGS;
+BENCHMARK_TEMPLATE(BM_MultiMapView, StdHashMap)->TABLE_ARGS;
+BENCHMARK_TEMPLATE(BM_MultiMapView, flat_hash_map)->TABLE_ARGS;
@@ -0,0 +1,99 @@
+#include "dictool/FlatMap.h"
+#include "dictool/MultiDict.h"
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <random>
+
+using namespace dictool;
+
+using FlatMultiMap = MultiMap<int, int, std::vector, flat_map>;
+
+// keys x values-per-key pairs with shuffled keys and random values
+static std::vector<std::pair<int, int>> make_pairs(int keys, int per_key) {
+  std::mt19937 rng(42);
+  std::vector<std::pair<int, int>> pairs;
+  pairs.reserve(static_cast<size_t>(keys) * per_key);
+  for (int k = 0; k < keys; ++k) {
+    for (int i = 0; i < per_key; ++i) {
+      pairs.emplace_back(k * 7, static_cast<int>(rng() % 1000));
+    }
+  }
+  std::shuffle(pairs.begin(), pairs.end(), rng);
+  return pairs;
+}
+
+// Random lookup keys, half of them hits
+static std::vector<int> make_probes(int keys) {
+  std::mt19937 rng(7);
+  std::vector<int> probes(4096);
+  for (int &p : probes) {
+    p = static_cast<int>(rng() % (keys * 14));
+  }
+  return probes;
+}
+
+// Build through emplace() in shuffled key order
+template <typename Map> static void BM_Emplace(benchmark::State &state) {
+  auto pairs = make_pairs(state.range(0), state.range(1));
+  for (auto _ : state) {
+    Map map;
+    for (const auto &[key, value] : pairs) {
+      map.emplace(key, value);
+    }
+    benchmark::DoNotOptimize(map);
+  }
+  state.SetItemsProcessed(state.iterations() * pairs.size());
+}
+
+// Build through from_unsorted(), which appends keys in ascending order
+template <typename Map> static void BM_BulkLoad(benchmark::State &state) {
+  auto pairs = make_pairs(state.range(0), state.range(1));
+  for (auto _ : state) {
+    auto map = Map::from_unsorted(pairs);
+    benchmark::DoNotOptimize(map);
+  }
+  state.SetItemsProcessed(state.iterations() * pairs.size());
+}
+
+// Sum the values of random keys through view()
+template <typename Map> static void BM_Lookup(benchmark::State &state) {
+  auto map = Map::from_unsorted(make_pairs(state.range(0), state.range(1)));
+  auto probes = make_probes(state.range(0));
+  for (auto _ : state) {
+    long sum = 0;
+    for (int key : probes) {
+      for (int value : map.view(key)) {
+        sum += value;
+      }
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * probes.size());
+}
+
+// Sum all values in key order
+template <typename Map> static void BM_Iterate(benchmark::State &state) {
+  auto map = Map::from_unsorted(make_pairs(state.range(0), state.range(1)));
+  for (auto _ : state) {
+    long sum = 0;
+    for (const auto &[key, value] : map) {
+      sum += value;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * map.size());
+}
+
+#define FLAT_ARGS                                                              \
+  ArgNames({"keys", "per_key"})                                                \
+      ->Args({100000, 1})                                                      \
+      ->Args({10000, 16})
+
+BENCHMARK_TEMPLATE(BM_Emplace, MultiMap<int, int>)->FLAT_ARGS;
+BENCHMARK_TEMPLATE(BM_Emplace, FlatMultiMap)->FLAT_ARGS;
+BENCHMARK_TEMPLATE(BM_BulkLoad, MultiMap<int, int>)->FLAT_ARGS;
+BENCHMARK_TEMPLATE(BM_BulkLoad, FlatMultiMap)->FLAT_ARGS;
+BENCHMARK_TEMPLATE(BM_Lookup, MultiMap<int, int>)->FLAT_ARGS;
+BENCHMARK_TEMPLATE(BM_Lookup, FlatMultiMap)->FLAT_ARGS;
+BENCHMARK_TEMPLATE(BM_Iterate, MultiMap<int, int>)->FLAT_ARGS;
+BENCHMARK_TEMPLATE(BM_Iterate, FlatMultiMap)->FLAT_ARGS;
@@ -0,0 +1,83 @@
+#include "dictool/FrozenMultiMap.h"
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <random>
+#include <unordered_map>
+
+using namespace dictool;
+
+using HashedMultiMap = MultiMap<int, int, std::vector, std::unordered_map>;
+
+// keys x values-per-key pairs with shuffled keys and random values
+static std::vector<std::pair<int, int>> make_pairs(int keys, int per_key) {
+  std::mt19937 rng(42);
+  std::vector<std::pair<int, int>> pairs;
+  pairs.reserve(static_cast<size_t>(keys) * per_key);
+  for (int k = 0; k < keys; ++k) {
+    for (int i = 0; i < per_key; ++i) {
+      pairs.emplace_back(k * 7, static_cast<int>(rng() % 1000));
+    }
+  }
+  std::shuffle(pairs.begin(), pairs.end(), rng);
+  return pairs;
+}
+
+// Random lookup keys, half of them hits
+static std::vector<int> make_probes(int keys) {
+  std::mt19937 rng(7);
+  std::vector<int> probes(4096);
+  for (int &p : probes) {
+    p = static_cast<int>(rng() % (keys * 14));
+  }
+  return probes;
+}
+
+template <typename Map> static Map build(int keys, int per_key) {
+  if constexpr (std::is_same_v<Map, FrozenMultiMap<int, int>>) {
+    return Map(build<MultiMap<int, int>>(keys, per_key));
+  } else {
+    return Map::from_unsorted(make_pairs(keys, per_key));
+  }
+}
+
+// Sum the values of random keys through view()
+template <typename Map> static void BM_Lookup(benchmark::State &state) {
+  auto map = build<Map>(state.range(0), state.range(1));
+  auto probes = make_probes(state.range(0));
+  for (auto _ : state) {
+    long sum = 0;
+    for (int key : probes) {
+      for (int value : map.view(key)) {
+        sum += value;
+      }
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * probes.size());
+}
+
+// Sum all values, one group at a time
+template <typename Map> static void BM_Scan(benchmark::State &state) {
+  auto map = build<Map>(state.range(0), state.range(1));
+  for (auto _ : state) {
+    long sum = 0;
+    map.for_each_group([&](int, auto group) {
+      for (int value : group) {
+        sum += value;
+      }
+    });
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * map.size());
+}
+
+#define FROZEN_ARGS                                                            \
+  ArgNames({"keys", "per_key"})                                                \
+      ->Args({100000, 1})                                                      \
+      ->Args({10000, 16})
+
+BENCHMARK_TEMPLATE(BM_Lookup, MultiMap<int, int>)->FROZEN_ARGS;
+BENCHMARK_TEMPLATE(BM_Lookup, HashedMultiMap)->FROZEN_ARGS;
+BENCHMARK_TEMPLATE(BM_Lookup, FrozenMultiMap<int, int>)->FROZEN_ARGS;
+BENCHMARK_TEMPLATE(BM_Scan, MultiMap<int, int>)->FROZEN_ARGS;
+BENCHMARK_TEMPLATE(BM_Scan, FrozenMultiMap<int, int>)->FROZEN_ARGS;
@@ -0,0 +1,94 @@
+#include "dictool/Journal.h"
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <filesystem>
+#include <random>
+
+using namespace dictool;
+
+// 1M values over 100k keys
+static std::vector<std::pair<int, int>> make_pairs() {
+  std::mt19937 rng(42);
+  std::vector<std::pair<int, int>> pairs(1000000);
+  for (auto &[key, value] : pairs) {
+    key = static_cast<int>(rng() % 100000);
+    value = static_cast<int>(rng());
+  }
+  return pairs;
+}
+
+static std::string journal_path(const char *name) {
+  return (std::filesystem::temp_directory_path() / name).string();
+}
+
+// Log of make_pairs() plus every 16th pair erased, written once per process
+static const std::string &log_path() {
+  static const std::string path = [] {
+    std::string prefix = journal_path("dictool_bench_journal");
+    std::remove((prefix + ".log").c_str());
+    std::remove((prefix + ".snap").c_str());
+    auto pairs = make_pairs();
+    JournaledMultiMap<int, int> jm(prefix);
+    for (size_t i = 0; i < pairs.size(); ++i) {
+      jm.emplace(pairs[i].first, pairs[i].second);
+      if (i % 16 == 15) {
+        jm.erase(pairs[i - 8].first, pairs[i - 8].second);
+      }
+    }
+    return jm.log_path();
+  }();
+  return path;
+}
+
+// Logging cost of emplace, by group commit size
+static void BM_JournalEmplace(benchmark::State &state) {
+  auto pairs = make_pairs();
+  std::string prefix = journal_path("dictool_bench_append");
+  JournalOptions options;
+  options.group_bytes = static_cast<size_t>(state.range(0));
+  for (auto _ : state) {
+    std::remove((prefix + ".log").c_str());
+    JournaledMultiMap<int, int> jm(prefix, options);
+    for (const auto &[key, value] : pairs) {
+      jm.emplace(key, value);
+    }
+    jm.commit();
+    benchmark::DoNotOptimize(jm.size());
+  }
+  std::remove((prefix + ".log").c_str());
+  state.SetItemsProcessed(state.iterations() * pairs.size());
+}
+
+// Baseline: the same changes applied one call at a time
+static void BM_ReplayByEmplace(benchmark::State &state) {
+  auto pairs = make_pairs();
+  for (auto _ : state) {
+    MultiMap<int, int> mm;
+    for (size_t i = 0; i < pairs.size(); ++i) {
+      mm.emplace(pairs[i].first, pairs[i].second);
+      if (i % 16 == 15) {
+        mm.erase(pairs[i - 8].first, pairs[i - 8].second);
+      }
+    }
+    benchmark::DoNotOptimize(mm.size());
+  }
+  state.SetItemsProcessed(state.iterations() * pairs.size());
+}
+
+// Replay of the log, with runs of emplaces bulk-loaded
+static void BM_Replay(benchmark::State &state) {
+  const auto &path = log_path();
+  for (auto _ : state) {
+    auto mm = replay<MultiMap<int, int>>(path);
+    benchmark::DoNotOptimize(mm.size());
+  }
+  state.SetItemsProcessed(state.iterations() * 1000000);
+}
+
+BENCHMARK(BM_JournalEmplace)
+    ->ArgName("group_bytes")
+    ->Arg(1)
+    ->Arg(1 << 16)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ReplayByEmplace)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Replay)->Unit(benchmark::kMillisecond);
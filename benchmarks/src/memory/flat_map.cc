@@ -0,0 +1,47 @@
+#include "dictool/FlatMap.h"
+#include "dictool/MultiDict.h"
+#include "heap.h"
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <random>
+
+using namespace dictool;
+
+using FlatMultiMap = MultiMap<int, int, std::vector, flat_map>;
+
+// keys x values-per-key pairs with shuffled keys and random values
+static std::vector<std::pair<int, int>> make_pairs(int keys, int per_key) {
+  std::mt19937 rng(42);
+  std::vector<std::pair<int, int>> pairs;
+  pairs.reserve(static_cast<size_t>(keys) * per_key);
+  for (int k = 0; k < keys; ++k) {
+    for (int i = 0; i < per_key; ++i) {
+      pairs.emplace_back(k * 7, static_cast<int>(rng() % 1000));
+    }
+  }
+  std::shuffle(pairs.begin(), pairs.end(), rng);
+  return pairs;
+}
+
+// Heap bytes per stored value held by a bulk-loaded map
+template <typename Map> static void BM_FlatMemory(benchmark::State &state) {
+  auto pairs = make_pairs(state.range(0), state.range(1));
+  size_t bytes = 0;
+  for (auto _ : state) {
+    size_t before = counting_heap::live_bytes();
+    auto map = Map::from_unsorted(pairs);
+    bytes = counting_heap::live_bytes() - before;
+    benchmark::DoNotOptimize(map);
+  }
+  state.counters["bytes_per_value"] =
+      static_cast<double>(bytes) / pairs.size();
+}
+
+#define FLAT_ARGS                                                              \
+  ArgNames({"keys", "per_key"})                                                \
+      ->Args({100000, 1})                                                      \
+      ->Args({10000, 16})                                                      \
+      ->Iterations(1)
+
+BENCHMARK_TEMPLATE(BM_FlatMemory, MultiMap<int, int>)->FLAT_ARGS;
+BENCHMARK_TEMPLATE(BM_FlatMemory, FlatMultiMap)->FLAT_ARGS;
@@ -0,0 +1,57 @@
+#include "dictool/FrozenMultiMap.h"
+#include "heap.h"
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <random>
+#include <unordered_map>
+
+using namespace dictool;
+
+using HashedMultiMap = MultiMap<int, int, std::vector, std::unordered_map>;
+
+// keys x values-per-key pairs with shuffled keys and random values
+static std::vector<std::pair<int, int>> make_pairs(int keys, int per_key) {
+  std::mt19937 rng(42);
+  std::vector<std::pair<int, int>> pairs;
+  pairs.reserve(static_cast<size_t>(keys) * per_key);
+  for (int k = 0; k < keys; ++k) {
+    for (int i = 0; i < per_key; ++i) {
+      pairs.emplace_back(k * 7, static_cast<int>(rng() % 1000));
+    }
+  }
+  std::shuffle(pairs.begin(), pairs.end(), rng);
+  return pairs;
+}
+
+template <typename Map> static Map build(int keys, int per_key) {
+  if constexpr (std::is_same_v<Map, FrozenMultiMap<int, int>>) {
+    return Map(build<MultiMap<int, int>>(keys, per_key));
+  } else {
+    return Map::from_unsorted(make_pairs(keys, per_key));
+  }
+}
+
+// Heap bytes per stored value held by a built map
+template <typename Map> static void BM_FrozenMemory(benchmark::State &state) {
+  size_t bytes = 0;
+  size_t size = 0;
+  for (auto _ : state) {
+    size_t before = counting_heap::live_bytes();
+    auto map = build<Map>(state.range(0), state.range(1));
+    bytes = counting_heap::live_bytes() - before;
+    size = map.size();
+    benchmark::DoNotOptimize(map);
+  }
+  state.counters["bytes"] = static_cast<double>(bytes);
+  state.counters["bytes_per_value"] = static_cast<double>(bytes) / size;
+}
+
+#define FROZEN_ARGS                                                            \
+  ArgNames({"keys", "per_key"})                                                \
+      ->Args({100000, 1})                                                      \
+      ->Args({10000, 16})                                                      \
+      ->Iterations(1)
+
+BENCHMARK_TEMPLATE(BM_FrozenMemory, MultiMap<int, int>)->FROZEN_ARGS;
+BENCHMARK_TEMPLATE(BM_FrozenMemory, HashedMultiMap)->FROZEN_ARGS;
+BENCHMARK_TEMPLATE(BM_FrozenMemory, FrozenMultiMap<int, int>)->FROZEN_ARGS;
@@ -0,0 +1,56 @@
+#include "dictool/FlatHashMap.h"
+#include "dictool/MultiDict.h"
+#include "dictool/SmallVector.h"
+#include "heap.h"
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <random>
+
+using namespace dictool;
+
+// Pairs where 90% of the keys hold 1-3 values and the rest 4-32
+static std::vector<std::pair<int, int>> make_pairs(int keys) {
+  std::mt19937 rng(42);
+  std::vector<std::pair<int, int>> pairs;
+  for (int k = 0; k < keys; ++k) {
+    int n = rng() % 10 != 0 ? 1 + rng() % 3 : 4 + rng() % 29;
+    for (int i = 0; i < n; ++i) {
+      pairs.emplace_back(k, static_cast<int>(rng() % 1000));
+    }
+  }
+  std::shuffle(pairs.begin(), pairs.end(), rng);
+  return pairs;
+}
+
+// Heap allocations and bytes per key of a map built through emplace
+template <template <typename...> class CTemplate,
+          template <typename...> class DTemplate>
+static void BM_SmallMemory(benchmark::State &state) {
+  auto pairs = make_pairs(state.range(0));
+  size_t allocations = 0;
+  size_t bytes = 0;
+  for (auto _ : state) {
+    size_t allocs_before = counting_heap::allocations();
+    size_t bytes_before = counting_heap::live_bytes();
+    MultiMap<int, int, CTemplate, DTemplate> mm;
+    for (const auto &[key, value] : pairs) {
+      mm.emplace(key, value);
+    }
+    allocations = counting_heap::allocations() - allocs_before;
+    bytes = counting_heap::live_bytes() - bytes_before;
+    benchmark::DoNotOptimize(mm);
+  }
+  state.counters["allocs_per_key"] =
+      static_cast<double>(allocations) / state.range(0);
+  state.counters["bytes_per_key"] = static_cast<double>(bytes) / state.range(0);
+}
+
+template <typename T> using StdVector = std::vector<T>;
+template <typename K, typename V> using StdMap = std::map<K, V>;
+
+#define SMALL_ARGS ArgName("keys")->Arg(10000)->Arg(200000)->Iterations(1)
+
+BENCHMARK_TEMPLATE(BM_SmallMemory, StdVector, StdMap)->SMALL_ARGS;
+BENCHMARK_TEMPLATE(BM_SmallMemory, small_vector, StdMap)->SMALL_ARGS;
+BENCHMARK_TEMPLATE(BM_SmallMemory, StdVector, flat_hash_map)->SMALL_ARGS;
+BENCHMARK_TEMPLATE(BM_SmallMemory, small_vector, flat_hash_map)->SMALL_ARGS;
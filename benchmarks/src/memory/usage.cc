@@ -0,0 +1,99 @@
+#include "dictool/FlatHashMap.h"
+#include "dictool/FlatMap.h"
+#include "dictool/FrozenMultiMap.h"
+#include "dictool/MultiDict.h"
+#include "dictool/SmallVector.h"
+#include "heap.h"
+#include <benchmark/benchmark.h>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+using namespace dictool;
+
+// The layouts compared; each key's value list is small and skewed
+using VectorMap = MultiMap<int, int, std::vector, std::map>;
+using VectorHash = MultiMap<int, int, std::vector, std::unordered_map>;
+using SetMap = MultiMap<int, int, std::set, std::map>;
+using SmallFlatHash = MultiMap<int, int, small_vector, flat_hash_map>;
+using VectorFlatMap = MultiMap<int, int, std::vector, flat_map>;
+using Frozen = FrozenMultiMap<int, int>;
+using StringHash =
+    MultiMap<std::string, std::string, std::vector, std::unordered_map>;
+
+// Pairs where 90% of the keys hold 1-3 values and the rest 4-32
+template <typename K, typename V>
+static std::vector<std::pair<K, V>> make_pairs(int keys) {
+  std::mt19937 rng(42);
+  std::vector<std::pair<K, V>> pairs;
+  for (int k = 0; k < keys; ++k) {
+    int n = rng() % 10 != 0 ? 1 + rng() % 3 : 4 + rng() % 29;
+    for (int i = 0; i < n; ++i) {
+      int v = static_cast<int>(rng() % 100000);
+      if constexpr (std::is_same_v<K, std::string>) {
+        // Keys too long for the short string buffer
+        pairs.emplace_back("key/" + std::to_string(k) + "/of/some/length",
+                           std::to_string(v));
+      } else {
+        pairs.emplace_back(k, v);
+      }
+    }
+  }
+  return pairs;
+}
+
+template <typename Map> static Map build(int keys) {
+  using K = typename Map::key_type;
+  using V = typename Map::mapped_type;
+  auto pairs = make_pairs<K, V>(keys);
+  if constexpr (std::is_same_v<Map, Frozen>) {
+    VectorMap mm;
+    for (const auto &[key, value] : pairs) {
+      mm.emplace(key, value);
+    }
+    return Frozen(mm);
+  } else {
+    Map mm;
+    for (const auto &[key, value] : pairs) {
+      mm.emplace(key, value);
+    }
+    return mm;
+  }
+}
+
+// memory_usage() of a built map, per value, next to the heap bytes
+// actually requested, and the time the estimate takes
+template <typename Map> static void BM_MemoryUsage(benchmark::State &state) {
+  size_t before = counting_heap::live_bytes();
+  auto map = build<Map>(static_cast<int>(state.range(0)));
+  size_t measured = counting_heap::live_bytes() - before;
+  MemoryUsage usage;
+  for (auto _ : state) {
+    usage = map.memory_usage();
+    benchmark::DoNotOptimize(usage);
+  }
+  auto per_value = [&](size_t bytes) {
+    return static_cast<double>(bytes) / static_cast<double>(map.size());
+  };
+  state.counters["total_per_value"] = per_value(usage.total());
+  state.counters["heap_per_value"] = per_value(measured);
+  state.counters["structure"] = per_value(usage.structure);
+  state.counters["headers"] = per_value(usage.headers);
+  state.counters["slack"] = per_value(usage.slack);
+  state.counters["value_nodes"] = per_value(usage.value_nodes);
+  state.counters["payload"] = per_value(usage.payload);
+  state.counters["allocator"] = per_value(usage.allocator);
+  state.SetItemsProcessed(state.iterations() * map.key_count());
+}
+
+BENCHMARK_TEMPLATE(BM_MemoryUsage, VectorMap)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_MemoryUsage, VectorHash)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_MemoryUsage, SetMap)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_MemoryUsage, SmallFlatHash)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_MemoryUsage, VectorFlatMap)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_MemoryUsage, Frozen)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_MemoryUsage, StringHash)->Arg(1 << 16);
@@ -0,0 +1,71 @@
+#include "dictool/MultiDict.h"
+#include <benchmark/benchmark.h>
+#include <random>
+
+using namespace dictool;
+
+// keys x values-per-key map with random values
+static MultiMap<int, int> make_map(int keys, int per_key) {
+  std::mt19937 rng(42);
+  std::vector<std::pair<int, int>> pairs;
+  pairs.reserve(static_cast<size_t>(keys) * per_key);
+  for (int k = 0; k < keys; ++k) {
+    for (int i = 0; i < per_key; ++i) {
+      pairs.emplace_back(k, static_cast<int>(rng() % 1000));
+    }
+  }
+  return MultiMap<int, int>::from_unsorted(std::move(pairs));
+}
+
+// Sum all values through the flattened (key, value) iterator
+static void BM_IterateFlat(benchmark::State &state) {
+  auto mm = make_map(state.range(0), state.range(1));
+  for (auto _ : state) {
+    long sum = 0;
+    for (const auto &[key, value] : mm) {
+      sum += value;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * mm.size());
+}
+
+// Sum all values through groups()
+static void BM_IterateGroups(benchmark::State &state) {
+  auto mm = make_map(state.range(0), state.range(1));
+  for (auto _ : state) {
+    long sum = 0;
+    for (auto [key, group] : mm.groups()) {
+      for (int value : group) {
+        sum += value;
+      }
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * mm.size());
+}
+
+// Sum all values through for_each_group()
+static void BM_IterateForEachGroup(benchmark::State &state) {
+  auto mm = make_map(state.range(0), state.range(1));
+  for (auto _ : state) {
+    long sum = 0;
+    mm.for_each_group([&](int, Span<const int> group) {
+      for (int value : group) {
+        sum += value;
+      }
+    });
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * mm.size());
+}
+
+#define ITERATION_ARGS                                                         \
+  ArgNames({"keys", "per_key"})                                                \
+      ->Args({100000, 1})                                                      \
+      ->Args({10000, 16})                                                      \
+      ->Args({1000, 256})
+
+BENCHMARK(BM_IterateFlat)->ITERATION_ARGS;
+BENCHMARK(BM_IterateGroups)->ITERATION_ARGS;
+BENCHMARK(BM_IterateForEachGroup)->ITERATION_ARGS;
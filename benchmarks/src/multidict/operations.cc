@@ -0,0 +1,211 @@
+#include "dictool/MultiDict.h"
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <map>
+#include <numeric>
+#include <random>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+using namespace dictool;
+
+// The MultiMap layouts under test, against the standard multimaps
+using VectorMap = MultiMap<int, int, std::vector, std::map>;
+using VectorHash = MultiMap<int, int, std::vector, std::unordered_map>;
+using SetMap = MultiMap<int, int, std::set, std::map>;
+using SetHash = MultiMap<int, int, std::set, std::unordered_map>;
+using VectorHashCounted =
+    MultiMap<int, int, std::vector, std::unordered_map, CountingStats>;
+using StdMultimap = std::multimap<int, int>;
+using StdUnorderedMultimap = std::unordered_multimap<int, int>;
+
+static constexpr size_t kValues = 1u << 17;
+static constexpr size_t kProbes = 1u << 12;
+
+// kValues pairs over `keys` keys, uniform or Zipf(1)-skewed. Key ids are
+// shuffled so that the hot keys are spread over the key space
+static std::vector<std::pair<int, int>> make_pairs(size_t keys, bool skewed) {
+  std::mt19937 rng(42);
+  std::vector<int> ids(keys);
+  std::iota(ids.begin(), ids.end(), 0);
+  std::shuffle(ids.begin(), ids.end(), rng);
+
+  std::vector<double> cdf(keys);
+  double total = 0;
+  for (size_t r = 0; r < keys; ++r) {
+    total += skewed ? 1.0 / static_cast<double>(r + 1) : 1.0;
+    cdf[r] = total;
+  }
+  std::uniform_real_distribution<double> pick(0, total);
+  std::vector<std::pair<int, int>> pairs(kValues);
+  for (auto &[key, value] : pairs) {
+    size_t r = static_cast<size_t>(
+        std::upper_bound(cdf.begin(), cdf.end(), pick(rng)) - cdf.begin());
+    key = ids[std::min(r, keys - 1)];
+    value = static_cast<int>(rng());
+  }
+  return pairs;
+}
+
+// Keys to look up, drawn like the pairs so that hot keys are hit often
+static std::vector<int> make_probes(const std::vector<std::pair<int, int>> &p) {
+  std::mt19937 rng(7);
+  std::vector<int> probes(kProbes);
+  for (int &key : probes) {
+    key = p[rng() % p.size()].first;
+  }
+  return probes;
+}
+
+template <typename Map>
+static Map build(const std::vector<std::pair<int, int>> &pairs) {
+  Map m;
+  for (const auto &[key, value] : pairs) {
+    m.emplace(key, value);
+  }
+  return m;
+}
+
+static std::vector<std::pair<int, int>> pairs_for(benchmark::State &state) {
+  return make_pairs(static_cast<size_t>(state.range(0)), state.range(1) != 0);
+}
+
+template <typename Map> static void BM_Emplace(benchmark::State &state) {
+  auto pairs = pairs_for(state);
+  for (auto _ : state) {
+    auto m = build<Map>(pairs);
+    benchmark::DoNotOptimize(m.size());
+  }
+  state.SetItemsProcessed(state.iterations() * pairs.size());
+}
+
+template <typename Map> static void BM_Find(benchmark::State &state) {
+  auto pairs = pairs_for(state);
+  auto m = build<Map>(pairs);
+  auto probes = make_probes(pairs);
+  for (auto _ : state) {
+    long sum = 0;
+    for (int key : probes) {
+      auto it = m.find(key);
+      if (it != m.end()) {
+        sum += (*it).second;
+      }
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * probes.size());
+}
+
+// Visit every value of each probed key; items are values visited
+template <typename Map> static void BM_EqualRange(benchmark::State &state) {
+  auto pairs = pairs_for(state);
+  auto m = build<Map>(pairs);
+  auto probes = make_probes(pairs);
+  int64_t visited = 0;
+  for (auto _ : state) {
+    long sum = 0;
+    for (int key : probes) {
+      auto [first, last] = m.equal_range(key);
+      for (; first != last; ++first, ++visited) {
+        sum += (*first).second;
+      }
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(visited);
+}
+
+// Erase the first value of each probed key through erase(iterator)
+template <typename Map> static void BM_EraseIterator(benchmark::State &state) {
+  auto pairs = pairs_for(state);
+  auto m = build<Map>(pairs);
+  auto probes = make_probes(pairs);
+  for (auto _ : state) {
+    state.PauseTiming();
+    Map copy = m;
+    state.ResumeTiming();
+    for (int key : probes) {
+      auto it = copy.find(key);
+      if (it != copy.end()) {
+        copy.erase(it);
+      }
+    }
+    benchmark::DoNotOptimize(copy.size());
+  }
+  state.SetItemsProcessed(state.iterations() * probes.size());
+}
+
+template <typename Map> static void BM_Iterate(benchmark::State &state) {
+  auto m = build<Map>(pairs_for(state));
+  for (auto _ : state) {
+    long sum = 0;
+    for (const auto &[key, value] : m) {
+      sum += value;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * m.size());
+}
+
+template <typename Map> static void BM_Size(benchmark::State &state) {
+  auto m = build<Map>(pairs_for(state));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(m.size());
+  }
+}
+
+// Merge a map holding the second half of the pairs into one holding the
+// first half
+template <typename Map> static void BM_Merge(benchmark::State &state) {
+  auto pairs = pairs_for(state);
+  auto middle = pairs.begin() + static_cast<long>(pairs.size() / 2);
+  auto left = build<Map>({pairs.begin(), middle});
+  auto right = build<Map>({middle, pairs.end()});
+  for (auto _ : state) {
+    state.PauseTiming();
+    Map dst = left;
+    Map src = right;
+    state.ResumeTiming();
+    dst.merge(std::move(src));
+    benchmark::DoNotOptimize(dst.size());
+  }
+  state.SetItemsProcessed(state.iterations() * (pairs.size() / 2));
+}
+
+// One stats() summary: histogram and top 10 keys in one pass
+template <typename Map> static void BM_Stats(benchmark::State &state) {
+  auto m = build<Map>(pairs_for(state));
+  for (auto _ : state) {
+    auto stats = m.stats();
+    benchmark::DoNotOptimize(stats.top_keys.data());
+  }
+  state.SetItemsProcessed(state.iterations() * m.key_count());
+}
+
+// keys in {1k, 16k} x uniform or Zipf-skewed values per key
+#define OPERATION_ARGS                                                         \
+  ArgNames({"keys", "zipf"})                                                   \
+      ->Args({1 << 10, 0})                                                     \
+      ->Args({1 << 10, 1})                                                     \
+      ->Args({1 << 14, 0})                                                     \
+      ->Args({1 << 14, 1})
+
+#define OPERATION_BENCHMARKS(Map)                                              \
+  BENCHMARK_TEMPLATE(BM_Emplace, Map)->OPERATION_ARGS;                         \
+  BENCHMARK_TEMPLATE(BM_Find, Map)->OPERATION_ARGS;                            \
+  BENCHMARK_TEMPLATE(BM_EqualRange, Map)->OPERATION_ARGS;                      \
+  BENCHMARK_TEMPLATE(BM_EraseIterator, Map)->OPERATION_ARGS;                   \
+  BENCHMARK_TEMPLATE(BM_Iterate, Map)->OPERATION_ARGS;                         \
+  BENCHMARK_TEMPLATE(BM_Size, Map)->OPERATION_ARGS;                            \
+  BENCHMARK_TEMPLATE(BM_Merge, Map)->OPERATION_ARGS
+
+OPERATION_BENCHMARKS(VectorMap);
+OPERATION_BENCHMARKS(VectorHash);
+OPERATION_BENCHMARKS(SetMap);
+OPERATION_BENCHMARKS(SetHash);
+OPERATION_BENCHMARKS(VectorHashCounted);
+OPERATION_BENCHMARKS(StdMultimap);
+OPERATION_BENCHMARKS(StdUnorderedMultimap);
+BENCHMARK_TEMPLATE(BM_Stats, VectorMap)->OPERATION_ARGS;
+BENCHMARK_TEMPLATE(BM_Stats, VectorHash)->OPERATION_ARGS;
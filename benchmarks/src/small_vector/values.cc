@@ -0,0 +1,72 @@
+#include "dictool/FlatHashMap.h"
+#include "dictool/MultiDict.h"
+#include "dictool/SmallVector.h"
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <random>
+
+using namespace dictool;
+
+// Pairs where 90% of the keys hold 1-3 values and the rest 4-32
+static std::vector<std::pair<int, int>> make_pairs(int keys) {
+  std::mt19937 rng(42);
+  std::vector<std::pair<int, int>> pairs;
+  for (int k = 0; k < keys; ++k) {
+    int n = rng() % 10 != 0 ? 1 + rng() % 3 : 4 + rng() % 29;
+    for (int i = 0; i < n; ++i) {
+      pairs.emplace_back(k, static_cast<int>(rng() % 1000));
+    }
+  }
+  std::shuffle(pairs.begin(), pairs.end(), rng);
+  return pairs;
+}
+
+// Build through emplace; the footprint is in BM_SmallMemory
+template <template <typename...> class CTemplate,
+          template <typename...> class DTemplate>
+static void BM_SmallBuild(benchmark::State &state) {
+  auto pairs = make_pairs(state.range(0));
+  for (auto _ : state) {
+    MultiMap<int, int, CTemplate, DTemplate> mm;
+    for (const auto &[key, value] : pairs) {
+      mm.emplace(key, value);
+    }
+    benchmark::DoNotOptimize(mm);
+  }
+  state.SetItemsProcessed(state.iterations() * pairs.size());
+}
+
+// Sum all values, one group at a time
+template <template <typename...> class CTemplate,
+          template <typename...> class DTemplate>
+static void BM_SmallIterate(benchmark::State &state) {
+  auto pairs = make_pairs(state.range(0));
+  MultiMap<int, int, CTemplate, DTemplate> mm;
+  for (const auto &[key, value] : pairs) {
+    mm.emplace(key, value);
+  }
+  for (auto _ : state) {
+    long sum = 0;
+    mm.for_each_group([&](int, Span<const int> group) {
+      for (int value : group) {
+        sum += value;
+      }
+    });
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * pairs.size());
+}
+
+template <typename T> using StdVector = std::vector<T>;
+template <typename K, typename V> using StdMap = std::map<K, V>;
+
+#define SMALL_ARGS ArgName("keys")->Arg(10000)->Arg(200000)
+
+BENCHMARK_TEMPLATE(BM_SmallBuild, StdVector, StdMap)->SMALL_ARGS;
+BENCHMARK_TEMPLATE(BM_SmallBuild, small_vector, StdMap)->SMALL_ARGS;
+BENCHMARK_TEMPLATE(BM_SmallBuild, StdVector, flat_hash_map)->SMALL_ARGS;
+BENCHMARK_TEMPLATE(BM_SmallBuild, small_vector, flat_hash_map)->SMALL_ARGS;
+BENCHMARK_TEMPLATE(BM_SmallIterate, StdVector, StdMap)->SMALL_ARGS;
+BENCHMARK_TEMPLATE(BM_SmallIterate, small_vector, StdMap)->SMALL_ARGS;
+BENCHMARK_TEMPLATE(BM_SmallIterate, StdVector, flat_hash_map)->SMALL_ARGS;
+BENCHMARK_TEMPLATE(BM_SmallIterate, small_vector, flat_hash_map)->SMALL_ARGS;
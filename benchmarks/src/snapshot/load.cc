@@ -0,0 +1,74 @@
+#include "dictool/Snapshot.h"
+#include <benchmark/benchmark.h>
+#include <filesystem>
+#include <random>
+
+using namespace dictool;
+
+// 1M values over 100k keys
+static std::vector<std::pair<int, int>> make_pairs() {
+  std::mt19937 rng(42);
+  std::vector<std::pair<int, int>> pairs(1000000);
+  for (auto &[key, value] : pairs) {
+    key = static_cast<int>(rng() % 100000);
+    value = static_cast<int>(rng());
+  }
+  return pairs;
+}
+
+// Snapshot of make_pairs(), written once per process
+static const std::string &snapshot_path() {
+  static const std::string path = [] {
+    auto p = (std::filesystem::temp_directory_path() / "dictool_bench.snap")
+                 .string();
+    save_binary(MultiMap<int, int>::from_unsorted(make_pairs()), p);
+    return p;
+  }();
+  return path;
+}
+
+// Startup today: build the map from the source pairs
+static void BM_Rebuild(benchmark::State &state) {
+  auto pairs = make_pairs();
+  for (auto _ : state) {
+    auto mm = MultiMap<int, int>::from_unsorted(pairs);
+    benchmark::DoNotOptimize(mm.count(42));
+  }
+}
+
+// Startup from a snapshot, with or without the checksum pass
+static void BM_LoadMmap(benchmark::State &state) {
+  const auto &path = snapshot_path();
+  for (auto _ : state) {
+    auto mapped = load_mmap<int, int>(path, state.range(0) != 0);
+    benchmark::DoNotOptimize(mapped.count(42));
+  }
+}
+
+// Random lookups served from the mapping
+static void BM_MappedLookup(benchmark::State &state) {
+  auto mapped = load_mmap<int, int>(snapshot_path());
+  std::mt19937 rng(7);
+  std::vector<int> probes(4096);
+  for (int &p : probes) {
+    p = static_cast<int>(rng() % 200000);
+  }
+  for (auto _ : state) {
+    long sum = 0;
+    for (int key : probes) {
+      for (int value : mapped.view(key)) {
+        sum += value;
+      }
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * probes.size());
+}
+
+BENCHMARK(BM_Rebuild)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_LoadMmap)
+    ->ArgName("verify")
+    ->Arg(0)
+    ->Arg(1)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_MappedLookup);
@@ -0,0 +1,61 @@
+#include "dictool/VersionedMultiMap.h"
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <mutex>
+
+using namespace dictool;
+
+using Map = MultiMap<int, int>;
+
+static Map make_map() {
+  Map m;
+  for (int k = 0; k < 10000; ++k) {
+    m.emplace(k, k);
+    m.emplace(k, -k);
+  }
+  return m;
+}
+
+// shared_ptr swapped under a mutex, the setup VersionedMultiMap replaces
+struct LockedVersion {
+  std::mutex lock;
+  std::shared_ptr<const Map> current = std::make_shared<const Map>(make_map());
+
+  std::shared_ptr<const Map> pin() {
+    std::lock_guard<std::mutex> guard(lock);
+    return current;
+  }
+};
+
+static LockedVersion locked;
+static VersionedMultiMap<Map> versioned(make_map());
+
+// Pin, read the size and release, 1024 times per iteration. The lookup
+// is kept trivial so the cost of pinning itself shows
+static void BM_LockedRead(benchmark::State &state) {
+  for (auto _ : state) {
+    long sum = 0;
+    for (int i = 0; i < 1024; ++i) {
+      auto snap = locked.pin();
+      sum += snap->size();
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * 1024);
+}
+
+static void BM_VersionedRead(benchmark::State &state) {
+  auto reader = versioned.reader();
+  for (auto _ : state) {
+    long sum = 0;
+    for (int i = 0; i < 1024; ++i) {
+      auto snap = reader.pin();
+      sum += snap->size();
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * 1024);
+}
+
+BENCHMARK(BM_LockedRead)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_VersionedRead)->ThreadRange(1, 8)->UseRealTime();
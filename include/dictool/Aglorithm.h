@@ -1,12 +1,20 @@
 #pragma once
 
 #include "dictool/MultiDict.h"
+#include "dictool/ParallelMultiMapBuilder.h"
+#include <algorithm>
 #include <functional>
+#include <iterator>
+#include <thread>
+#include <utility>
+#include <vector>
 
 namespace dictool {
 /******************************************************************************
  * @brief   Reverse a map-like container by swapping keys and values.
- *          Each original value maps to a vector of keys that shared it.
+ *          Each original value maps to a vector of keys that shared it,
+ *          in the input's iteration order. The result is moved out of the
+ *          MultiMap it is built in, not copied.
  *
  * @tparam  K           Type of the keys in the input map
  * @tparam  V           Type of the values in the input map
@@ -28,7 +36,137 @@ DictLike<V, std::vector<K>> reverse(const DictLike<K, V> &inputs) {
   for (const auto &[key, value] : inputs) {
     res.emplace(value, key);
   }
-  return res.cdata();
+  return res.release();
+}
+
+/******************************************************************************
+ * @brief   Reverse a map-like container like reverse(), in two passes so
+ *          that each key vector is allocated exactly once: the first pass
+ *          counts the keys of each distinct value, the second fills
+ *          vectors reserved to those counts. Worth it when values are
+ *          shared by many keys, where growing vectors reallocates often.
+ *
+ * @tparam  K           Type of the keys in the input map
+ * @tparam  V           Type of the values in the input map
+ * @tparam  DictLike   Map-like associative container template
+ *                      (defaults to std::map)
+ *
+ * @param   inputs      Input map-like container (mapping keys to values)
+ *
+ * @return  DictLike<V, std::vector<K>>  Same result as reverse()
+ ******************************************************************************/
+template <typename K, typename V,
+          template <typename...> class DictLike = std::map>
+DictLike<V, std::vector<K>> reverse_counted(const DictLike<K, V> &inputs) {
+  // Pass 1: number the distinct values and count their keys
+  DictLike<V, size_t> slot_of;
+  std::vector<size_t> counts;
+  std::vector<size_t> entry_slot;
+  entry_slot.reserve(inputs.size());
+  for (const auto &[key, value] : inputs) {
+    auto [it, inserted] = slot_of.try_emplace(value, counts.size());
+    if (inserted) {
+      counts.push_back(0);
+    }
+    ++counts[it->second];
+    entry_slot.push_back(it->second);
+  }
+
+  // One node and one exactly-sized vector per distinct value. Reserving
+  // up front keeps flat dictionaries from moving the vectors pointed to
+  DictLike<V, std::vector<K>> res;
+  if constexpr (has_reserve<DictLike<V, std::vector<K>>>()) {
+    res.reserve(slot_of.size());
+  }
+  std::vector<std::vector<K> *> targets(counts.size());
+  for (const auto &[value, slot] : slot_of) {
+    auto &keys = res.try_emplace(res.end(), value)->second;
+    keys.reserve(counts[slot]);
+    targets[slot] = &keys;
+  }
+
+  // Pass 2: fill the vectors in input order
+  size_t i = 0;
+  for (const auto &entry : inputs) {
+    targets[entry_slot[i++]]->push_back(entry.first);
+  }
+  return res;
+}
+
+/******************************************************************************
+ * @brief   Reverse a map-like container like reverse(), on several
+ *          threads. The input is cut into one contiguous range per
+ *          thread; each thread appends its (value, key) pairs to a
+ *          ParallelMultiMapBuilder worker, which partitions them by value
+ *          hash, and the partitions are then bulk-loaded in parallel, each
+ *          key vector allocated once. Keys of a value keep the input's
+ *          iteration order.
+ *
+ * @tparam  K           Type of the keys in the input map
+ * @tparam  V           Type of the values in the input map, hashable
+ *                      with std::hash
+ * @tparam  DictLike   Map-like associative container template
+ *                      (defaults to std::map)
+ *
+ * @param   inputs      Input map-like container (mapping keys to values)
+ * @param   threads     Number of threads; 0 uses all hardware threads
+ *
+ * @return  DictLike<V, std::vector<K>>  Same result as reverse()
+ ******************************************************************************/
+template <typename K, typename V,
+          template <typename...> class DictLike = std::map>
+DictLike<V, std::vector<K>> reverse_parallel(const DictLike<K, V> &inputs,
+                                             size_t threads = 0) {
+  if (threads == 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  threads = std::max<size_t>(1, std::min(threads, inputs.size()));
+
+  // Range boundaries, found in one walk for non-random-access iterators
+  using Iter = typename DictLike<K, V>::const_iterator;
+  std::vector<Iter> cuts{inputs.begin()};
+  for (size_t i = 1; i < threads; ++i) {
+    cuts.push_back(std::next(cuts.back(), inputs.size() / threads));
+  }
+  cuts.push_back(inputs.end());
+
+  ParallelMultiMapBuilder<V, K, std::vector, DictLike> builder(threads);
+  builder.run([&](size_t i, auto &worker) {
+    for (auto it = cuts[i]; it != cuts[i + 1]; ++it) {
+      worker.emplace(it->second, it->first);
+    }
+  });
+  return builder.finish().release();
+}
+
+/******************************************************************************
+ * @brief   Invert a many-to-many MultiMap: every (key, value) pair becomes
+ *          (value, key). Keys of a value keep the input's iteration order.
+ *          All pairs are gathered first and bulk-loaded, so each value
+ *          container is allocated once.
+ *
+ * @tparam  K           Key type of the input
+ * @tparam  V           Value type of the input
+ *
+ * @param   mm          MultiMap to invert
+ *
+ * @return  MultiMap<V, K, CTemplate, DTemplate>  The inverted map, with
+ *          the input's container and dictionary templates
+ ******************************************************************************/
+template <typename K, typename V, template <typename...> class CTemplate,
+          template <typename...> class DTemplate, typename Stats>
+MultiMap<V, K, CTemplate, DTemplate>
+reverse(const MultiMap<K, V, CTemplate, DTemplate, Stats> &mm) {
+  std::vector<std::pair<V, K>> pairs;
+  pairs.reserve(mm.size());
+  for (const auto &[key, container] : mm.cdata()) {
+    for (const auto &value : container) {
+      pairs.emplace_back(value, key);
+    }
+  }
+  MultiMap<V, K, CTemplate, DTemplate> res;
+  res.bulk_load(std::move(pairs));
+  return res;
 }
 
 /******************************************************************************
@@ -0,0 +1,404 @@
+#pragma once
+
+#include "dictool/MultiDict.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace dictool {
+
+/**
+ * @brief Thread-safe multimap made of independently locked MultiMap shards.
+ *
+ * Keys are hash-partitioned across a fixed number of shards, each guarded
+ * by its own reader/writer lock, so writers to different shards proceed in
+ * parallel and readers of one shard share its lock. All values of a key
+ * live in the same shard.
+ *
+ * No iterator or reference into a shard ever escapes a lock: lookups
+ * either copy the values out (find_copy) or run a callback while the
+ * shard is locked (visit). A callback must not call back into the same
+ * map.
+ *
+ * @tparam K Key type.
+ * @tparam V Value type.
+ * @tparam CTemplate Container template for storing values (default:
+ * std::vector).
+ * @tparam DTemplate Dictionary template of each shard (default: std::map).
+ * @tparam Hash Hash function used to pick a key's shard (default:
+ * std::hash<K>).
+ * @tparam Stats Instrumentation policy of each shard (default: NoStats);
+ * see counters().
+ */
+template <typename K, typename V,
+          template <typename...> class CTemplate = std::vector,
+          template <typename...> class DTemplate = std::map,
+          typename Hash = std::hash<K>, typename Stats = NoStats>
+class ConcurrentMultiMap {
+public:
+  using map_type =
+      MultiMap<K, V, CTemplate, DTemplate, Stats>; /**< Shard type */
+  using key_type = K;                              /**< Type of keys */
+  using mapped_type = V;                           /**< Type of values */
+  using value_type = std::pair<const K, V>; /**< Type of key-value pairs */
+  using size_type = size_t;                 /**< Size type */
+  using hasher = Hash;                      /**< Shard hash function */
+  using container_type = CTemplate<V>;      /**< Container of a key's values */
+  using view_type = typename map_type::view_type; /**< View of a key's values */
+
+private:
+  /**
+   * @brief One partition of the keys. Aligned to its own cache lines so
+   * that locking one shard does not contend with its neighbours.
+   */
+  struct alignas(64) Shard {
+    mutable std::shared_mutex lock; /**< Guards map */
+    map_type map;                   /**< Keys hashed to this shard */
+  };
+
+  std::unique_ptr<Shard[]> shards; /**< The shards */
+  size_type shard_total;           /**< Number of shards */
+  Hash hash;                       /**< Shard hash function */
+
+  using ReadLock = std::shared_lock<std::shared_mutex>;
+  using WriteLock = std::unique_lock<std::shared_mutex>;
+
+public:
+  /**
+   * @brief Default shard count: four shards per hardware thread, so that
+   * writers rarely meet on the same shard.
+   *
+   * @return size_type Number of shards.
+   */
+  static size_type default_shard_count() {
+    size_type threads = std::thread::hardware_concurrency();
+    return 4 * (threads == 0 ? 1 : threads);
+  }
+
+  /**
+   * @brief Construct an empty map.
+   *
+   * @param shard_count Number of shards (at least 1).
+   * @param hash Shard hash function.
+   */
+  explicit ConcurrentMultiMap(size_type shard_count = default_shard_count(),
+                              const Hash &hash = Hash())
+      : shards(new Shard[shard_count == 0 ? 1 : shard_count]),
+        shard_total(shard_count == 0 ? 1 : shard_count), hash(hash) {}
+
+  ConcurrentMultiMap(const ConcurrentMultiMap &) = delete;
+  ConcurrentMultiMap &operator=(const ConcurrentMultiMap &) = delete;
+
+  // Modifiers
+
+  /**
+   * @brief Append a value built from args under key.
+   *
+   * @param key Key to append to.
+   * @param args Arguments to forward to the value constructor.
+   */
+  template <typename KArg, typename... Args>
+  void emplace(KArg &&key, Args &&...args) {
+    Shard &shard = shard_for(key);
+    WriteLock guard(shard.lock);
+    shard.map.try_emplace(std::forward<KArg>(key),
+                          std::forward<Args>(args)...);
+  }
+
+  /**
+   * @brief Insert a key-value pair.
+   *
+   * @param value Pair to insert.
+   */
+  void insert(const value_type &value) { emplace(value.first, value.second); }
+
+  /**
+   * @brief Insert a range of key-value pairs.
+   *
+   * The pairs are partitioned by shard first, so each shard is locked once
+   * per call rather than once per pair.
+   *
+   * @param first Beginning of the range.
+   * @param last End of the range.
+   */
+  template <typename InputIt> void insert(InputIt first, InputIt last) {
+    std::vector<std::vector<std::pair<K, V>>> parts(shard_total);
+    for (; first != last; ++first) {
+      auto &&[key, value] = *first;
+      parts[shard_index(key)].emplace_back(key, value);
+    }
+    for (size_type i = 0; i < shard_total; ++i) {
+      if (parts[i].empty()) {
+        continue;
+      }
+      WriteLock guard(shards[i].lock);
+      for (auto &[key, value] : parts[i]) {
+        shards[i].map.try_emplace(std::move(key), std::move(value));
+      }
+    }
+  }
+
+  /**
+   * @brief Erase all values of a key.
+   *
+   * @param key Key to erase.
+   * @return size_type Number of values erased.
+   */
+  size_type erase(const K &key) {
+    Shard &shard = shard_for(key);
+    WriteLock guard(shard.lock);
+    return shard.map.erase(key);
+  }
+
+  /**
+   * @brief Erase one occurrence of a value from a key.
+   *
+   * @param key Key to erase from.
+   * @param value Value to erase.
+   * @return true if value was erased, false otherwise.
+   */
+  bool erase(const K &key, const V &value) {
+    Shard &shard = shard_for(key);
+    WriteLock guard(shard.lock);
+    return shard.map.erase(key, value);
+  }
+
+  /**
+   * @brief Add the values of a MultiMap.
+   *
+   * @param other MultiMap to copy from.
+   */
+  void merge(const map_type &other) { merge(map_type(other)); }
+
+  /**
+   * @brief Move the values of a MultiMap in, leaving it empty.
+   *
+   * other's dictionary is split into one dictionary per shard without
+   * holding any lock, one key at a time: nodes are extracted and
+   * reinserted when the dictionary has node handles, otherwise each whole
+   * container is moved. Each part is then merged into its shard with
+   * MultiMap::merge(MultiMap &&) under a single lock.
+   *
+   * @param other MultiMap to consume.
+   */
+  void merge(map_type &&other) {
+    using Dict = typename map_type::dictionary_type;
+    Dict source = other.release();
+    std::vector<Dict> parts;
+    parts.reserve(shard_total);
+    for (size_type i = 0; i < shard_total; ++i) {
+      // Same allocator as source, so its nodes may move between them
+      if constexpr (HasAllocator<Dict>::value) {
+        parts.emplace_back(source.get_allocator());
+      } else {
+        parts.emplace_back();
+      }
+    }
+    if constexpr (HasNodeType<Dict>::value) {
+      for (auto it = source.begin(); it != source.end();) {
+        Dict &part = parts[shard_index(it->first)];
+        part.insert(part.end(), source.extract(it++));
+      }
+    } else {
+      for (auto &[key, container] : source) {
+        parts[shard_index(key)].try_emplace(key, std::move(container));
+      }
+    }
+
+    for (size_type i = 0; i < shard_total; ++i) {
+      if (parts[i].empty()) {
+        continue;
+      }
+      map_type part(std::move(parts[i]));
+      WriteLock guard(shards[i].lock);
+      shards[i].map.merge(std::move(part));
+    }
+  }
+
+  /**
+   * @brief Erase everything, one shard at a time.
+   */
+  void clear() {
+    for (size_type i = 0; i < shard_total; ++i) {
+      WriteLock guard(shards[i].lock);
+      shards[i].map.clear();
+    }
+  }
+
+  // Lookup methods
+
+  /**
+   * @brief Copy out the values of a key.
+   *
+   * @param key Key to look up.
+   * @return container_type Copy of the key's values, empty if absent.
+   */
+  [[nodiscard]] container_type find_copy(const K &key) const {
+    const Shard &shard = shard_for(key);
+    ReadLock guard(shard.lock);
+    return shard.map.get(key);
+  }
+
+  /**
+   * @brief Call f(view) on the values of a key while its shard is
+   * read-locked.
+   *
+   * The view is only valid inside f. Writers to the same shard wait until
+   * f returns, so keep f short.
+   *
+   * @tparam F Callable taking view_type.
+   * @param key Key to look up.
+   * @param f Function to call with the key's values.
+   * @return true if the key exists and f was called, false otherwise.
+   */
+  template <typename F> bool visit(const K &key, F &&f) const {
+    const Shard &shard = shard_for(key);
+    ReadLock guard(shard.lock);
+    auto view = shard.map.find_view(key);
+    if (!view) {
+      return false;
+    }
+    f(*view);
+    return true;
+  }
+
+  /**
+   * @brief Count the values of a key.
+   *
+   * @param key Key to count.
+   * @return size_type Number of values of the key.
+   */
+  size_type count(const K &key) const {
+    const Shard &shard = shard_for(key);
+    ReadLock guard(shard.lock);
+    return shard.map.count(key);
+  }
+
+  bool contains(const K &key) const {
+    const Shard &shard = shard_for(key);
+    ReadLock guard(shard.lock);
+    return shard.map.contains(key);
+  }
+
+  // Whole-map methods
+
+  /**
+   * @brief Copy everything into a plain MultiMap.
+   *
+   * All shards are read-locked together while copying, so the result is a
+   * consistent point-in-time state even while writers are active. Writers
+   * only ever hold one shard lock, which keeps this deadlock-free.
+   *
+   * @return map_type Copy of all key-value pairs.
+   */
+  [[nodiscard]] map_type snapshot() const {
+    std::vector<ReadLock> guards;
+    guards.reserve(shard_total);
+    for (size_type i = 0; i < shard_total; ++i) {
+      guards.emplace_back(shards[i].lock);
+    }
+    map_type result;
+    for (size_type i = 0; i < shard_total; ++i) {
+      result.merge(shards[i].map);
+    }
+    return result;
+  }
+
+  /**
+   * @brief Get the total number of values. Shards are counted one at a
+   * time, so concurrent writes may or may not be included.
+   *
+   * @return size_type Number of values.
+   */
+  [[nodiscard]] size_type size() const {
+    size_type total = 0;
+    for (size_type i = 0; i < shard_total; ++i) {
+      ReadLock guard(shards[i].lock);
+      total += shards[i].map.size();
+    }
+    return total;
+  }
+
+  /**
+   * @brief Get the total number of keys, counted like size().
+   *
+   * @return size_type Number of keys.
+   */
+  [[nodiscard]] size_type key_count() const {
+    size_type total = 0;
+    for (size_type i = 0; i < shard_total; ++i) {
+      ReadLock guard(shards[i].lock);
+      total += shards[i].map.key_count();
+    }
+    return total;
+  }
+
+  [[nodiscard]] bool empty() const { return size() == 0; }
+
+  /**
+   * @brief Get the operation counts of all shards added up, read like
+   * size(). Readers sharing a shard lock may lose increments, see
+   * CountingStats.
+   *
+   * @return OperationCounts Counts so far, all zero with NoStats.
+   */
+  [[nodiscard]] OperationCounts counters() const {
+    OperationCounts total;
+    for (size_type i = 0; i < shard_total; ++i) {
+      ReadLock guard(shards[i].lock);
+      total += shards[i].map.counters();
+    }
+    return total;
+  }
+
+  /**
+   * @brief Estimate the bytes this map occupies: the shard array, with
+   * its locks and cache-line padding as structure, plus each shard's
+   * MultiMap::memory_usage(). Shards are measured one at a time under
+   * their read lock, like size().
+   *
+   * @return MemoryUsage The breakdown.
+   */
+  [[nodiscard]] MemoryUsage memory_usage() const {
+    MemoryUsage usage;
+    usage.object = sizeof(*this);
+    usage.structure += shard_total * (sizeof(Shard) - sizeof(map_type));
+    usage.add_block(shard_total * sizeof(Shard));
+    for (size_type i = 0; i < shard_total; ++i) {
+      ReadLock guard(shards[i].lock);
+      usage += shards[i].map.memory_usage();
+    }
+    return usage;
+  }
+
+  /**
+   * @brief Get the number of shards.
+   *
+   * @return size_type Number of shards.
+   */
+  [[nodiscard]] size_type shard_count() const { return shard_total; }
+
+  hasher hash_function() const { return hash; }
+
+private:
+  /**
+   * @brief Shard of a key. The hash is mixed with a multiplicative
+   * constant first, since std::hash is the identity for integers.
+   */
+  size_type shard_index(const K &key) const {
+    uint64_t h = static_cast<uint64_t>(hash(key)) * 0x9e3779b97f4a7c15ull;
+    return static_cast<size_type>((h >> 32) % shard_total);
+  }
+
+  Shard &shard_for(const K &key) { return shards[shard_index(key)]; }
+  const Shard &shard_for(const K &key) const {
+    return shards[shard_index(key)];
+  }
+};
+
+} // namespace dictool
@@ -0,0 +1,338 @@
+#pragma once
+
+#include "dictool/MappedFile.h"
+#include "dictool/MultiDict.h"
+#include "dictool/ParallelMultiMapBuilder.h"
+#include "dictool/Traits.h"
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DICTOOL_HAVE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace dictool {
+
+/**
+ * @brief Parser of one text field into a T. Defined for arithmetic types
+ * (std::from_chars) and std::string; specialize it to load other types.
+ *
+ * @tparam T The key or value type.
+ * @tparam void SFINAE parameter.
+ */
+template <typename T, typename = void> struct FieldParser;
+
+template <typename T>
+struct FieldParser<T, std::enable_if_t<std::is_arithmetic_v<T> &&
+                                       !std::is_same_v<T, bool>>> {
+  /**
+   * @brief Parse the whole field.
+   *
+   * @param field Text of the field.
+   * @param out Parsed value.
+   * @return true if field is exactly one number that fits in T. A
+   * leading '+' is accepted, but not one followed by a sign.
+   */
+  static bool parse(std::string_view field, T &out) {
+    const char *first = field.data();
+    const char *last = first + field.size();
+    if (first != last && *first == '+') {
+      if (++first != last && *first == '-') {
+        return false;
+      }
+    }
+    auto [ptr, ec] = std::from_chars(first, last, out);
+    return ec == std::errc() && ptr == last;
+  }
+};
+
+template <> struct FieldParser<std::string> {
+  static bool parse(std::string_view field, std::string &out) {
+    out.assign(field.data(), field.size());
+    return true;
+  }
+};
+
+/**
+ * @brief Options of load_delimited.
+ */
+struct DelimitedOptions {
+  char delimiter = '\t';          /**< Separates the key from the value */
+  size_t chunk_size = 1u << 16;   /**< Pairs per bulk_load call */
+  size_t threads = 1;             /**< Parsing threads; 0 for all cores */
+  size_t min_parallel = 1u << 22; /**< Smaller files are parsed serially */
+};
+
+namespace detail {
+
+#ifdef DICTOOL_HAVE_SSE2
+inline uint32_t lowest_bit(uint32_t mask) {
+#ifdef _MSC_VER
+  unsigned long index;
+  _BitScanForward(&index, mask);
+  return static_cast<uint32_t>(index);
+#else
+  return static_cast<uint32_t>(__builtin_ctz(mask));
+#endif
+}
+#endif
+
+/**
+ * @brief First byte in [p, end) equal to a or b, or end. Compares 16
+ * bytes at a time with SSE2 when available.
+ */
+inline const char *find_either(const char *p, const char *end, char a,
+                               char b) {
+#ifdef DICTOOL_HAVE_SSE2
+  const __m128i va = _mm_set1_epi8(a);
+  const __m128i vb = _mm_set1_epi8(b);
+  for (; end - p >= 16; p += 16) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    __m128i hits =
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, va), _mm_cmpeq_epi8(chunk, vb));
+    auto mask = static_cast<uint32_t>(_mm_movemask_epi8(hits));
+    if (mask != 0) {
+      return p + lowest_bit(mask);
+    }
+  }
+#endif
+  for (; p != end; ++p) {
+    if (*p == a || *p == b) {
+      return p;
+    }
+  }
+  return end;
+}
+
+/** First newline in [p, end), or end; memchr is vectorized by libc */
+inline const char *find_newline(const char *p, const char *end) {
+  const void *hit = std::memchr(p, '\n', static_cast<size_t>(end - p));
+  return hit != nullptr ? static_cast<const char *>(hit) : end;
+}
+
+/** Line number of position p in the text starting at base */
+inline size_t line_number(const char *base, const char *p) {
+  size_t line = 1;
+  for (const char *q = base; (q = find_newline(q, p)) != p; ++q) {
+    ++line;
+  }
+  return line;
+}
+
+/**
+ * @brief Parse the lines in [first, last) and hand each (key, value) to
+ * sink. An empty line (or a lone "\r") is skipped. Any other line needs a
+ * delimiter: the key is the text before the first one and the value the
+ * rest of the line, minus a trailing "\r".
+ *
+ * @param base Start of the whole text, for error line numbers.
+ * @throws std::runtime_error on a line without delimiter or a field that
+ * does not parse.
+ */
+template <typename K, typename V, typename Sink>
+void parse_lines(const char *base, const char *first, const char *last,
+                 const std::string &path, char delimiter, Sink &&sink) {
+  auto fail = [&](const char *where, const char *what) {
+    throw std::runtime_error("load_delimited: " + std::string(what) +
+                             " on line " +
+                             std::to_string(line_number(base, where)) +
+                             " of " + path);
+  };
+
+  const char *p = first;
+  while (p != last) {
+    const char *cut = find_either(p, last, delimiter, '\n');
+    if (cut == last || *cut == '\n') {
+      const char *eol = cut;
+      if (eol != p && !(eol - p == 1 && *p == '\r')) {
+        fail(p, "missing delimiter");
+      }
+      p = eol == last ? last : eol + 1;
+      continue;
+    }
+    const char *eol = find_newline(cut + 1, last);
+    const char *value_end = eol;
+    if (value_end != cut + 1 && value_end[-1] == '\r') {
+      --value_end;
+    }
+
+    std::string_view key_field(p, static_cast<size_t>(cut - p));
+    std::string_view value_field(cut + 1,
+                                 static_cast<size_t>(value_end - cut - 1));
+    K key;
+    V value;
+    if (!FieldParser<K>::parse(key_field, key)) {
+      fail(p, "bad key");
+    }
+    if (!FieldParser<V>::parse(value_field, value)) {
+      fail(p, "bad value");
+    }
+    sink(std::move(key), std::move(value));
+    p = eol == last ? last : eol + 1;
+  }
+}
+
+} // namespace detail
+
+namespace detail {
+
+/** Parse [base, end) on this thread, bulk loading chunks into mm */
+template <typename K, typename V, template <typename...> class CTemplate,
+          template <typename...> class DTemplate, typename Stats>
+size_t load_delimited_serial(const char *base, const char *end,
+                             const std::string &path,
+                             MultiMap<K, V, CTemplate, DTemplate, Stats> &mm,
+                             const DelimitedOptions &options) {
+  size_t chunk_size = options.chunk_size == 0 ? 1 : options.chunk_size;
+  std::vector<std::pair<K, V>> chunk;
+  chunk.reserve(chunk_size);
+  size_t loaded = 0;
+  parse_lines<K, V>(base, base, end, path, options.delimiter,
+                    [&](K &&key, V &&value) {
+                      chunk.emplace_back(std::move(key), std::move(value));
+                      if (chunk.size() == chunk_size) {
+                        loaded += chunk.size();
+                        mm.bulk_load(std::move(chunk));
+                        chunk.clear();
+                        chunk.reserve(chunk_size);
+                      }
+                    });
+  loaded += chunk.size();
+  mm.bulk_load(std::move(chunk));
+  return loaded;
+}
+
+/**
+ * @brief Parse [base, end) on threads threads through a
+ * ParallelMultiMapBuilder and merge the result into mm. Needs std::hash<K>
+ * to partition the keys.
+ */
+template <typename K, typename V, template <typename...> class CTemplate,
+          template <typename...> class DTemplate, typename Stats>
+size_t load_delimited_parallel(const char *base, const char *end,
+                               const std::string &path,
+                               MultiMap<K, V, CTemplate, DTemplate, Stats> &mm,
+                               const DelimitedOptions &options,
+                               size_t threads) {
+  // Cut the file into line-aligned ranges, one per thread
+  auto size = static_cast<size_t>(end - base);
+  std::vector<const char *> cuts{base};
+  for (size_t i = 1; i < threads; ++i) {
+    const char *guess = base + size / threads * i;
+    const char *cut = std::max(guess, cuts.back());
+    cut = find_newline(cut, end);
+    cuts.push_back(cut == end ? end : cut + 1);
+  }
+  cuts.push_back(end);
+
+  ParallelMultiMapBuilder<K, V, CTemplate, DTemplate, std::hash<K>, Stats>
+      builder(threads);
+  std::vector<std::exception_ptr> errors(threads);
+  builder.run([&](size_t i, auto &worker) {
+    try {
+      parse_lines<K, V>(base, cuts[i], cuts[i + 1], path, options.delimiter,
+                        [&](K &&key, V &&value) {
+                          worker.emplace(std::move(key), std::move(value));
+                        });
+    } catch (...) {
+      errors[i] = std::current_exception();
+    }
+  });
+  for (auto &error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+  auto loaded = builder.finish();
+  size_t count = loaded.size();
+  mm.merge(std::move(loaded));
+  return count;
+}
+
+} // namespace detail
+
+/**
+ * @brief Append the pairs of a delimited text file to a MultiMap.
+ *
+ * The file is memory-mapped and each line holds one pair: the key, the
+ * delimiter, and the value up to the end of the line (LF or CRLF). Line
+ * boundaries and delimiters are found with a 16-byte SSE2 scan, numeric
+ * fields are parsed with std::from_chars, and parsed pairs are handed to
+ * MultiMap::bulk_load in chunks of options.chunk_size, so memory stays
+ * bounded and no line is copied.
+ *
+ * With options.threads != 1 and a file of at least options.min_parallel
+ * bytes, the file is split into one line-aligned range per thread, each
+ * thread parses its range into a ParallelMultiMapBuilder worker, and the
+ * result is merged into mm. Values of a key keep their file order either
+ * way. Keys without a std::hash specialization are always parsed on the
+ * calling thread.
+ *
+ * @param path File to load.
+ * @param mm MultiMap to append to.
+ * @param options Delimiter, chunking and threading options.
+ * @return size_t Number of pairs loaded.
+ * @throws std::runtime_error if the file cannot be read or a line is
+ * malformed; mm is then left with the pairs of the chunks loaded so far.
+ */
+template <typename K, typename V, template <typename...> class CTemplate,
+          template <typename...> class DTemplate, typename Stats>
+size_t load_delimited(const std::string &path,
+                      MultiMap<K, V, CTemplate, DTemplate, Stats> &mm,
+                      const DelimitedOptions &options = {}) {
+  MappedFile file(path);
+  if (file.size() == 0) {
+    return 0;
+  }
+  file.advise_sequential();
+  const char *base = file.data();
+  const char *end = base + file.size();
+
+  if constexpr (IsHashable<K>::value) {
+    size_t threads = options.threads;
+    if (threads == 0) {
+      threads = std::thread::hardware_concurrency();
+    }
+    if (threads > 1 && file.size() >= options.min_parallel) {
+      return detail::load_delimited_parallel(base, end, path, mm, options,
+                                             threads);
+    }
+  }
+  return detail::load_delimited_serial(base, end, path, mm, options);
+}
+
+/**
+ * @brief Load a delimited text file into a new MultiMap, see the
+ * overload appending to an existing one.
+ *
+ * @tparam Map MultiMap type to build.
+ * @param path File to load.
+ * @param options Delimiter, chunking and threading options.
+ * @return Map The loaded map.
+ */
+template <typename Map>
+Map load_delimited(const std::string &path,
+                   const DelimitedOptions &options = {}) {
+  Map mm;
+  load_delimited(path, mm, options);
+  return mm;
+}
+
+} // namespace dictool
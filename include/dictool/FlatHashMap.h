@@ -0,0 +1,949 @@
+#pragma once
+
+#include "dictool/MemoryUsage.h"
+#include "dictool/Traits.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DICTOOL_HAVE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace dictool {
+
+namespace detail {
+
+/**
+ * @brief Control byte of a flat_hash_map slot.
+ *
+ * Full slots hold the low 7 bits of the key's hash (0..127). The special
+ * values are negative so that a single signed comparison separates them.
+ */
+using ctrl_t = int8_t;
+
+constexpr ctrl_t kEmpty = -128;  /**< Never used since the last rehash */
+constexpr ctrl_t kDeleted = -2;  /**< Erased, a probe must continue past it */
+constexpr ctrl_t kSentinel = -1; /**< End of the table, stops iteration */
+
+inline uint32_t count_trailing_zeros(uint32_t x) {
+#ifdef _MSC_VER
+  unsigned long index;
+  _BitScanForward(&index, x);
+  return index;
+#else
+  return static_cast<uint32_t>(__builtin_ctz(x));
+#endif
+}
+
+inline uint32_t count_leading_zeros16(uint32_t x) {
+#ifdef _MSC_VER
+  unsigned long index;
+  _BitScanReverse(&index, x);
+  return 15 - index;
+#else
+  return static_cast<uint32_t>(__builtin_clz(x)) - 16;
+#endif
+}
+
+/**
+ * @brief A group of 16 control bytes probed at once.
+ *
+ * Each match returns a bitmask with bit i set when byte i matches. Uses
+ * SSE2 when available and a byte loop otherwise.
+ */
+class Group {
+public:
+  static constexpr size_t width = 16; /**< Control bytes per group */
+
+#ifdef DICTOOL_HAVE_SSE2
+  explicit Group(const ctrl_t *pos)
+      : ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i *>(pos))) {}
+
+  uint32_t match(ctrl_t h2) const {
+    return static_cast<uint32_t>(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl)));
+  }
+
+  uint32_t match_empty_or_deleted() const {
+    return static_cast<uint32_t>(
+        _mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(kSentinel), ctrl)));
+  }
+
+private:
+  __m128i ctrl; /**< Loaded control bytes */
+#else
+  explicit Group(const ctrl_t *pos) { std::memcpy(ctrl, pos, width); }
+
+  uint32_t match(ctrl_t h2) const {
+    uint32_t mask = 0;
+    for (size_t i = 0; i < width; ++i) {
+      mask |= static_cast<uint32_t>(ctrl[i] == h2) << i;
+    }
+    return mask;
+  }
+
+  uint32_t match_empty_or_deleted() const {
+    uint32_t mask = 0;
+    for (size_t i = 0; i < width; ++i) {
+      mask |= static_cast<uint32_t>(ctrl[i] < kSentinel) << i;
+    }
+    return mask;
+  }
+
+private:
+  ctrl_t ctrl[width]; /**< Copied control bytes */
+#endif
+
+public:
+  uint32_t match_empty() const { return match(kEmpty); }
+};
+
+/**
+ * @brief Control bytes of an empty table: a sentinel so that begin() ==
+ * end(), followed by empty bytes so that a group load stays in bounds.
+ */
+alignas(16) inline constexpr ctrl_t kEmptyGroup[Group::width] = {
+    kSentinel, kEmpty, kEmpty, kEmpty, kEmpty, kEmpty, kEmpty, kEmpty,
+    kEmpty,    kEmpty, kEmpty, kEmpty, kEmpty, kEmpty, kEmpty, kEmpty};
+
+} // namespace detail
+
+/**
+ * @brief Open-addressing hash map with SIMD-probed control bytes, in the
+ * style of a Swiss table.
+ *
+ * Elements live directly in one array of slots, next to an array of control
+ * bytes holding 7 bits of each element's hash. A lookup loads 16 control
+ * bytes at a time and only compares keys whose hash bits match, so most
+ * probes touch one cache line of metadata and one slot. Capacity is always
+ * 2^n - 1 and the table grows at a 7/8 load factor.
+ *
+ * The interface follows std::unordered_map so it can serve as the
+ * DTemplate of MultiMap. Unlike std::unordered_map, references and
+ * iterators are invalidated by any insertion that grows the table, and
+ * there are no node handles.
+ *
+ * @tparam K Key type.
+ * @tparam V Mapped type.
+ * @tparam Hash Hash function (default: std::hash<K>).
+ * @tparam Eq Key equality (default: std::equal_to<K>).
+ */
+template <typename K, typename V, typename Hash = std::hash<K>,
+          typename Eq = std::equal_to<K>>
+class flat_hash_map {
+public:
+  using key_type = K;                       /**< Type of keys */
+  using mapped_type = V;                    /**< Type of mapped values */
+  using value_type = std::pair<const K, V>; /**< Type of stored elements */
+  using size_type = size_t;                 /**< Size type */
+  using difference_type = ptrdiff_t;        /**< Difference type */
+  using hasher = Hash;                      /**< Hash function type */
+  using key_equal = Eq;                     /**< Key equality type */
+  using reference = value_type &;
+  using const_reference = const value_type &;
+
+private:
+  using ctrl_t = detail::ctrl_t;
+  using Group = detail::Group;
+
+  /**
+   * @brief Uninitialized storage for one element.
+   */
+  union Slot {
+    Slot() {}
+    ~Slot() {}
+    value_type value; /**< Element, alive only when the slot is full */
+  };
+
+  ctrl_t *ctrl = const_cast<ctrl_t *>(detail::kEmptyGroup); /**< Control */
+  Slot *slots = nullptr;     /**< Element storage, capacity entries */
+  size_type capacity = 0;    /**< Number of slots, 0 or 2^n - 1 */
+  size_type elements = 0;    /**< Number of full slots */
+  size_type growth_left = 0; /**< Insertions into empty slots before growth */
+  Hash hash;                 /**< Hash function */
+  Eq eq;                     /**< Key equality */
+
+  friend struct DictionaryUsage<flat_hash_map>;
+
+  static constexpr size_type min_capacity = Group::width - 1;
+
+  template <typename KL>
+  using EnableTransparent =
+      std::enable_if_t<!std::is_same_v<std::decay_t<KL>, K> &&
+                       IsTransparent<Hash>::value && IsTransparent<Eq>::value>;
+
+public:
+  /**
+   * @brief Forward iterator over the full slots.
+   *
+   * @tparam Const Whether the iterator gives read-only access.
+   */
+  template <bool Const> class BasicIterator {
+  private:
+    friend class flat_hash_map;
+    friend BasicIterator<!Const>;
+
+    const ctrl_t *ctrl = nullptr; /**< Control byte of the current slot */
+    Slot *slot = nullptr;         /**< Current slot */
+
+    BasicIterator(const ctrl_t *ctrl, Slot *slot) : ctrl(ctrl), slot(slot) {}
+
+    /**
+     * @brief Advance to the next full slot or the sentinel.
+     */
+    void skip_empty_or_deleted() {
+      while (*ctrl < detail::kSentinel) {
+        uint32_t shift =
+            detail::count_trailing_zeros(~Group(ctrl).match_empty_or_deleted());
+        ctrl += shift;
+        slot += shift;
+      }
+    }
+
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = typename flat_hash_map::value_type;
+    using difference_type = ptrdiff_t;
+    using reference =
+        std::conditional_t<Const, const value_type &, value_type &>;
+    using pointer = std::conditional_t<Const, const value_type *, value_type *>;
+
+    BasicIterator() = default;
+
+    /**
+     * @brief Convert a mutable iterator into a const one.
+     */
+    template <bool C = Const, typename = std::enable_if_t<C>>
+    BasicIterator(const BasicIterator<false> &other)
+        : ctrl(other.ctrl), slot(other.slot) {}
+
+    reference operator*() const { return slot->value; }
+    pointer operator->() const { return &slot->value; }
+
+    BasicIterator &operator++() {
+      ++ctrl;
+      ++slot;
+      skip_empty_or_deleted();
+      return *this;
+    }
+
+    BasicIterator operator++(int) {
+      BasicIterator tmp = *this;
+      ++(*this);
+      return tmp;
+    }
+
+    template <bool C> bool operator==(const BasicIterator<C> &other) const {
+      return ctrl == other.ctrl;
+    }
+    template <bool C> bool operator!=(const BasicIterator<C> &other) const {
+      return ctrl != other.ctrl;
+    }
+  };
+
+  using iterator = BasicIterator<false>;      /**< Iterator type */
+  using const_iterator = BasicIterator<true>; /**< Const iterator type */
+
+  /**
+   * @brief Construct an empty map. Does not allocate.
+   */
+  flat_hash_map() = default;
+
+  /**
+   * @brief Construct an empty map with room for n elements.
+   *
+   * @param n Number of elements to reserve for.
+   * @param hash Hash function.
+   * @param eq Key equality.
+   */
+  explicit flat_hash_map(size_type n, const Hash &hash = Hash(),
+                         const Eq &eq = Eq())
+      : hash(hash), eq(eq) {
+    reserve(n);
+  }
+
+  /**
+   * @brief Construct from a range of key-value pairs. Later duplicates of a
+   * key are ignored.
+   *
+   * @param first Beginning of the range.
+   * @param last End of the range.
+   */
+  template <typename InputIt,
+            typename = typename std::iterator_traits<InputIt>::value_type>
+  flat_hash_map(InputIt first, InputIt last) {
+    insert(first, last);
+  }
+
+  /**
+   * @brief Construct from an initializer list of key-value pairs.
+   *
+   * @param init Initializer list of pairs.
+   */
+  flat_hash_map(std::initializer_list<value_type> init)
+      : flat_hash_map(init.begin(), init.end()) {}
+
+  flat_hash_map(const flat_hash_map &other) : hash(other.hash), eq(other.eq) {
+    if (other.elements == 0) {
+      return;
+    }
+    allocate(other.capacity);
+    std::memcpy(ctrl, other.ctrl, ctrl_bytes(capacity));
+    size_type i = 0;
+    try {
+      for (; i < capacity; ++i) {
+        if (is_full(ctrl[i])) {
+          new (&slots[i].value) value_type(other.slots[i].value);
+        }
+      }
+    } catch (...) {
+      // The destructor does not run for a partly built object
+      while (i-- > 0) {
+        if (is_full(ctrl[i])) {
+          slots[i].value.~value_type();
+        }
+      }
+      deallocate();
+      throw;
+    }
+    elements = other.elements;
+    growth_left = other.growth_left;
+  }
+
+  flat_hash_map(flat_hash_map &&other) noexcept
+      : ctrl(other.ctrl), slots(other.slots), capacity(other.capacity),
+        elements(other.elements), growth_left(other.growth_left),
+        hash(std::move(other.hash)), eq(std::move(other.eq)) {
+    other.reset_storage();
+  }
+
+  flat_hash_map &operator=(const flat_hash_map &other) {
+    if (this != &other) {
+      flat_hash_map tmp(other);
+      swap(tmp);
+    }
+    return *this;
+  }
+
+  flat_hash_map &operator=(flat_hash_map &&other) noexcept {
+    if (this != &other) {
+      destroy();
+      ctrl = other.ctrl;
+      slots = other.slots;
+      capacity = other.capacity;
+      elements = other.elements;
+      growth_left = other.growth_left;
+      hash = std::move(other.hash);
+      eq = std::move(other.eq);
+      other.reset_storage();
+    }
+    return *this;
+  }
+
+  ~flat_hash_map() { destroy(); }
+
+  // Iterator methods
+
+  iterator begin() {
+    iterator it(ctrl, slots);
+    it.skip_empty_or_deleted();
+    return it;
+  }
+  const_iterator begin() const {
+    return const_cast<flat_hash_map *>(this)->begin();
+  }
+  iterator end() { return iterator(ctrl + capacity, slots + capacity); }
+  const_iterator end() const {
+    return const_cast<flat_hash_map *>(this)->end();
+  }
+  const_iterator cbegin() const { return begin(); }
+  const_iterator cend() const { return end(); }
+
+  // Capacity methods
+
+  [[nodiscard]] bool empty() const { return elements == 0; }
+  [[nodiscard]] size_type size() const { return elements; }
+  [[nodiscard]] size_type max_size() const {
+    return (std::numeric_limits<size_type>::max)() / sizeof(Slot);
+  }
+
+  /**
+   * @brief Get the number of slots.
+   *
+   * @return size_type Capacity of the slot array, 0 or 2^n - 1.
+   */
+  [[nodiscard]] size_type bucket_count() const { return capacity; }
+
+  [[nodiscard]] float load_factor() const {
+    return capacity == 0 ? 0.0f : static_cast<float>(elements) / capacity;
+  }
+
+  [[nodiscard]] float max_load_factor() const { return 7.0f / 8.0f; }
+
+  /**
+   * @brief Make room for n elements without further rehashing.
+   *
+   * @param n Number of elements.
+   */
+  void reserve(size_type n) {
+    if (n > elements + growth_left) {
+      resize(capacity_for(n));
+    }
+  }
+
+  /**
+   * @brief Rehash into at least n slots, dropping erased markers. Shrinks to
+   * the smallest capacity holding size() elements when n is 0.
+   *
+   * @param n Minimum number of slots.
+   */
+  void rehash(size_type n) {
+    if (n == 0 && elements == 0) {
+      destroy();
+      reset_storage();
+      return;
+    }
+    resize(std::max(normalize_capacity(n), capacity_for(elements)));
+  }
+
+  // Modifiers
+
+  /**
+   * @brief Remove all elements, keeping the allocated slots.
+   */
+  void clear() {
+    if (capacity == 0) {
+      return;
+    }
+    destroy_elements();
+    std::memset(ctrl, detail::kEmpty, capacity + Group::width);
+    ctrl[capacity] = detail::kSentinel;
+    elements = 0;
+    growth_left = growth_for(capacity);
+  }
+
+  /**
+   * @brief Insert a value constructed from args under key if the key is
+   * absent.
+   *
+   * @param key Key to insert.
+   * @param args Arguments to forward to the mapped value constructor.
+   * @return std::pair<iterator, bool> Element with the key, and whether it
+   * was inserted.
+   */
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(const key_type &key, Args &&...args) {
+    return try_emplace_key(key, std::forward<Args>(args)...);
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(key_type &&key, Args &&...args) {
+    return try_emplace_key(std::move(key), std::forward<Args>(args)...);
+  }
+
+  /**
+   * @brief Hinted try_emplace. The hint is ignored, positions are determined
+   * by the hash alone.
+   *
+   * @return iterator Element with the key.
+   */
+  template <typename... Args>
+  iterator try_emplace(const_iterator, const key_type &key, Args &&...args) {
+    return try_emplace_key(key, std::forward<Args>(args)...).first;
+  }
+
+  template <typename... Args>
+  iterator try_emplace(const_iterator, key_type &&key, Args &&...args) {
+    return try_emplace_key(std::move(key), std::forward<Args>(args)...).first;
+  }
+
+  /**
+   * @brief Insert a key-value pair if the key is absent.
+   *
+   * @param value Pair to insert.
+   * @return std::pair<iterator, bool> Element with the key, and whether it
+   * was inserted.
+   */
+  std::pair<iterator, bool> insert(const value_type &value) {
+    return try_emplace_key(value.first, value.second);
+  }
+
+  std::pair<iterator, bool> insert(value_type &&value) {
+    return try_emplace_key(std::move(const_cast<K &>(value.first)),
+                           std::move(value.second));
+  }
+
+  /**
+   * @brief Insert a range of key-value pairs.
+   *
+   * @param first Beginning of the range.
+   * @param last End of the range.
+   */
+  template <typename InputIt> void insert(InputIt first, InputIt last) {
+    for (; first != last; ++first) {
+      insert(*first);
+    }
+  }
+
+  /**
+   * @brief Get the mapped value of key, default-constructing it if absent.
+   *
+   * @param key Key to look up.
+   * @return V& Mapped value.
+   */
+  V &operator[](const key_type &key) { return try_emplace(key).first->second; }
+  V &operator[](key_type &&key) {
+    return try_emplace(std::move(key)).first->second;
+  }
+
+  /**
+   * @brief Erase the element at pos.
+   *
+   * @param pos Position to erase.
+   * @return iterator Iterator to the following element.
+   */
+  iterator erase(const_iterator pos) {
+    iterator next = mutable_iterator(pos);
+    erase_slot(static_cast<size_type>(pos.ctrl - ctrl));
+    return ++next;
+  }
+
+  iterator erase(iterator pos) { return erase(const_iterator(pos)); }
+
+  /**
+   * @brief Erase the elements in [first, last).
+   *
+   * @param first Beginning of the range.
+   * @param last End of the range.
+   * @return iterator Iterator to last.
+   */
+  iterator erase(const_iterator first, const_iterator last) {
+    while (first != last) {
+      first = erase(first);
+    }
+    return mutable_iterator(last);
+  }
+
+  /**
+   * @brief Erase the element with the given key.
+   *
+   * @param key Key to erase.
+   * @return size_type Number of elements erased (0 or 1).
+   */
+  size_type erase(const key_type &key) { return erase_key(key); }
+
+  template <typename KL, typename = EnableTransparent<KL>>
+  size_type erase(const KL &key) {
+    return erase_key(key);
+  }
+
+  /**
+   * @brief Move in the elements of other whose keys are absent here. The
+   * elements with keys present in both stay in other.
+   *
+   * @param other Map to take elements from.
+   */
+  void merge(flat_hash_map &other) {
+    if (this == &other) {
+      return;
+    }
+    reserve(elements + other.elements);
+    for (auto it = other.begin(); it != other.end();) {
+      auto [pos, inserted] = try_emplace_key(
+          std::move(const_cast<K &>(it->first)), std::move(it->second));
+      it = inserted ? other.erase(it) : std::next(it);
+    }
+  }
+
+  void merge(flat_hash_map &&other) { merge(other); }
+
+  void swap(flat_hash_map &other) noexcept {
+    using std::swap;
+    swap(ctrl, other.ctrl);
+    swap(slots, other.slots);
+    swap(capacity, other.capacity);
+    swap(elements, other.elements);
+    swap(growth_left, other.growth_left);
+    swap(hash, other.hash);
+    swap(eq, other.eq);
+  }
+
+  // Lookup methods
+
+  /**
+   * @brief Find the element with the given key.
+   *
+   * @param key Key to find.
+   * @return iterator Element with the key, or end().
+   */
+  iterator find(const key_type &key) { return find_key(key); }
+  const_iterator find(const key_type &key) const {
+    return const_cast<flat_hash_map *>(this)->find_key(key);
+  }
+
+  template <typename KL, typename = EnableTransparent<KL>>
+  iterator find(const KL &key) {
+    return find_key(key);
+  }
+  template <typename KL, typename = EnableTransparent<KL>>
+  const_iterator find(const KL &key) const {
+    return const_cast<flat_hash_map *>(this)->find_key(key);
+  }
+
+  /**
+   * @brief Count elements with the given key.
+   *
+   * @param key Key to count.
+   * @return size_type 1 if the key exists, 0 otherwise.
+   */
+  size_type count(const key_type &key) const { return contains(key); }
+
+  bool contains(const key_type &key) const { return find(key) != end(); }
+
+  template <typename KL, typename = EnableTransparent<KL>>
+  bool contains(const KL &key) const {
+    return find(key) != end();
+  }
+
+  /**
+   * @brief Get the mapped value of an existing key.
+   *
+   * @param key Key to look up.
+   * @return V& Mapped value.
+   * @throws std::out_of_range if the key does not exist.
+   */
+  V &at(const key_type &key) {
+    auto it = find(key);
+    if (it == end())
+      throw std::out_of_range("flat_hash_map::at");
+    return it->second;
+  }
+
+  const V &at(const key_type &key) const {
+    auto it = find(key);
+    if (it == end())
+      throw std::out_of_range("flat_hash_map::at");
+    return it->second;
+  }
+
+  // Observers
+
+  hasher hash_function() const { return hash; }
+  key_equal key_eq() const { return eq; }
+
+  friend bool operator==(const flat_hash_map &a, const flat_hash_map &b) {
+    if (a.size() != b.size())
+      return false;
+    for (const auto &[key, value] : a) {
+      auto it = b.find(key);
+      if (it == b.end() || !(it->second == value))
+        return false;
+    }
+    return true;
+  }
+
+  friend bool operator!=(const flat_hash_map &a, const flat_hash_map &b) {
+    return !(a == b);
+  }
+
+private:
+  static bool is_full(ctrl_t c) { return c >= 0; }
+
+  /**
+   * @brief Hash a key, mixing the bits so that weak hashes such as the
+   * identity std::hash<int> still spread over H1 and H2.
+   */
+  template <typename KL> size_t hash_of(const KL &key) const {
+    uint64_t h = static_cast<uint64_t>(hash(key));
+#ifdef __SIZEOF_INT128__
+    __uint128_t m = static_cast<__uint128_t>(h) * 0x9e3779b97f4a7c15ULL;
+    return static_cast<size_t>(static_cast<uint64_t>(m) ^
+                               static_cast<uint64_t>(m >> 64));
+#else
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return static_cast<size_t>(h);
+#endif
+  }
+
+  /** Probe start derived from the high hash bits */
+  static size_t h1(size_t h) { return h >> 7; }
+  /** Control byte stored for a full slot, the low 7 hash bits */
+  static ctrl_t h2(size_t h) { return static_cast<ctrl_t>(h & 0x7f); }
+
+  /** Control bytes for a capacity: slots, the sentinel and cloned bytes */
+  static size_type ctrl_bytes(size_type cap) { return cap + Group::width; }
+
+  /** Slot-sized blocks holding the slots followed by the control bytes */
+  static size_type blocks_for(size_type cap) {
+    return cap + (ctrl_bytes(cap) + sizeof(Slot) - 1) / sizeof(Slot);
+  }
+
+  /** Maximum number of elements before a table of capacity cap grows */
+  static size_type growth_for(size_type cap) { return cap - cap / 8; }
+
+  /** Round up to a valid capacity, 2^n - 1 and at least min_capacity */
+  static size_type normalize_capacity(size_type n) {
+    size_type cap = min_capacity;
+    while (cap < n) {
+      cap = cap * 2 + 1;
+    }
+    return cap;
+  }
+
+  /** Smallest capacity holding n elements under the load factor */
+  static size_type capacity_for(size_type n) {
+    size_type cap = normalize_capacity(n);
+    while (growth_for(cap) < n) {
+      cap = cap * 2 + 1;
+    }
+    return cap;
+  }
+
+  /**
+   * @brief Set a control byte, mirroring the first group-width - 1 bytes
+   * after the sentinel so that group loads near the end wrap around.
+   */
+  void set_ctrl(size_type i, ctrl_t c) {
+    ctrl[i] = c;
+    ctrl[((i - (Group::width - 1)) & capacity) + (Group::width - 1)] = c;
+  }
+
+  /**
+   * @brief Allocate empty storage for cap slots, slots first so one block
+   * serves both arrays with the slot alignment.
+   */
+  void allocate(size_type cap) {
+    slots = std::allocator<Slot>().allocate(blocks_for(cap));
+    ctrl = reinterpret_cast<ctrl_t *>(slots + cap);
+    capacity = cap;
+    std::memset(ctrl, detail::kEmpty, ctrl_bytes(cap));
+    ctrl[cap] = detail::kSentinel;
+    growth_left = growth_for(cap);
+  }
+
+  void deallocate() {
+    if (capacity != 0) {
+      std::allocator<Slot>().deallocate(slots, blocks_for(capacity));
+    }
+  }
+
+  void destroy_elements() {
+    if constexpr (!std::is_trivially_destructible_v<value_type>) {
+      for (size_type i = 0; i < capacity; ++i) {
+        if (is_full(ctrl[i])) {
+          slots[i].value.~value_type();
+        }
+      }
+    }
+  }
+
+  void destroy() {
+    destroy_elements();
+    deallocate();
+  }
+
+  void reset_storage() {
+    ctrl = const_cast<ctrl_t *>(detail::kEmptyGroup);
+    slots = nullptr;
+    capacity = 0;
+    elements = 0;
+    growth_left = 0;
+  }
+
+  /**
+   * @brief Find the first empty or erased slot on the probe sequence of h.
+   */
+  size_type find_first_non_full(size_t h) const {
+    size_type offset = h1(h) & capacity;
+    for (size_type step = Group::width;; step += Group::width) {
+      uint32_t mask = Group(ctrl + offset).match_empty_or_deleted();
+      if (mask != 0) {
+        return (offset + detail::count_trailing_zeros(mask)) & capacity;
+      }
+      offset = (offset + step) & capacity;
+    }
+  }
+
+  /**
+   * @brief Move every element into a fresh table of new_capacity slots.
+   */
+  void resize(size_type new_capacity) {
+    ctrl_t *old_ctrl = ctrl;
+    Slot *old_slots = slots;
+    size_type old_capacity = capacity;
+
+    allocate(new_capacity);
+    for (size_type i = 0; i < old_capacity; ++i) {
+      if (is_full(old_ctrl[i])) {
+        value_type &old = old_slots[i].value;
+        size_t h = hash_of(old.first);
+        size_type target = find_first_non_full(h);
+        set_ctrl(target, h2(h));
+        new (&slots[target].value) value_type(
+            std::move(const_cast<K &>(old.first)), std::move(old.second));
+        old.~value_type();
+      }
+    }
+    growth_left -= elements;
+
+    if (old_capacity != 0) {
+      std::allocator<Slot>().deallocate(old_slots, blocks_for(old_capacity));
+    }
+  }
+
+  /**
+   * @brief Make room for one more insertion into an empty slot, rehashing
+   * in place when erased markers take the room and growing otherwise.
+   */
+  void grow_if_needed() {
+    if (capacity == 0) {
+      resize(min_capacity);
+    } else if (elements * 32 <= capacity * 25) {
+      resize(capacity);
+    } else {
+      resize(capacity * 2 + 1);
+    }
+  }
+
+  template <typename KL> size_type find_index(const KL &key, size_t h) const {
+    if (capacity == 0) {
+      return capacity;
+    }
+    size_type offset = h1(h) & capacity;
+    for (size_type step = Group::width;; step += Group::width) {
+      Group group(ctrl + offset);
+      for (uint32_t mask = group.match(h2(h)); mask != 0; mask &= mask - 1) {
+        size_type i = (offset + detail::count_trailing_zeros(mask)) & capacity;
+        if (eq(slots[i].value.first, key)) {
+          return i;
+        }
+      }
+      if (group.match_empty() != 0) {
+        return capacity;
+      }
+      offset = (offset + step) & capacity;
+    }
+  }
+
+  template <typename KL> iterator find_key(const KL &key) {
+    size_type i = find_index(key, hash_of(key));
+    return iterator(ctrl + i, slots + i);
+  }
+
+  template <typename KArg, typename... Args>
+  std::pair<iterator, bool> try_emplace_key(KArg &&key, Args &&...args) {
+    size_t h = hash_of(key);
+    size_type i = find_index(key, h);
+    if (i != capacity) {
+      return {iterator(ctrl + i, slots + i), false};
+    }
+
+    i = find_first_non_full_or_grow(h);
+    new (&slots[i].value)
+        value_type(std::piecewise_construct,
+                   std::forward_as_tuple(std::forward<KArg>(key)),
+                   std::forward_as_tuple(std::forward<Args>(args)...));
+    growth_left -= ctrl[i] == detail::kEmpty;
+    set_ctrl(i, h2(h));
+    ++elements;
+    return {iterator(ctrl + i, slots + i), true};
+  }
+
+  size_type find_first_non_full_or_grow(size_t h) {
+    if (capacity != 0) {
+      size_type i = find_first_non_full(h);
+      if (growth_left > 0 || ctrl[i] == detail::kDeleted) {
+        return i;
+      }
+    }
+    grow_if_needed();
+    return find_first_non_full(h);
+  }
+
+  /**
+   * @brief Destroy the element in slot i. The slot goes back to empty when
+   * no probe can have passed over it, i.e. the run of full slots around it
+   * is shorter than a group; otherwise it is marked deleted.
+   */
+  void erase_slot(size_type i) {
+    slots[i].value.~value_type();
+    --elements;
+    uint32_t empty_after = Group(ctrl + i).match_empty();
+    uint32_t empty_before =
+        Group(ctrl + ((i - Group::width) & capacity)).match_empty();
+    bool was_never_full =
+        empty_before != 0 && empty_after != 0 &&
+        detail::count_trailing_zeros(empty_after) +
+                detail::count_leading_zeros16(empty_before) <
+            Group::width;
+    set_ctrl(i, was_never_full ? detail::kEmpty : detail::kDeleted);
+    growth_left += was_never_full;
+  }
+
+  template <typename KL> size_type erase_key(const KL &key) {
+    size_type i = find_index(key, hash_of(key));
+    if (i == capacity) {
+      return 0;
+    }
+    erase_slot(i);
+    return 1;
+  }
+
+  iterator mutable_iterator(const_iterator pos) {
+    return iterator(pos.ctrl, pos.slot);
+  }
+};
+
+/**
+ * @brief Footprint of a flat_hash_map used as a MultiMap dictionary: the
+ * slots and control bytes are one block, and the empty slots, control
+ * bytes and padding count as structure.
+ */
+template <typename K, typename V, typename Hash, typename Eq>
+struct DictionaryUsage<flat_hash_map<K, V, Hash, Eq>> {
+  static void add(const flat_hash_map<K, V, Hash, Eq> &d,
+                  MemoryUsage &usage) {
+    using Map = flat_hash_map<K, V, Hash, Eq>;
+    using Slot = typename Map::Slot;
+    size_t bytes =
+        d.capacity == 0 ? 0 : Map::blocks_for(d.capacity) * sizeof(Slot);
+    usage.structure += bytes - d.size() * (sizeof(K) + sizeof(V));
+    usage.keys += d.size() * sizeof(K);
+    if (bytes != 0) {
+      usage.add_block(bytes);
+    }
+    for (const auto &[key, container] : d) {
+      HeapUsage<K>::add(key, usage);
+      ContainerUsage<V>::add(container, usage);
+    }
+  }
+};
+
+/**
+ * @brief Swap two flat_hash_maps.
+ */
+template <typename K, typename V, typename Hash, typename Eq>
+void swap(flat_hash_map<K, V, Hash, Eq> &a,
+          flat_hash_map<K, V, Hash, Eq> &b) noexcept {
+  a.swap(b);
+}
+
+} // namespace dictool
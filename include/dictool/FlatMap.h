@@ -0,0 +1,612 @@
+#pragma once
+
+#include "dictool/MemoryUsage.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace dictool {
+
+/**
+ * @brief Ordered map stored as a sorted vector of (key, value) pairs.
+ *
+ * Lookups are binary searches over contiguous memory and there is no
+ * per-key allocation, which makes it a cache-friendly DTemplate for
+ * read-heavy MultiMaps: MultiMap<K, V, std::vector, dictool::flat_map>.
+ *
+ * New keys that do not extend the sorted run go to a small sorted tail at
+ * the back of the same vector, which is merged into the main run once it
+ * grows past about sqrt(size()) keys. An insert thus shifts O(sqrt n)
+ * elements amortized instead of O(n). Lookups search both runs and
+ * iteration walks them in merged order, so reads never reorder storage.
+ * Keys arriving in ascending order (e.g. through MultiMap::bulk_load) are
+ * appended in O(1).
+ *
+ * Like any vector-backed map, insertions and erasures invalidate
+ * iterators and references. Unlike std::map, value_type is
+ * std::pair<K, V> so elements can be shifted; keys must not be modified
+ * through iterators.
+ *
+ * @tparam K Key type.
+ * @tparam V Mapped type.
+ * @tparam Compare Strict weak ordering of keys (default: std::less<K>).
+ */
+template <typename K, typename V, typename Compare = std::less<K>>
+class flat_map {
+public:
+  using key_type = K;                 /**< Type of keys */
+  using mapped_type = V;              /**< Type of mapped values */
+  using value_type = std::pair<K, V>; /**< Type of stored elements */
+  using size_type = size_t;           /**< Size type */
+  using difference_type = ptrdiff_t;  /**< Difference type */
+  using key_compare = Compare;        /**< Key ordering */
+  using reference = value_type &;
+  using const_reference = const value_type &;
+
+private:
+  std::vector<value_type> items; /**< Sorted main run, then sorted tail */
+  size_type sorted = 0;          /**< Length of the main run */
+  Compare comp;                  /**< Key ordering */
+
+  /** Smallest tail that is merged regardless of size() */
+  static constexpr size_type min_tail = 32;
+
+public:
+  /**
+   * @brief Forward iterator walking the main run and the tail in key order.
+   *
+   * @tparam Const Whether the iterator gives read-only access.
+   */
+  template <bool Const> class BasicIterator {
+  private:
+    friend class flat_map;
+    friend BasicIterator<!Const>;
+
+    using Owner = std::conditional_t<Const, const flat_map, flat_map>;
+
+    Owner *owner = nullptr; /**< Map being iterated */
+    size_type i = 0;        /**< Next position in the main run */
+    size_type j = 0;        /**< Next position in the tail */
+
+    BasicIterator(Owner *owner, size_type i, size_type j)
+        : owner(owner), i(i), j(j) {}
+
+    /**
+     * @brief Whether the current element is the head of the tail, i.e. the
+     * smaller of the heads of both runs.
+     */
+    bool in_tail() const {
+      if (j == owner->items.size()) {
+        return false;
+      }
+      if (i == owner->sorted) {
+        return true;
+      }
+      return owner->comp(owner->items[j].first, owner->items[i].first);
+    }
+
+    /**
+     * @brief Position of the current element in storage.
+     */
+    size_type pos() const { return in_tail() ? j : i; }
+
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = typename flat_map::value_type;
+    using difference_type = ptrdiff_t;
+    using reference =
+        std::conditional_t<Const, const value_type &, value_type &>;
+    using pointer = std::conditional_t<Const, const value_type *, value_type *>;
+
+    BasicIterator() = default;
+
+    /**
+     * @brief Convert a mutable iterator into a const one.
+     */
+    template <bool C = Const, typename = std::enable_if_t<C>>
+    BasicIterator(const BasicIterator<false> &other)
+        : owner(other.owner), i(other.i), j(other.j) {}
+
+    reference operator*() const { return owner->items[pos()]; }
+    pointer operator->() const { return &owner->items[pos()]; }
+
+    BasicIterator &operator++() {
+      if (in_tail()) {
+        ++j;
+      } else {
+        ++i;
+      }
+      return *this;
+    }
+
+    BasicIterator operator++(int) {
+      BasicIterator tmp = *this;
+      ++(*this);
+      return tmp;
+    }
+
+    template <bool C> bool operator==(const BasicIterator<C> &other) const {
+      return i == other.i && j == other.j;
+    }
+    template <bool C> bool operator!=(const BasicIterator<C> &other) const {
+      return !(*this == other);
+    }
+  };
+
+  using iterator = BasicIterator<false>;      /**< Iterator type */
+  using const_iterator = BasicIterator<true>; /**< Const iterator type */
+
+  /**
+   * @brief Construct an empty map.
+   */
+  flat_map() = default;
+
+  /**
+   * @brief Construct an empty map with a comparator.
+   *
+   * @param comp Key ordering.
+   */
+  explicit flat_map(const Compare &comp) : comp(comp) {}
+
+  /**
+   * @brief Construct from a range of key-value pairs. The first pair of
+   * each key wins.
+   *
+   * @param first Beginning of the range.
+   * @param last End of the range.
+   * @param comp Key ordering.
+   */
+  template <typename InputIt,
+            typename = typename std::iterator_traits<InputIt>::value_type>
+  flat_map(InputIt first, InputIt last, const Compare &comp = Compare())
+      : items(first, last), comp(comp) {
+    std::stable_sort(items.begin(), items.end(), by_key());
+    auto same_key = [&](const value_type &a, const value_type &b) {
+      return !this->comp(a.first, b.first);
+    };
+    items.erase(std::unique(items.begin(), items.end(), same_key),
+                items.end());
+    sorted = items.size();
+  }
+
+  /**
+   * @brief Construct from an initializer list of key-value pairs.
+   *
+   * @param init Initializer list of pairs.
+   * @param comp Key ordering.
+   */
+  flat_map(std::initializer_list<value_type> init,
+           const Compare &comp = Compare())
+      : flat_map(init.begin(), init.end(), comp) {}
+
+  // Iterator methods
+
+  iterator begin() { return iterator(this, 0, sorted); }
+  const_iterator begin() const { return const_iterator(this, 0, sorted); }
+  iterator end() { return iterator(this, sorted, items.size()); }
+  const_iterator end() const {
+    return const_iterator(this, sorted, items.size());
+  }
+  const_iterator cbegin() const { return begin(); }
+  const_iterator cend() const { return end(); }
+
+  // Capacity methods
+
+  [[nodiscard]] bool empty() const { return items.empty(); }
+  [[nodiscard]] size_type size() const { return items.size(); }
+  [[nodiscard]] size_type max_size() const { return items.max_size(); }
+  [[nodiscard]] size_type capacity() const { return items.capacity(); }
+
+  /**
+   * @brief Get the number of keys waiting in the unmerged tail.
+   *
+   * @return size_type Length of the tail.
+   */
+  [[nodiscard]] size_type pending() const { return items.size() - sorted; }
+
+  void reserve(size_type n) { items.reserve(n); }
+  void shrink_to_fit() { items.shrink_to_fit(); }
+
+  // Modifiers
+
+  void clear() {
+    items.clear();
+    sorted = 0;
+  }
+
+  /**
+   * @brief Merge the tail into the main run, leaving one sorted run.
+   */
+  void flush() {
+    if (sorted != items.size()) {
+      std::inplace_merge(items.begin(), items.begin() + sorted, items.end(),
+                         by_key());
+      sorted = items.size();
+    }
+  }
+
+  /**
+   * @brief Insert a value constructed from args under key if the key is
+   * absent.
+   *
+   * @param key Key to insert.
+   * @param args Arguments to forward to the mapped value constructor.
+   * @return std::pair<iterator, bool> Element with the key, and whether it
+   * was inserted.
+   */
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(const key_type &key, Args &&...args) {
+    return try_emplace_key(key, std::forward<Args>(args)...);
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(key_type &&key, Args &&...args) {
+    return try_emplace_key(std::move(key), std::forward<Args>(args)...);
+  }
+
+  /**
+   * @brief Hinted try_emplace. Ascending keys are appended in O(1) with or
+   * without the hint, so the hint itself is not used.
+   *
+   * @return iterator Element with the key.
+   */
+  template <typename... Args>
+  iterator try_emplace(const_iterator, const key_type &key, Args &&...args) {
+    return try_emplace_key(key, std::forward<Args>(args)...).first;
+  }
+
+  template <typename... Args>
+  iterator try_emplace(const_iterator, key_type &&key, Args &&...args) {
+    return try_emplace_key(std::move(key), std::forward<Args>(args)...).first;
+  }
+
+  /**
+   * @brief Insert a key-value pair if the key is absent.
+   *
+   * @param value Pair to insert.
+   * @return std::pair<iterator, bool> Element with the key, and whether it
+   * was inserted.
+   */
+  std::pair<iterator, bool> insert(const value_type &value) {
+    return try_emplace_key(value.first, value.second);
+  }
+
+  std::pair<iterator, bool> insert(value_type &&value) {
+    return try_emplace_key(std::move(value.first), std::move(value.second));
+  }
+
+  /**
+   * @brief Insert a range of key-value pairs.
+   *
+   * @param first Beginning of the range.
+   * @param last End of the range.
+   */
+  template <typename InputIt> void insert(InputIt first, InputIt last) {
+    for (; first != last; ++first) {
+      insert(*first);
+    }
+  }
+
+  /**
+   * @brief Get the mapped value of key, default-constructing it if absent.
+   *
+   * @param key Key to look up.
+   * @return V& Mapped value.
+   */
+  V &operator[](const key_type &key) { return try_emplace(key).first->second; }
+  V &operator[](key_type &&key) {
+    return try_emplace(std::move(key)).first->second;
+  }
+
+  /**
+   * @brief Erase the element at pos.
+   *
+   * @param pos Position to erase.
+   * @return iterator Iterator to the following element.
+   */
+  iterator erase(const_iterator pos) {
+    if (pos.in_tail()) {
+      items.erase(items.begin() + pos.j);
+      return iterator(this, pos.i, pos.j);
+    }
+    items.erase(items.begin() + pos.i);
+    --sorted;
+    return iterator(this, pos.i, pos.j - 1);
+  }
+
+  iterator erase(iterator pos) { return erase(const_iterator(pos)); }
+
+  /**
+   * @brief Erase the elements in [first, last).
+   *
+   * @param first Beginning of the range.
+   * @param last End of the range.
+   * @return iterator Iterator to the following element.
+   */
+  iterator erase(const_iterator first, const_iterator last) {
+    auto n = std::distance(first, last);
+    iterator it(this, first.i, first.j);
+    for (; n > 0; --n) {
+      it = erase(it);
+    }
+    return it;
+  }
+
+  /**
+   * @brief Erase the element with the given key.
+   *
+   * @param key Key to erase.
+   * @return size_type Number of elements erased (0 or 1).
+   */
+  size_type erase(const key_type &key) { return erase_key(key); }
+
+  template <typename KL, typename C = Compare,
+            typename = typename C::is_transparent>
+  size_type erase(const KL &key) {
+    return erase_key(key);
+  }
+
+  /**
+   * @brief Move in the elements of other whose keys are absent here. The
+   * elements with keys present in both stay in other.
+   *
+   * @param other Map to take elements from.
+   */
+  void merge(flat_map &other) {
+    if (this == &other) {
+      return;
+    }
+    flush();
+    other.flush();
+    std::vector<value_type> merged;
+    std::vector<value_type> left;
+    merged.reserve(items.size() + other.items.size());
+    auto a = items.begin();
+    auto b = other.items.begin();
+    while (a != items.end() || b != other.items.end()) {
+      if (b == other.items.end() ||
+          (a != items.end() && comp(a->first, b->first))) {
+        merged.push_back(std::move(*a++));
+      } else if (a == items.end() || comp(b->first, a->first)) {
+        merged.push_back(std::move(*b++));
+      } else {
+        merged.push_back(std::move(*a++));
+        left.push_back(std::move(*b++));
+      }
+    }
+    items = std::move(merged);
+    sorted = items.size();
+    other.items = std::move(left);
+    other.sorted = other.items.size();
+  }
+
+  void merge(flat_map &&other) { merge(other); }
+
+  void swap(flat_map &other) noexcept {
+    using std::swap;
+    swap(items, other.items);
+    swap(sorted, other.sorted);
+    swap(comp, other.comp);
+  }
+
+  // Lookup methods
+
+  /**
+   * @brief Find the element with the given key.
+   *
+   * @param key Key to find.
+   * @return iterator Element with the key, or end().
+   */
+  iterator find(const key_type &key) { return find_key(this, key); }
+  const_iterator find(const key_type &key) const {
+    return find_key(this, key);
+  }
+
+  template <typename KL, typename C = Compare,
+            typename = typename C::is_transparent>
+  iterator find(const KL &key) {
+    return find_key(this, key);
+  }
+  template <typename KL, typename C = Compare,
+            typename = typename C::is_transparent>
+  const_iterator find(const KL &key) const {
+    return find_key(this, key);
+  }
+
+  /**
+   * @brief Count elements with the given key.
+   *
+   * @param key Key to count.
+   * @return size_type 1 if the key exists, 0 otherwise.
+   */
+  size_type count(const key_type &key) const { return contains(key); }
+
+  bool contains(const key_type &key) const {
+    return index_of(key) != items.size();
+  }
+
+  template <typename KL, typename C = Compare,
+            typename = typename C::is_transparent>
+  bool contains(const KL &key) const {
+    return index_of(key) != items.size();
+  }
+
+  /**
+   * @brief Get the mapped value of an existing key.
+   *
+   * @param key Key to look up.
+   * @return V& Mapped value.
+   * @throws std::out_of_range if the key does not exist.
+   */
+  V &at(const key_type &key) {
+    size_type p = index_of(key);
+    if (p == items.size())
+      throw std::out_of_range("flat_map::at");
+    return items[p].second;
+  }
+
+  const V &at(const key_type &key) const {
+    size_type p = index_of(key);
+    if (p == items.size())
+      throw std::out_of_range("flat_map::at");
+    return items[p].second;
+  }
+
+  // Observers
+
+  key_compare key_comp() const { return comp; }
+
+  friend bool operator==(const flat_map &a, const flat_map &b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+  }
+
+  friend bool operator!=(const flat_map &a, const flat_map &b) {
+    return !(a == b);
+  }
+
+private:
+  auto by_key() const {
+    return [this](const value_type &a, const value_type &b) {
+      return comp(a.first, b.first);
+    };
+  }
+
+  /** First position in [first, last) whose key is not less than key */
+  template <typename KL>
+  size_type lower_bound_in(size_type first, size_type last,
+                           const KL &key) const {
+    auto it = std::lower_bound(
+        items.begin() + first, items.begin() + last, key,
+        [this](const value_type &item, const KL &k) {
+          return comp(item.first, k);
+        });
+    return static_cast<size_type>(it - items.begin());
+  }
+
+  template <typename KL>
+  bool matches(size_type p, size_type last, const KL &key) const {
+    return p != last && !comp(key, items[p].first);
+  }
+
+  /** Position of key in either run, or size() when absent */
+  template <typename KL> size_type index_of(const KL &key) const {
+    size_type p = lower_bound_in(0, sorted, key);
+    if (matches(p, sorted, key)) {
+      return p;
+    }
+    p = lower_bound_in(sorted, items.size(), key);
+    return matches(p, items.size(), key) ? p : items.size();
+  }
+
+  /** Iterator at position p, which lies in the main run or the tail */
+  template <typename Self>
+  static auto iterator_at(Self *self, size_type p) {
+    using It = std::conditional_t<std::is_const_v<Self>, const_iterator,
+                                  iterator>;
+    const K &key = self->items[p].first;
+    if (p < self->sorted) {
+      return It(self, p, self->lower_bound_in(self->sorted,
+                                              self->items.size(), key));
+    }
+    return It(self, self->lower_bound_in(0, self->sorted, key), p);
+  }
+
+  template <typename Self, typename KL>
+  static auto find_key(Self *self, const KL &key) {
+    size_type p = self->index_of(key);
+    return p == self->items.size() ? self->end() : iterator_at(self, p);
+  }
+
+  template <typename KArg, typename... Args>
+  std::pair<iterator, bool> try_emplace_key(KArg &&key, Args &&...args) {
+    // Ascending keys extend the main run directly
+    if (sorted == items.size() &&
+        (items.empty() || comp(items.back().first, key))) {
+      emplace_at(items.size(), std::forward<KArg>(key),
+                 std::forward<Args>(args)...);
+      ++sorted;
+      return {iterator(this, items.size() - 1, items.size()), true};
+    }
+
+    size_type p = lower_bound_in(0, sorted, key);
+    if (matches(p, sorted, key)) {
+      return {iterator_at(this, p), false};
+    }
+    size_type q = lower_bound_in(sorted, items.size(), key);
+    if (matches(q, items.size(), key)) {
+      return {iterator_at(this, q), false};
+    }
+
+    emplace_at(q, std::forward<KArg>(key), std::forward<Args>(args)...);
+    if (pending() > tail_limit()) {
+      // After the merge the new key follows the p smaller main keys and the
+      // q - sorted smaller tail keys
+      size_type merged = p + (q - sorted);
+      flush();
+      return {iterator(this, merged, sorted), true};
+    }
+    return {iterator(this, p, q), true};
+  }
+
+  template <typename KArg, typename... Args>
+  void emplace_at(size_type p, KArg &&key, Args &&...args) {
+    items.emplace(items.begin() + p, std::piecewise_construct,
+                  std::forward_as_tuple(std::forward<KArg>(key)),
+                  std::forward_as_tuple(std::forward<Args>(args)...));
+  }
+
+  /** Longest tail kept before merging, about sqrt(size()) */
+  size_type tail_limit() const {
+    auto root = static_cast<size_type>(std::sqrt(double(items.size())));
+    return std::max(min_tail, root);
+  }
+
+  template <typename KL> size_type erase_key(const KL &key) {
+    size_type p = index_of(key);
+    if (p == items.size()) {
+      return 0;
+    }
+    items.erase(items.begin() + p);
+    sorted -= p < sorted;
+    return 1;
+  }
+};
+
+/**
+ * @brief Footprint of a flat_map used as a MultiMap dictionary: the item
+ * array is one block, and its unused capacity and padding count as
+ * structure.
+ */
+template <typename K, typename V, typename Compare>
+struct DictionaryUsage<flat_map<K, V, Compare>> {
+  static void add(const flat_map<K, V, Compare> &d, MemoryUsage &usage) {
+    using Item = typename flat_map<K, V, Compare>::value_type;
+    usage.structure += (d.capacity() - d.size()) * sizeof(Item) +
+                       d.size() * (sizeof(Item) - sizeof(K) - sizeof(V));
+    usage.keys += d.size() * sizeof(K);
+    if (d.capacity() != 0) {
+      usage.add_block(d.capacity() * sizeof(Item));
+    }
+    for (const auto &[key, container] : d) {
+      HeapUsage<K>::add(key, usage);
+      ContainerUsage<V>::add(container, usage);
+    }
+  }
+};
+
+/**
+ * @brief Swap two flat_maps.
+ */
+template <typename K, typename V, typename Compare>
+void swap(flat_map<K, V, Compare> &a, flat_map<K, V, Compare> &b) noexcept {
+  a.swap(b);
+}
+
+} // namespace dictool
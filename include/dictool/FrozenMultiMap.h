@@ -0,0 +1,400 @@
+#pragma once
+
+#include "dictool/MultiDict.h"
+#include "dictool/Traits.h"
+#include "dictool/View.h"
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+namespace dictool {
+
+/**
+ * @brief Immutable multimap in compressed sparse row (CSR) layout.
+ *
+ * Holds three contiguous arrays: the sorted keys, offsets[i]..offsets[i + 1]
+ * delimiting the values of keys[i], and one flat values array. Built once
+ * from a MultiMap and then only read, it costs a binary search per lookup
+ * and no per-key allocation.
+ *
+ * @tparam K Key type.
+ * @tparam V Value type.
+ * @tparam Compare Strict weak ordering of keys (default: std::less<K>).
+ */
+template <typename K, typename V, typename Compare = std::less<K>>
+class FrozenMultiMap {
+private:
+  std::vector<K> sorted_keys; /**< Sorted distinct keys */
+  std::vector<size_t> starts; /**< sorted_keys.size() + 1 value offsets */
+  std::vector<V> flat_values; /**< Values of all keys, grouped by key */
+  Compare comp;               /**< Key ordering */
+
+  template <typename KL>
+  using EnableHeterogeneous =
+      std::enable_if_t<!std::is_same_v<std::decay_t<KL>, K> &&
+                       IsTransparent<Compare>::value>;
+
+public:
+  using key_type = K;                       /**< Type of keys */
+  using mapped_type = V;                    /**< Type of values */
+  using value_type = std::pair<const K, V>; /**< Type of key-value pairs */
+  using size_type = size_t;                 /**< Size type */
+  using difference_type = ptrdiff_t;        /**< Difference type */
+  using key_compare = Compare;              /**< Key ordering */
+  using view_type = Span<const V>; /**< Non-owning view of a key's values */
+
+  /**
+   * @brief Read-only iterator over (key, value) pairs.
+   */
+  class Iterator {
+  private:
+    const FrozenMultiMap *owner = nullptr; /**< Map being iterated */
+    size_t ki = 0;                         /**< Current key index */
+    size_t vi = 0;                         /**< Current value index */
+
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = typename FrozenMultiMap::value_type;
+    using difference_type = ptrdiff_t;
+    using reference = std::pair<const K &, const V &>;
+    using pointer = void;
+
+    Iterator() = default;
+
+    /**
+     * @brief Construct an iterator at a key and value index.
+     *
+     * @param owner Map being iterated.
+     * @param ki Key index.
+     * @param vi Value index, within the values of key ki.
+     */
+    Iterator(const FrozenMultiMap *owner, size_t ki, size_t vi)
+        : owner(owner), ki(ki), vi(vi) {}
+
+    const key_type &key() const { return owner->sorted_keys[ki]; }
+    const mapped_type &value() const { return owner->flat_values[vi]; }
+    reference to_pair() const { return {key(), value()}; }
+    reference operator*() const { return to_pair(); }
+
+    Iterator &operator++() {
+      if (++vi == owner->starts[ki + 1]) {
+        ++ki;
+      }
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      Iterator tmp = *this;
+      ++(*this);
+      return tmp;
+    }
+
+    bool operator==(const Iterator &other) const { return vi == other.vi; }
+    bool operator!=(const Iterator &other) const { return vi != other.vi; }
+  };
+
+  using iterator = Iterator;       /**< Iterator type */
+  using const_iterator = Iterator; /**< Const iterator type */
+
+  /**
+   * @brief Iterator over key groups, yielding (key, view of its values).
+   */
+  class GroupIterator {
+  private:
+    const FrozenMultiMap *owner = nullptr; /**< Map being iterated */
+    size_t ki = 0;                         /**< Current key index */
+
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::pair<const K &, view_type>;
+    using difference_type = ptrdiff_t;
+    using reference = value_type;
+    using pointer = void;
+
+    GroupIterator() = default;
+    GroupIterator(const FrozenMultiMap *owner, size_t ki)
+        : owner(owner), ki(ki) {}
+
+    reference operator*() const {
+      return {owner->sorted_keys[ki], owner->values_at(ki)};
+    }
+
+    GroupIterator &operator++() {
+      ++ki;
+      return *this;
+    }
+
+    GroupIterator operator++(int) {
+      GroupIterator tmp = *this;
+      ++ki;
+      return tmp;
+    }
+
+    bool operator==(const GroupIterator &other) const {
+      return ki == other.ki;
+    }
+    bool operator!=(const GroupIterator &other) const {
+      return ki != other.ki;
+    }
+  };
+
+  /**
+   * @brief Construct an empty frozen multimap.
+   */
+  FrozenMultiMap() : starts(1, 0) {}
+
+  /**
+   * @brief Freeze a MultiMap.
+   *
+   * Keys are taken in the source's order when it is already sorted by
+   * Compare (e.g. a std::map dictionary) and sorted otherwise. Keys without
+   * values are skipped.
+   *
+   * @param mm MultiMap to copy from.
+   * @param comp Key ordering.
+   */
+  template <template <typename...> class CTemplate,
+            template <typename...> class DTemplate, typename Stats>
+  explicit FrozenMultiMap(const MultiMap<K, V, CTemplate, DTemplate, Stats> &mm,
+                          Compare comp = Compare())
+      : comp(std::move(comp)) {
+    using Group = std::pair<const K *, ViewOf<CTemplate<V>>>;
+    std::vector<Group> groups;
+    groups.reserve(mm.key_count());
+    mm.for_each_group([&](const K &key, ViewOf<CTemplate<V>> values) {
+      if (!values.empty()) {
+        groups.emplace_back(&key, values);
+      }
+    });
+    auto by_key = [&](const Group &a, const Group &b) {
+      return this->comp(*a.first, *b.first);
+    };
+    if (!std::is_sorted(groups.begin(), groups.end(), by_key)) {
+      std::sort(groups.begin(), groups.end(), by_key);
+    }
+
+    sorted_keys.reserve(groups.size());
+    starts.reserve(groups.size() + 1);
+    flat_values.reserve(mm.size());
+    starts.push_back(0);
+    for (const auto &[key, values] : groups) {
+      sorted_keys.push_back(*key);
+      flat_values.insert(flat_values.end(), values.begin(), values.end());
+      starts.push_back(flat_values.size());
+    }
+  }
+
+  // Capacity methods
+
+  [[nodiscard]] bool empty() const { return flat_values.empty(); }
+
+  /**
+   * @brief Get the total number of values.
+   *
+   * @return size_type Total number of values.
+   */
+  [[nodiscard]] size_type size() const { return flat_values.size(); }
+
+  /**
+   * @brief Get the number of keys.
+   *
+   * @return size_type Number of keys.
+   */
+  [[nodiscard]] size_type key_count() const { return sorted_keys.size(); }
+
+  /**
+   * @brief Estimate the bytes this map occupies: three arrays, with the
+   * offsets counted as structure and no per-key container headers. See
+   * MemoryUsage.
+   *
+   * @return MemoryUsage The breakdown.
+   */
+  [[nodiscard]] MemoryUsage memory_usage() const {
+    MemoryUsage usage;
+    usage.object = sizeof(*this);
+    detail::add_vector(sorted_keys, usage.keys, usage);
+    detail::add_vector(starts, usage.structure, usage);
+    detail::add_vector(flat_values, usage.values, usage);
+    return usage;
+  }
+
+  // Lookup methods
+
+  /**
+   * @brief Count values with the given key.
+   *
+   * @param key Key to count.
+   * @return size_type Number of values with the key.
+   */
+  size_type count(const key_type &key) const { return view(key).size(); }
+
+  template <typename KL, typename = EnableHeterogeneous<KL>>
+  size_type count(const KL &key) const {
+    return view(key).size();
+  }
+
+  /**
+   * @brief Check if the map contains a key.
+   *
+   * @param key Key to check.
+   * @return true if key exists, false otherwise.
+   */
+  bool contains(const key_type &key) const {
+    return index_of(key) != sorted_keys.size();
+  }
+
+  template <typename KL, typename = EnableHeterogeneous<KL>>
+  bool contains(const KL &key) const {
+    return index_of(key) != sorted_keys.size();
+  }
+
+  /**
+   * @brief Find the first value with the given key.
+   *
+   * @param key Key to find.
+   * @return const_iterator Iterator to the first value, or end().
+   */
+  const_iterator find(const key_type &key) const { return find_key(key); }
+
+  template <typename KL, typename = EnableHeterogeneous<KL>>
+  const_iterator find(const KL &key) const {
+    return find_key(key);
+  }
+
+  /**
+   * @brief Get the range of values with the given key.
+   *
+   * @param key Key to find.
+   * @return std::pair<const_iterator, const_iterator> Range of values.
+   */
+  std::pair<const_iterator, const_iterator>
+  equal_range(const key_type &key) const {
+    return equal_range_key(key);
+  }
+
+  template <typename KL, typename = EnableHeterogeneous<KL>>
+  std::pair<const_iterator, const_iterator> equal_range(const KL &key) const {
+    return equal_range_key(key);
+  }
+
+  /**
+   * @brief Get a view of a key's values, empty if the key is missing.
+   *
+   * @param key Key to look up.
+   * @return view_type Span over the key's values.
+   */
+  [[nodiscard]] view_type view(const key_type &key) const {
+    return view_key(key);
+  }
+
+  template <typename KL, typename = EnableHeterogeneous<KL>>
+  [[nodiscard]] view_type view(const KL &key) const {
+    return view_key(key);
+  }
+
+  // Iterator methods
+
+  const_iterator begin() const { return {this, 0, 0}; }
+  const_iterator end() const {
+    return {this, sorted_keys.size(), flat_values.size()};
+  }
+  const_iterator cbegin() const { return begin(); }
+  const_iterator cend() const { return end(); }
+
+  /**
+   * @brief Get a range over key groups.
+   *
+   * @return Range<GroupIterator> Range of (key, view) over all keys.
+   */
+  Range<GroupIterator> groups() const {
+    return {GroupIterator(this, 0), GroupIterator(this, sorted_keys.size()),
+            sorted_keys.size()};
+  }
+
+  /**
+   * @brief Call f(key, view) once per key.
+   *
+   * @tparam F Callable taking (const K&, view_type).
+   * @param f Function to call for each key group.
+   */
+  template <typename F> void for_each_group(F &&f) const {
+    for (size_t i = 0; i < sorted_keys.size(); ++i) {
+      f(sorted_keys[i], values_at(i));
+    }
+  }
+
+  /**
+   * @brief Get the sorted keys.
+   *
+   * @return Span<const K> View of all keys.
+   */
+  Span<const K> keys() const {
+    return {sorted_keys.data(), sorted_keys.size()};
+  }
+
+  /**
+   * @brief Get the value offsets, keys().size() + 1 entries.
+   *
+   * @return Span<const size_t> View of the offsets array.
+   */
+  Span<const size_t> offsets() const {
+    return {starts.data(), starts.size()};
+  }
+
+  /**
+   * @brief Get all values, grouped by key.
+   *
+   * @return Span<const V> View of the flat values array.
+   */
+  Span<const V> values() const {
+    return {flat_values.data(), flat_values.size()};
+  }
+
+  /**
+   * @brief Get the key ordering.
+   *
+   * @return key_compare Copy of the comparator.
+   */
+  key_compare key_comp() const { return comp; }
+
+private:
+  view_type values_at(size_t ki) const {
+    return {flat_values.data() + starts[ki], starts[ki + 1] - starts[ki]};
+  }
+
+  template <typename KL> size_t index_of(const KL &key) const {
+    auto it =
+        std::lower_bound(sorted_keys.begin(), sorted_keys.end(), key, comp);
+    if (it == sorted_keys.end() || comp(key, *it)) {
+      return sorted_keys.size();
+    }
+    return it - sorted_keys.begin();
+  }
+
+  template <typename KL> view_type view_key(const KL &key) const {
+    size_t ki = index_of(key);
+    return ki == sorted_keys.size() ? view_type() : values_at(ki);
+  }
+
+  template <typename KL> const_iterator find_key(const KL &key) const {
+    size_t ki = index_of(key);
+    return ki == sorted_keys.size() ? end()
+                                   : const_iterator(this, ki, starts[ki]);
+  }
+
+  template <typename KL>
+  std::pair<const_iterator, const_iterator>
+  equal_range_key(const KL &key) const {
+    size_t ki = index_of(key);
+    if (ki == sorted_keys.size()) {
+      return {end(), end()};
+    }
+    return {const_iterator(this, ki, starts[ki]),
+            const_iterator(this, ki + 1, starts[ki + 1])};
+  }
+};
+
+} // namespace dictool
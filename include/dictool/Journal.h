@@ -0,0 +1,730 @@
+#pragma once
+
+#include "dictool/MappedFile.h"
+#include "dictool/MultiDict.h"
+#include "dictool/Snapshot.h"
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace dictool {
+
+/**
+ * @brief Options of JournaledMultiMap.
+ */
+struct JournalOptions {
+  size_t group_bytes = 1u << 16; /**< Buffered log bytes forcing a commit */
+  bool sync = false;             /**< fsync the log on every commit */
+};
+
+/**
+ * @brief Outcome of replaying a change log.
+ */
+struct JournalReplay {
+  size_t records = 0;       /**< Records applied */
+  uint64_t valid_bytes = 0; /**< Length of the intact prefix of the log */
+  uint64_t base = 0;        /**< Checksum of the snapshot the log extends */
+  bool torn = false;        /**< A truncated or corrupt tail was dropped */
+};
+
+namespace detail {
+
+/** Log header, followed by framed records */
+struct JournalHeader {
+  char magic[8];       /**< "DICTJRNL" */
+  uint32_t version;    /**< Format version */
+  uint32_t byte_order; /**< snapshot_byte_order as written */
+  uint32_t flags;      /**< Bit 0: string keys, bit 1: string values */
+  uint32_t key_size;   /**< sizeof the key, 0 for strings */
+  uint32_t value_size; /**< sizeof the value, 0 for strings */
+  uint32_t reserved;   /**< Zero */
+  uint64_t base;       /**< Checksum of the base snapshot, 0 if none */
+};
+
+static_assert(sizeof(JournalHeader) == 40, "header layout changed");
+
+constexpr char journal_magic[8] = {'D', 'I', 'C', 'T', 'J', 'R', 'N', 'L'};
+constexpr uint32_t journal_version = 1;
+constexpr size_t journal_replay_chunk = 1u << 16;
+
+/**
+ * Each record is framed by its payload length and the CRC-32 of the
+ * payload, both uint32_t. The payload is the operation byte followed by
+ * its fields.
+ */
+constexpr size_t journal_frame = 2 * sizeof(uint32_t);
+
+enum class JournalOp : uint8_t {
+  emplace = 1,     /**< key, value */
+  erase_key = 2,   /**< key */
+  erase_value = 3, /**< key, value */
+  clear = 4,       /**< no fields */
+};
+
+inline const std::array<uint32_t, 256> &crc32_table() {
+  static const std::array<uint32_t, 256> table = [] {
+    std::array<uint32_t, 256> t{};
+    for (uint32_t i = 0; i < 256; ++i) {
+      uint32_t c = i;
+      for (int k = 0; k < 8; ++k) {
+        c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+      }
+      t[i] = c;
+    }
+    return t;
+  }();
+  return table;
+}
+
+/** CRC-32 (IEEE 802.3) of n bytes */
+inline uint32_t crc32(const void *data, size_t n) {
+  const auto &table = crc32_table();
+  const auto *p = static_cast<const unsigned char *>(data);
+  uint32_t c = 0xffffffffu;
+  for (size_t i = 0; i < n; ++i) {
+    c = table[(c ^ p[i]) & 0xff] ^ (c >> 8);
+  }
+  return c ^ 0xffffffffu;
+}
+
+template <typename K, typename V> JournalHeader journal_header(uint64_t base) {
+  JournalHeader header{};
+  std::memcpy(header.magic, journal_magic, sizeof(header.magic));
+  header.version = journal_version;
+  header.byte_order = snapshot_byte_order;
+  header.flags = (SnapshotType<K>::is_string ? 1u : 0u) |
+                 (SnapshotType<V>::is_string ? 2u : 0u);
+  header.key_size = SnapshotType<K>::is_string ? 0 : sizeof(K);
+  header.value_size = SnapshotType<V>::is_string ? 0 : sizeof(V);
+  header.base = base;
+  return header;
+}
+
+/** Append a field: its bytes, or a uint32_t length and the characters */
+template <typename T> void put_field(std::string &out, const T &item) {
+  if constexpr (SnapshotType<T>::is_string) {
+    if (item.size() > UINT32_MAX) {
+      throw std::length_error("JournaledMultiMap: string too long");
+    }
+    auto n = static_cast<uint32_t>(item.size());
+    out.append(reinterpret_cast<const char *>(&n), sizeof(n));
+    out.append(item);
+  } else {
+    out.append(reinterpret_cast<const char *>(&item), sizeof(T));
+  }
+}
+
+/** Decode a field from [p, end) and advance p; false if it overruns */
+template <typename T> bool get_field(const char *&p, const char *end, T &out) {
+  if constexpr (SnapshotType<T>::is_string) {
+    uint32_t n;
+    if (static_cast<size_t>(end - p) < sizeof(n)) {
+      return false;
+    }
+    std::memcpy(&n, p, sizeof(n));
+    p += sizeof(n);
+    if (static_cast<size_t>(end - p) < n) {
+      return false;
+    }
+    out.assign(p, n);
+    p += n;
+  } else {
+    if (static_cast<size_t>(end - p) < sizeof(T)) {
+      return false;
+    }
+    std::memcpy(&out, p, sizeof(T));
+    p += sizeof(T);
+  }
+  return true;
+}
+
+/** Append one framed record */
+template <typename... Fields>
+void append_record(std::string &out, JournalOp op, const Fields &...fields) {
+  size_t start = out.size();
+  out.append(journal_frame, '\0');
+  out.push_back(static_cast<char>(op));
+  (put_field(out, fields), ...);
+  auto length = static_cast<uint32_t>(out.size() - start - journal_frame);
+  uint32_t crc = crc32(out.data() + start + journal_frame, length);
+  std::memcpy(&out[start], &length, sizeof(length));
+  std::memcpy(&out[start + sizeof(length)], &crc, sizeof(crc));
+}
+
+/** Check a log header against the key and value types */
+template <typename K, typename V>
+void check_journal_header(const JournalHeader &header,
+                          const std::string &path) {
+  if (std::memcmp(header.magic, journal_magic, sizeof(header.magic)) != 0) {
+    throw std::runtime_error("replay: not a journal: " + path);
+  }
+  if (header.version != journal_version) {
+    throw std::runtime_error("replay: unsupported version in " + path);
+  }
+  if (header.byte_order != snapshot_byte_order) {
+    throw std::runtime_error("replay: foreign byte order in " + path);
+  }
+  JournalHeader expected = journal_header<K, V>(header.base);
+  if (header.flags != expected.flags ||
+      header.key_size != expected.key_size ||
+      header.value_size != expected.value_size) {
+    throw std::runtime_error("replay: key or value type mismatch in " +
+                             path);
+  }
+}
+
+/** Base snapshot checksum of a log; 0 if its header is incomplete */
+template <typename K, typename V>
+uint64_t journal_base(const std::string &path) {
+  JournalHeader header;
+  std::ifstream in(path, std::ios::binary);
+  if (!in.read(reinterpret_cast<char *>(&header), sizeof(header))) {
+    return 0;
+  }
+  check_journal_header<K, V>(header, path);
+  return header.base;
+}
+
+inline bool file_exists(const std::string &path) {
+  struct stat st;
+  return ::stat(path.c_str(), &st) == 0;
+}
+
+/** Write n bytes at offset, retrying short and interrupted writes */
+inline void write_at(int fd, const char *data, size_t n, uint64_t offset,
+                     const std::string &path) {
+  while (n > 0) {
+    ssize_t written = ::pwrite(fd, data, n, static_cast<off_t>(offset));
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::runtime_error("JournaledMultiMap: cannot write " + path);
+    }
+    data += written;
+    n -= static_cast<size_t>(written);
+    offset += static_cast<uint64_t>(written);
+  }
+}
+
+inline void sync_fd(int fd, const std::string &path) {
+  if (::fsync(fd) != 0) {
+    throw std::runtime_error("JournaledMultiMap: cannot sync " + path);
+  }
+}
+
+/** Open a log for writing, cut to length bytes */
+inline int open_log(const std::string &path, uint64_t length) {
+  int fd = ::open(path.c_str(), O_WRONLY | O_CREAT, 0644);
+  if (fd < 0) {
+    throw std::runtime_error("JournaledMultiMap: cannot open " + path);
+  }
+  if (::ftruncate(fd, static_cast<off_t>(length)) != 0) {
+    ::close(fd);
+    throw std::runtime_error("JournaledMultiMap: cannot truncate " + path);
+  }
+  return fd;
+}
+
+} // namespace detail
+
+/**
+ * @brief Apply a change log written by JournaledMultiMap to a MultiMap.
+ *
+ * Runs of consecutive emplace records are gathered and handed to
+ * MultiMap::bulk_load, in chunks, instead of being emplaced one by one;
+ * erase and clear records flush the run and apply in order, so the result
+ * is the same as replaying each call.
+ *
+ * Replay stops at the first record that is cut short or fails its CRC,
+ * which is what a crash in the middle of a commit leaves behind. Nothing
+ * after it is applied, and the result reports the tail as torn.
+ *
+ * @param path Log file.
+ * @param mm MultiMap to apply the records to.
+ * @return JournalReplay Records applied and length of the intact prefix.
+ * @throws std::runtime_error if the file cannot be read, is not a log,
+ * was written with other key or value types, or holds a record that
+ * passes its CRC but does not decode.
+ */
+template <typename K, typename V, template <typename...> class CTemplate,
+          template <typename...> class DTemplate, typename Stats>
+JournalReplay replay(const std::string &path,
+                     MultiMap<K, V, CTemplate, DTemplate, Stats> &mm) {
+  static_assert(SnapshotType<K>::supported && SnapshotType<V>::supported,
+                "journal keys and values must be trivially copyable or "
+                "std::string");
+  using detail::JournalOp;
+
+  MappedFile file(path);
+  JournalReplay result;
+  detail::JournalHeader header;
+  if (file.size() < sizeof(header)) {
+    // Crashed while creating the log
+    result.torn = file.size() != 0;
+    return result;
+  }
+  std::memcpy(&header, file.data(), sizeof(header));
+  detail::check_journal_header<K, V>(header, path);
+  result.base = header.base;
+  file.advise_sequential();
+
+  std::vector<std::pair<K, V>> run;
+  auto flush = [&] {
+    if (!run.empty()) {
+      mm.bulk_load(std::move(run));
+      run.clear();
+    }
+  };
+
+  const char *base = file.data();
+  const char *end = base + file.size();
+  const char *p = base + sizeof(header);
+  while (static_cast<size_t>(end - p) >= detail::journal_frame) {
+    uint32_t length;
+    uint32_t crc;
+    std::memcpy(&length, p, sizeof(length));
+    std::memcpy(&crc, p + sizeof(length), sizeof(crc));
+    const char *payload = p + detail::journal_frame;
+    if (length == 0 || length > static_cast<size_t>(end - payload) ||
+        detail::crc32(payload, length) != crc) {
+      break;
+    }
+
+    const char *q = payload + 1;
+    const char *stop = payload + length;
+    auto op = static_cast<JournalOp>(*payload);
+    K key;
+    V value;
+    bool ok = false;
+    switch (op) {
+    case JournalOp::emplace:
+    case JournalOp::erase_value:
+      ok = detail::get_field(q, stop, key) &&
+           detail::get_field(q, stop, value);
+      break;
+    case JournalOp::erase_key:
+      ok = detail::get_field(q, stop, key);
+      break;
+    case JournalOp::clear:
+      ok = true;
+      break;
+    }
+    if (!ok || q != stop) {
+      throw std::runtime_error("replay: malformed record at offset " +
+                               std::to_string(p - base) + " of " + path);
+    }
+
+    switch (op) {
+    case JournalOp::emplace:
+      run.emplace_back(std::move(key), std::move(value));
+      if (run.size() == detail::journal_replay_chunk) {
+        flush();
+      }
+      break;
+    case JournalOp::erase_key:
+      flush();
+      mm.erase(key);
+      break;
+    case JournalOp::erase_value:
+      flush();
+      mm.erase(key, value);
+      break;
+    case JournalOp::clear:
+      run.clear();
+      mm.clear();
+      break;
+    }
+    ++result.records;
+    p = stop;
+  }
+  flush();
+  result.valid_bytes = static_cast<uint64_t>(p - base);
+  result.torn = p != end;
+  return result;
+}
+
+/**
+ * @brief Replay a change log into a new MultiMap, see the overload
+ * applying it to an existing one.
+ *
+ * @tparam Map MultiMap type to build.
+ * @param path Log file.
+ * @return Map The rebuilt map.
+ */
+template <typename Map> Map replay(const std::string &path) {
+  Map mm;
+  replay(path, mm);
+  return mm;
+}
+
+/**
+ * @brief MultiMap persisted as a binary snapshot plus an append-only
+ * change log.
+ *
+ * Every successful emplace, erase and clear is appended to the log as a
+ * small binary record framed with its length and CRC-32. Records are
+ * batched in memory and written with one system call per commit (group
+ * commit): commit() writes the batch, and so does any call that grows it
+ * past options.group_bytes or the destructor. Records still in the batch
+ * are lost on a crash; with options.sync each commit is also fsync'ed.
+ *
+ * Opening loads path + ".snap" if present and replays path + ".log" on
+ * top of it, dropping a torn tail. compact() folds the log into a fresh
+ * snapshot and starts an empty log. The log header records the checksum
+ * of the snapshot it extends, so a crash between writing the snapshot
+ * and replacing the log leaves a log that is recognized as already folded
+ * and ignored.
+ *
+ * Keys and values must be trivially copyable or std::string, as for
+ * save_binary. Reads go through map(); writes must go through this class
+ * to be logged.
+ *
+ * @tparam K Key type.
+ * @tparam V Value type.
+ * @tparam CTemplate Container template for storing values (default:
+ * std::vector).
+ * @tparam DTemplate Dictionary template (default: std::map).
+ * @tparam Stats Instrumentation policy of the wrapped map (default:
+ * NoStats); read its counts through map().
+ */
+template <typename K, typename V,
+          template <typename...> class CTemplate = std::vector,
+          template <typename...> class DTemplate = std::map,
+          typename Stats = NoStats>
+class JournaledMultiMap {
+  static_assert(SnapshotType<K>::supported && SnapshotType<V>::supported,
+                "journal keys and values must be trivially copyable or "
+                "std::string");
+
+public:
+  using map_type =
+      MultiMap<K, V, CTemplate, DTemplate, Stats>; /**< Wrapped map */
+  using key_type = K;                              /**< Type of keys */
+  using mapped_type = V;    /**< Type of values */
+  using size_type = size_t; /**< Size type */
+  using view_type = typename map_type::view_type; /**< View of a key's values */
+
+private:
+  map_type mm;               /**< Current contents */
+  std::string log_file;      /**< path + ".log" */
+  std::string snapshot_file; /**< path + ".snap" */
+  JournalOptions options;    /**< Commit policy */
+  std::string pending;       /**< Records not yet written */
+  int fd = -1;               /**< Open log */
+  uint64_t committed = 0;    /**< Bytes of the log written so far */
+  uint64_t base = 0;         /**< Checksum of the current snapshot */
+  bool log_lost = false;     /**< compact() could not install its new log */
+  JournalReplay replayed;    /**< Outcome of replaying the log on open */
+
+public:
+  /**
+   * @brief Open or create a journaled map.
+   *
+   * @param path Path prefix of the snapshot and log files.
+   * @param options Commit policy.
+   * @throws std::runtime_error if the files cannot be read or written, or
+   * the log extends a snapshot that is missing.
+   */
+  explicit JournaledMultiMap(const std::string &path,
+                             const JournalOptions &options = {})
+      : log_file(path + ".log"), snapshot_file(path + ".snap"),
+        options(options) {
+    if (detail::file_exists(snapshot_file)) {
+      auto snapshot = load_mmap<K, V>(snapshot_file);
+      mm = snapshot.template materialize<map_type>();
+      base = snapshot.checksum();
+    }
+    if (detail::file_exists(log_file)) {
+      uint64_t log_base = detail::journal_base<K, V>(log_file);
+      if (log_base == base) {
+        replayed = replay(log_file, mm);
+      } else if (base == 0) {
+        throw std::runtime_error("JournaledMultiMap: " + log_file +
+                                 " extends a missing snapshot");
+      }
+      // Otherwise the log was folded into the snapshot by a compaction
+      // that stopped before replacing it
+    }
+
+    fd = detail::open_log(log_file, replayed.valid_bytes);
+    committed = replayed.valid_bytes;
+    if (committed == 0) {
+      try {
+        write_header(fd, log_file, base);
+      } catch (...) {
+        ::close(fd);
+        throw;
+      }
+      committed = sizeof(detail::JournalHeader);
+    }
+  }
+
+  JournaledMultiMap(const JournaledMultiMap &) = delete;
+  JournaledMultiMap &operator=(const JournaledMultiMap &) = delete;
+
+  /**
+   * @brief Commit pending records and close the log. Write errors are
+   * swallowed here; call commit() first to see them.
+   */
+  ~JournaledMultiMap() {
+    try {
+      commit();
+    } catch (...) {
+    }
+    ::close(fd);
+  }
+
+  // Modifiers
+
+  /**
+   * @brief Append a value under key and log it.
+   *
+   * @param key Key to append to.
+   * @param value Value to append.
+   */
+  void emplace(K key, V value) {
+    record(
+        detail::JournalOp::emplace,
+        [&] {
+          mm.try_emplace(std::move(key), std::move(value));
+          return true;
+        },
+        key, value);
+  }
+
+  /**
+   * @brief Erase all values of a key, logging it if any were erased.
+   *
+   * @param key Key to erase.
+   * @return size_type Number of values erased.
+   */
+  size_type erase(const K &key) {
+    size_type erased = 0;
+    record(
+        detail::JournalOp::erase_key,
+        [&] {
+          erased = mm.erase(key);
+          return erased != 0;
+        },
+        key);
+    return erased;
+  }
+
+  /**
+   * @brief Erase one occurrence of a value from a key, logging it if it
+   * was erased.
+   *
+   * @param key Key to erase from.
+   * @param value Value to erase.
+   * @return true if value was erased, false otherwise.
+   */
+  bool erase(const K &key, const V &value) {
+    bool erased = false;
+    record(
+        detail::JournalOp::erase_value,
+        [&] {
+          erased = mm.erase(key, value);
+          return erased;
+        },
+        key, value);
+    return erased;
+  }
+
+  /**
+   * @brief Erase everything, logging it if the map was not empty.
+   */
+  void clear() {
+    record(detail::JournalOp::clear, [&] {
+      bool any = !mm.empty();
+      mm.clear();
+      return any;
+    });
+  }
+
+  // Persistence
+
+  /**
+   * @brief Write the pending records to the log, and fsync it if
+   * options.sync is set.
+   *
+   * @throws std::runtime_error if the log cannot be written. The records
+   * stay pending and the next commit retries them.
+   */
+  void commit() {
+    if (pending.empty()) {
+      return;
+    }
+    if (log_lost) {
+      throw std::runtime_error("JournaledMultiMap: " + log_file +
+                               " was not replaced, call compact()");
+    }
+    detail::write_at(fd, pending.data(), pending.size(), committed,
+                     log_file);
+    if (options.sync) {
+      detail::sync_fd(fd, log_file);
+    }
+    committed += pending.size();
+    pending.clear();
+  }
+
+  /**
+   * @brief Fold the log into a new snapshot and start an empty log.
+   *
+   * The snapshot and the new log are each written to a temporary file
+   * and fsync'ed before either is renamed into place, and the directory
+   * is fsync'ed after each rename, so a crash at any point leaves either
+   * the old or the new state on disk.
+   *
+   * @throws std::runtime_error if a file cannot be written. If that
+   * happens before the snapshot is replaced, nothing changed. Otherwise
+   * the old log no longer applies: commit() throws and pending records
+   * stay in memory until a later compact() succeeds.
+   */
+  void compact() {
+    if (!log_lost) {
+      commit();
+    }
+    std::string snapshot_tmp = snapshot_file + ".tmp";
+    std::string log_tmp = log_file + ".tmp";
+    save_binary(mm, snapshot_tmp);
+    uint64_t checksum = load_mmap<K, V>(snapshot_tmp, false).checksum();
+
+    int next = detail::open_log(log_tmp, 0);
+    try {
+      write_header(next, log_tmp, checksum);
+      detail::sync_fd(next, log_tmp);
+      rename_file(snapshot_tmp, snapshot_file);
+    } catch (...) {
+      ::close(next);
+      std::remove(log_tmp.c_str());
+      throw;
+    }
+
+    // The new snapshot is in place and holds every record, pending ones
+    // included. The old log reads as folded into it, so records must go
+    // to the new log from here on
+    pending.clear();
+    base = checksum;
+    ::close(fd);
+    fd = next;
+    committed = sizeof(detail::JournalHeader);
+    log_lost = true;
+    detail::fsync_parent_dir(snapshot_file, "JournaledMultiMap");
+    rename_file(log_tmp, log_file);
+    log_lost = false;
+    detail::fsync_parent_dir(log_file, "JournaledMultiMap");
+  }
+
+  // Lookup methods
+
+  /**
+   * @brief Get the current contents, read-only.
+   *
+   * @return const map_type& The wrapped map.
+   */
+  const map_type &map() const { return mm; }
+
+  [[nodiscard]] view_type view(const K &key) const { return mm.view(key); }
+  size_type count(const K &key) const { return mm.count(key); }
+  bool contains(const K &key) const { return mm.contains(key); }
+
+  [[nodiscard]] size_type size() const { return mm.size(); }
+  [[nodiscard]] size_type key_count() const { return mm.key_count(); }
+  [[nodiscard]] bool empty() const { return mm.empty(); }
+
+  /**
+   * @brief Estimate the bytes this map occupies: the wrapped map's
+   * MultiMap::memory_usage(), with the pending batch and file names as
+   * structure.
+   *
+   * @return MemoryUsage The breakdown.
+   */
+  [[nodiscard]] MemoryUsage memory_usage() const {
+    MemoryUsage usage = mm.memory_usage();
+    usage.object = sizeof(*this);
+    MemoryUsage buffers;
+    for (const std::string *s : {&pending, &log_file, &snapshot_file}) {
+      HeapUsage<std::string>::add(*s, buffers);
+    }
+    usage.structure += buffers.payload;
+    usage.allocator += buffers.allocator;
+    usage.allocations += buffers.allocations;
+    return usage;
+  }
+
+  // Log state
+
+  /**
+   * @brief Get the number of bytes of records not yet committed.
+   *
+   * @return size_t Size of the pending batch.
+   */
+  [[nodiscard]] size_t pending_bytes() const { return pending.size(); }
+
+  /**
+   * @brief Get the size of the log on disk, header included.
+   *
+   * @return uint64_t Committed bytes.
+   */
+  [[nodiscard]] uint64_t log_bytes() const { return committed; }
+
+  /**
+   * @brief Get the outcome of replaying the log when the map was opened.
+   *
+   * @return const JournalReplay& Records applied and whether a torn tail
+   * was dropped.
+   */
+  const JournalReplay &recovery() const { return replayed; }
+
+  const std::string &log_path() const { return log_file; }
+  const std::string &snapshot_path() const { return snapshot_file; }
+
+private:
+  /**
+   * @brief Encode a record, run apply, and keep the record only if apply
+   * returns true. Nothing is logged if apply or the encoding throws.
+   */
+  template <typename Apply, typename... Fields>
+  void record(detail::JournalOp op, Apply &&apply, const Fields &...fields) {
+    size_t start = pending.size();
+    try {
+      detail::append_record(pending, op, fields...);
+      if (!apply()) {
+        pending.resize(start);
+        return;
+      }
+    } catch (...) {
+      pending.resize(start);
+      throw;
+    }
+    if (pending.size() >= options.group_bytes) {
+      commit();
+    }
+  }
+
+  static void write_header(int to, const std::string &path, uint64_t base) {
+    auto header = detail::journal_header<K, V>(base);
+    detail::write_at(to, reinterpret_cast<const char *>(&header),
+                     sizeof(header), 0, path);
+  }
+
+  static void rename_file(const std::string &from, const std::string &to) {
+    if (std::rename(from.c_str(), to.c_str()) != 0) {
+      throw std::runtime_error("JournaledMultiMap: cannot rename " + from);
+    }
+  }
+};
+
+} // namespace dictool
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace dictool {
+
+/**
+ * @brief Read-only memory mapping of a whole file (POSIX mmap).
+ */
+class MappedFile {
+private:
+  const char *ptr = nullptr; /**< Start of the mapping */
+  size_t len = 0;            /**< Length of the file */
+
+public:
+  MappedFile() = default;
+
+  /**
+   * @brief Map a file read-only.
+   *
+   * @param path File to map.
+   * @throws std::runtime_error if the file cannot be opened or mapped.
+   */
+  explicit MappedFile(const std::string &path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      throw std::runtime_error("MappedFile: cannot open " + path);
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+      ::close(fd);
+      throw std::runtime_error("MappedFile: cannot stat " + path);
+    }
+    len = static_cast<size_t>(st.st_size);
+    if (len > 0) {
+      void *p = ::mmap(nullptr, len, PROT_READ, MAP_SHARED, fd, 0);
+      if (p == MAP_FAILED) {
+        ::close(fd);
+        throw std::runtime_error("MappedFile: cannot map " + path);
+      }
+      ptr = static_cast<const char *>(p);
+    }
+    ::close(fd);
+  }
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  MappedFile(MappedFile &&other) noexcept
+      : ptr(std::exchange(other.ptr, nullptr)),
+        len(std::exchange(other.len, 0)) {}
+
+  MappedFile &operator=(MappedFile &&other) noexcept {
+    if (this != &other) {
+      unmap();
+      ptr = std::exchange(other.ptr, nullptr);
+      len = std::exchange(other.len, 0);
+    }
+    return *this;
+  }
+
+  ~MappedFile() { unmap(); }
+
+  const char *data() const { return ptr; }
+  [[nodiscard]] size_t size() const { return len; }
+
+  /**
+   * @brief Tell the kernel the mapping will be read front to back, so it
+   * reads ahead aggressively. Only a hint; failures are ignored.
+   */
+  void advise_sequential() const {
+    if (ptr != nullptr) {
+      ::madvise(const_cast<char *>(ptr), len, MADV_SEQUENTIAL);
+    }
+  }
+
+private:
+  void unmap() {
+    if (ptr != nullptr) {
+      ::munmap(const_cast<char *>(ptr), len);
+      ptr = nullptr;
+    }
+  }
+};
+
+namespace detail {
+
+/** fsync a file by path; who prefixes the error message */
+inline void fsync_path(const std::string &path, const char *who) {
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error(std::string(who) + ": cannot open " + path);
+  }
+  int rc = ::fsync(fd);
+  ::close(fd);
+  if (rc != 0) {
+    throw std::runtime_error(std::string(who) + ": cannot sync " + path);
+  }
+}
+
+/** fsync the directory holding path, making a rename into it durable */
+inline void fsync_parent_dir(const std::string &path, const char *who) {
+  size_t slash = path.find_last_of('/');
+  std::string dir = slash == std::string::npos ? "."
+                    : slash == 0               ? "/"
+                                               : path.substr(0, slash);
+  int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+  if (fd < 0) {
+    throw std::runtime_error(std::string(who) + ": cannot open " + dir);
+  }
+  int rc = ::fsync(fd);
+  ::close(fd);
+  if (rc != 0) {
+    throw std::runtime_error(std::string(who) + ": cannot sync " + dir);
+  }
+}
+
+/**
+ * @brief Atomically replace to with from, then fsync the directory so the
+ * rename survives a crash. Readers that mapped the old file keep seeing
+ * it, as it is unlinked rather than rewritten.
+ */
+inline void rename_durably(const std::string &from, const std::string &to,
+                           const char *who) {
+  if (std::rename(from.c_str(), to.c_str()) != 0) {
+    throw std::runtime_error(std::string(who) + ": cannot rename " + from);
+  }
+  fsync_parent_dir(to, who);
+}
+
+} // namespace detail
+
+} // namespace dictool
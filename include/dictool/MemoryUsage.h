@@ -0,0 +1,407 @@
+#pragma once
+
+#include "dictool/Traits.h"
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <map>
+#include <ostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace dictool {
+
+/**
+ * @brief Estimated memory footprint of a container, broken down by what
+ * the bytes are spent on, as returned by the memory_usage() members.
+ *
+ * Node sizes follow the libstdc++ layouts and heap blocks the glibc
+ * malloc chunk sizes, so the figures are estimates of the real footprint
+ * rather than exact counts. The estimates come from the HeapUsage,
+ * ContainerUsage and DictionaryUsage traits, which can be specialized for
+ * other element types, value containers and dictionaries.
+ */
+struct MemoryUsage {
+  size_t object = 0; /**< The top-level objects themselves */
+  /**
+   * Dictionary overhead: node links, bucket arrays, control bytes, empty
+   * slots, padding and internal buffers.
+   */
+  size_t structure = 0;
+  size_t keys = 0;        /**< Keys, sizeof(K) each */
+  size_t headers = 0;     /**< Value container objects, one per key */
+  size_t values = 0;      /**< Values, sizeof(V) each */
+  size_t value_nodes = 0; /**< Node links of node-based value containers */
+  size_t slack = 0;       /**< Reserved but unused element capacity */
+  size_t payload = 0;     /**< Heap memory owned by keys and values */
+  size_t allocator = 0;   /**< Estimated malloc headers and rounding */
+  size_t allocations = 0; /**< Estimated number of heap blocks */
+  size_t mapped = 0;      /**< File bytes mapped read-only, not in total() */
+
+  /**
+   * @brief Get the estimated footprint in bytes, excluding mapped file
+   * bytes, which live in the page cache.
+   *
+   * @return size_t Sum of all byte counts but mapped.
+   */
+  [[nodiscard]] size_t total() const {
+    return object + structure + keys + headers + values + value_nodes +
+           slack + payload + allocator;
+  }
+
+  /**
+   * @brief Record heap blocks of the given size. The bytes themselves are
+   * counted by the caller in the field they belong to; this adds the
+   * blocks and their estimated malloc overhead.
+   *
+   * @param bytes Requested size of each block.
+   * @param count Number of blocks.
+   */
+  void add_block(size_t bytes, size_t count = 1) {
+    // glibc: an 8-byte header, 16-byte granularity, 32-byte minimum chunk
+    size_t chunk = (bytes + sizeof(size_t) + 2 * sizeof(size_t) - 1) &
+                   ~(2 * sizeof(size_t) - 1);
+    chunk = chunk < 4 * sizeof(size_t) ? 4 * sizeof(size_t) : chunk;
+    allocator += count * (chunk - bytes);
+    allocations += count;
+  }
+
+  MemoryUsage &operator+=(const MemoryUsage &other) {
+    object += other.object;
+    structure += other.structure;
+    keys += other.keys;
+    headers += other.headers;
+    values += other.values;
+    value_nodes += other.value_nodes;
+    slack += other.slack;
+    payload += other.payload;
+    allocator += other.allocator;
+    allocations += other.allocations;
+    mapped += other.mapped;
+    return *this;
+  }
+
+  /**
+   * @brief Write the breakdown as one JSON object, with the total.
+   *
+   * @param os Stream to write to.
+   */
+  void write_json(std::ostream &os) const {
+    os << "{\"object\":" << object << ",\"structure\":" << structure
+       << ",\"keys\":" << keys << ",\"headers\":" << headers
+       << ",\"values\":" << values << ",\"value_nodes\":" << value_nodes
+       << ",\"slack\":" << slack << ",\"payload\":" << payload
+       << ",\"allocator\":" << allocator
+       << ",\"allocations\":" << allocations << ",\"mapped\":" << mapped
+       << ",\"total\":" << total() << "}";
+  }
+
+  /**
+   * @brief Get the breakdown as a JSON string, see write_json().
+   *
+   * @return std::string JSON object.
+   */
+  [[nodiscard]] std::string to_json() const {
+    std::ostringstream os;
+    write_json(os);
+    return os.str();
+  }
+
+  /**
+   * @brief Write the breakdown as human-readable text, one line per field.
+   *
+   * @param os Stream to write to.
+   */
+  void print(std::ostream &os) const {
+    os << "Total bytes: " << total() << "\n";
+    os << "  object: " << object << "\n";
+    os << "  structure: " << structure << "\n";
+    os << "  keys: " << keys << "\n";
+    os << "  headers: " << headers << "\n";
+    os << "  values: " << values << "\n";
+    os << "  value nodes: " << value_nodes << "\n";
+    os << "  slack: " << slack << "\n";
+    os << "  payload: " << payload << "\n";
+    os << "  allocator: " << allocator << " (" << allocations
+       << " blocks)\n";
+    if (mapped != 0) {
+      os << "Mapped bytes: " << mapped << "\n";
+    }
+  }
+};
+
+/**
+ * @brief Heap memory owned by one key or value, beyond sizeof(T). The
+ * primary template owns none; specialize it for types that allocate, with
+ * owns_heap = true and an add() recording the bytes in usage.payload and
+ * each block through usage.add_block().
+ *
+ * @tparam T The element type.
+ * @tparam void SFINAE parameter.
+ */
+template <typename T, typename = void> struct HeapUsage {
+  static constexpr bool owns_heap = false; /**< add() is a no-op */
+
+  static void add(const T &, MemoryUsage &) {}
+};
+
+template <typename C, typename Traits, typename Alloc>
+struct HeapUsage<std::basic_string<C, Traits, Alloc>> {
+  static constexpr bool owns_heap = true;
+
+  static void add(const std::basic_string<C, Traits, Alloc> &s,
+                  MemoryUsage &usage) {
+    // Short strings live in the object itself
+    auto *object = reinterpret_cast<const char *>(&s);
+    auto *chars = reinterpret_cast<const char *>(s.data());
+    if (chars < object || chars >= object + sizeof(s)) {
+      size_t bytes = (s.capacity() + 1) * sizeof(C);
+      usage.payload += bytes;
+      usage.add_block(bytes);
+    }
+  }
+};
+
+template <typename T, typename Alloc>
+struct HeapUsage<std::vector<T, Alloc>> {
+  static constexpr bool owns_heap = true;
+
+  static void add(const std::vector<T, Alloc> &v, MemoryUsage &usage) {
+    if (v.capacity() != 0) {
+      usage.payload += v.capacity() * sizeof(T);
+      usage.add_block(v.capacity() * sizeof(T));
+    }
+    if constexpr (HeapUsage<T>::owns_heap) {
+      for (const T &item : v) {
+        HeapUsage<T>::add(item, usage);
+      }
+    }
+  }
+};
+
+template <typename A, typename B> struct HeapUsage<std::pair<A, B>> {
+  static constexpr bool owns_heap =
+      HeapUsage<std::remove_const_t<A>>::owns_heap ||
+      HeapUsage<std::remove_const_t<B>>::owns_heap;
+
+  static void add(const std::pair<A, B> &p, MemoryUsage &usage) {
+    HeapUsage<std::remove_const_t<A>>::add(p.first, usage);
+    HeapUsage<std::remove_const_t<B>>::add(p.second, usage);
+  }
+};
+
+namespace detail {
+
+constexpr size_t align_to(size_t n, size_t alignment) {
+  return (n + alignment - 1) / alignment * alignment;
+}
+
+/** Size of a node with link_bytes of links before a T, plus a trailer */
+template <typename T>
+constexpr size_t node_size(size_t link_bytes, size_t trailer = 0) {
+  size_t align = alignof(T) > alignof(void *) ? alignof(T) : alignof(void *);
+  size_t size = align_to(link_bytes, alignof(T)) + sizeof(T);
+  if (trailer != 0) {
+    size = align_to(size, alignof(size_t)) + trailer;
+  }
+  return align_to(size, align);
+}
+
+/** libstdc++ red-black tree node: color and three links */
+template <typename T> constexpr size_t tree_node_size() {
+  return node_size<T>(4 * sizeof(void *));
+}
+
+/** libstdc++ doubly linked list node */
+template <typename T> constexpr size_t list_node_size() {
+  return node_size<T>(2 * sizeof(void *));
+}
+
+/**
+ * @brief Whether libstdc++ stores the hash code in each node: when the
+ * hash may throw, and for the string hashes it deems slow.
+ */
+template <typename Key, typename Hash> constexpr bool caches_hash() {
+  if constexpr (!std::is_nothrow_invocable_v<const Hash &, const Key &>) {
+    return true;
+  } else {
+    return std::is_same_v<Hash, std::hash<std::string>> ||
+           std::is_same_v<Hash, std::hash<std::wstring>>;
+  }
+}
+
+/** libstdc++ hash table node: next link, element, maybe the hash code */
+template <typename T, typename Key, typename Hash>
+constexpr size_t hash_node_size() {
+  return node_size<T>(sizeof(void *),
+                      caches_hash<Key, Hash>() ? sizeof(size_t) : 0);
+}
+
+/** Bucket array of a libstdc++ hash table; one bucket lives inline */
+inline void add_buckets(size_t bucket_count, size_t &field,
+                        MemoryUsage &usage) {
+  if (bucket_count > 1) {
+    field += bucket_count * sizeof(void *);
+    usage.add_block(bucket_count * sizeof(void *));
+  }
+}
+
+/** Add the heap memory owned by each element of a range */
+template <typename T, typename Range>
+void add_payload(const Range &range, MemoryUsage &usage) {
+  if constexpr (HeapUsage<T>::owns_heap) {
+    for (const auto &item : range) {
+      HeapUsage<T>::add(item, usage);
+    }
+  }
+}
+
+/**
+ * @brief Add a std::vector's live elements to field, its spare capacity
+ * to slack, and its block and element payload.
+ */
+template <typename T, typename Alloc>
+void add_vector(const std::vector<T, Alloc> &v, size_t &field,
+                MemoryUsage &usage) {
+  field += v.size() * sizeof(T);
+  usage.slack += (v.capacity() - v.size()) * sizeof(T);
+  if (v.capacity() != 0) {
+    usage.add_block(v.capacity() * sizeof(T));
+  }
+  add_payload<T>(v, usage);
+}
+
+/** Add n nodes of node_bytes each, holding one T each */
+template <typename T>
+void add_nodes(size_t n, size_t node_bytes, size_t &links,
+               MemoryUsage &usage) {
+  links += n * (node_bytes - sizeof(T));
+  usage.add_block(node_bytes, n);
+}
+
+} // namespace detail
+
+/**
+ * @brief Footprint of one MultiMap value container: its object in
+ * usage.headers, its elements in usage.values, spare capacity in
+ * usage.slack, node links in usage.value_nodes, and the elements' own
+ * heap memory. The primary template treats containers with capacity() as
+ * one contiguous block (std::vector-like) and others as plain element
+ * storage; specialize it for other layouts.
+ *
+ * @tparam C The value container type.
+ * @tparam void SFINAE parameter.
+ */
+template <typename C, typename = void> struct ContainerUsage {
+  static void add(const C &c, MemoryUsage &usage) {
+    using T = typename C::value_type;
+    usage.headers += sizeof(C);
+    usage.values += c.size() * sizeof(T);
+    if constexpr (HasCapacity<C>::value) {
+      usage.slack += (c.capacity() - c.size()) * sizeof(T);
+      if (c.capacity() != 0) {
+        usage.add_block(c.capacity() * sizeof(T));
+      }
+    }
+    detail::add_payload<T>(c, usage);
+  }
+};
+
+/** Ordered sets: one tree node per element */
+template <typename C>
+struct ContainerUsage<
+    C, std::enable_if_t<
+           std::is_same_v<C, std::set<typename C::key_type,
+                                      typename C::key_compare,
+                                      typename C::allocator_type>> ||
+           std::is_same_v<C, std::multiset<typename C::key_type,
+                                           typename C::key_compare,
+                                           typename C::allocator_type>>>> {
+  static void add(const C &c, MemoryUsage &usage) {
+    using T = typename C::value_type;
+    usage.headers += sizeof(C);
+    usage.values += c.size() * sizeof(T);
+    detail::add_nodes<T>(c.size(), detail::tree_node_size<T>(),
+                         usage.value_nodes, usage);
+    detail::add_payload<T>(c, usage);
+  }
+};
+
+/** Hashed sets: one node per element and a bucket array */
+template <typename C>
+struct ContainerUsage<
+    C, std::enable_if_t<
+           std::is_same_v<C, std::unordered_set<typename C::key_type,
+                                                typename C::hasher,
+                                                typename C::key_equal,
+                                                typename C::allocator_type>> ||
+           std::is_same_v<C, std::unordered_multiset<
+                                 typename C::key_type, typename C::hasher,
+                                 typename C::key_equal,
+                                 typename C::allocator_type>>>> {
+  static void add(const C &c, MemoryUsage &usage) {
+    using T = typename C::value_type;
+    usage.headers += sizeof(C);
+    usage.values += c.size() * sizeof(T);
+    detail::add_nodes<T>(
+        c.size(),
+        detail::hash_node_size<T, typename C::key_type, typename C::hasher>(),
+        usage.value_nodes, usage);
+    detail::add_buckets(c.bucket_count(), usage.value_nodes, usage);
+    detail::add_payload<T>(c, usage);
+  }
+};
+
+/** Lists: one doubly linked node per element */
+template <typename T, typename Alloc>
+struct ContainerUsage<std::list<T, Alloc>> {
+  static void add(const std::list<T, Alloc> &c, MemoryUsage &usage) {
+    usage.headers += sizeof(c);
+    usage.values += c.size() * sizeof(T);
+    detail::add_nodes<T>(c.size(), detail::list_node_size<T>(),
+                         usage.value_nodes, usage);
+    detail::add_payload<T>(c, usage);
+  }
+};
+
+/**
+ * @brief Footprint of a MultiMap's key to container dictionary, without
+ * the dictionary object itself: node links, buckets and padding in
+ * usage.structure, keys in usage.keys with their heap memory, and each
+ * container through ContainerUsage. The primary template handles the
+ * libstdc++ node-based maps, hashed when the dictionary has a hasher and
+ * ordered otherwise; specialize it for other dictionaries.
+ *
+ * @tparam D The dictionary type.
+ * @tparam void SFINAE parameter.
+ */
+template <typename D, typename = void> struct DictionaryUsage {
+  static void add(const D &d, MemoryUsage &usage) {
+    using K = typename D::key_type;
+    using C = typename D::mapped_type;
+    using Node = typename D::value_type;
+
+    size_t node_bytes;
+    if constexpr (HasHasher<D>::value) {
+      node_bytes = detail::hash_node_size<Node, K, typename D::hasher>();
+      detail::add_buckets(d.bucket_count(), usage.structure, usage);
+    } else {
+      node_bytes = detail::tree_node_size<Node>();
+    }
+    detail::add_nodes<Node>(d.size(), node_bytes, usage.structure, usage);
+    usage.structure += d.size() * (sizeof(Node) - sizeof(K) - sizeof(C));
+    usage.keys += d.size() * sizeof(K);
+    for (const auto &[key, container] : d) {
+      HeapUsage<K>::add(key, usage);
+      ContainerUsage<C>::add(container, usage);
+    }
+  }
+};
+
+} // namespace dictool
@@ -1,10 +1,22 @@
-#ifndef __SMART_DICT_H__
-#define __SMART_DICT_H__
+#pragma once
 
+#include "dictool/MemoryUsage.h"
+#include "dictool/Stats.h"
+#include "dictool/Traits.h"
+#include "dictool/View.h"
 #include <algorithm>
+#include <cstddef>
+#include <functional>
 #include <iostream>
+#include <iterator>
 #include <map>
+#include <memory>
+#include <optional>
 #include <set>
+#include <stdexcept>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace dictool {
@@ -66,6 +78,286 @@ template <typename T> constexpr bool has_emplace_value() {
   return HasEmplaceValue<T>::value;
 }
 
+/**
+ * @brief Type trait to check if an argument pack starts with
+ * std::piecewise_construct.
+ *
+ * @tparam Args The argument types to check.
+ */
+template <typename... Args> struct IsPiecewise : std::false_type {};
+
+/**
+ * @brief Specialization that inspects the first argument type.
+ *
+ * @tparam First The first argument type.
+ * @tparam Rest The remaining argument types.
+ */
+template <typename First, typename... Rest>
+struct IsPiecewise<First, Rest...>
+    : std::is_same<std::decay_t<First>, std::piecewise_construct_t> {};
+
+/**
+ * @brief Type trait to check if a dictionary has a transparent comparator.
+ *
+ * @tparam T The dictionary type to check.
+ * @tparam void SFINAE parameter.
+ */
+template <typename T, typename = void>
+struct HasTransparentCompare : std::false_type {};
+
+template <typename T>
+struct HasTransparentCompare<
+    T, std::void_t<typename T::key_compare::is_transparent>>
+    : std::true_type {};
+
+/**
+ * @brief Type trait to check if a dictionary has a transparent hasher and
+ * key equality.
+ *
+ * @tparam T The dictionary type to check.
+ * @tparam void SFINAE parameter.
+ */
+template <typename T, typename = void>
+struct HasTransparentHash : std::false_type {};
+
+template <typename T>
+struct HasTransparentHash<T,
+                          std::void_t<typename T::hasher::is_transparent,
+                                      typename T::key_equal::is_transparent>>
+    : std::true_type {};
+
+/**
+ * @brief Type trait to check if a dictionary can be probed with a key-like
+ * type without converting it to its key_type first.
+ *
+ * @tparam T The dictionary type to check.
+ * @tparam KL The key-like type used for the lookup.
+ * @tparam void SFINAE parameter.
+ */
+template <typename T, typename KL, typename = void>
+struct HasHeterogeneousFind : std::false_type {};
+
+template <typename T, typename KL>
+struct HasHeterogeneousFind<
+    T, KL,
+    std::void_t<decltype(std::declval<const T &>().find(
+        std::declval<const KL &>()))>>
+    : std::bool_constant<HasTransparentCompare<T>::value ||
+                         HasTransparentHash<T>::value> {};
+
+/**
+ * @brief Helper function to check if a dictionary supports heterogeneous
+ * lookup with a key-like type.
+ *
+ * @tparam T The dictionary type to check.
+ * @tparam KL The key-like type used for the lookup.
+ * @return true if T::find accepts KL without a temporary key.
+ */
+template <typename T, typename KL> constexpr bool has_heterogeneous_find() {
+  return HasHeterogeneousFind<T, KL>::value;
+}
+
+/**
+ * @brief Type trait to check if a container has a reserve method.
+ *
+ * @tparam T The container type to check.
+ * @tparam void SFINAE parameter.
+ */
+template <typename T, typename = void> struct HasReserve : std::false_type {};
+
+template <typename T>
+struct HasReserve<T, std::void_t<decltype(std::declval<T>().reserve(
+                         std::declval<typename T::size_type>()))>>
+    : std::true_type {};
+
+/**
+ * @brief Helper function to check if a container has a reserve method.
+ *
+ * @tparam T The container type to check.
+ * @return true if container has reserve, false otherwise.
+ */
+template <typename T> constexpr bool has_reserve() {
+  return HasReserve<T>::value;
+}
+
+/**
+ * @brief Reserve room for n elements, at least doubling the capacity when
+ * it has to grow. Exact reserves repeated with slowly rising n, as when
+ * bulk-loading in chunks, would otherwise reallocate on every call.
+ *
+ * @tparam T The container type, with reserve().
+ * @param c Container to grow.
+ * @param n Number of elements it must hold without reallocating.
+ */
+template <typename T> void reserve_amortized(T &c, size_t n) {
+  if constexpr (HasCapacity<T>::value) {
+    if (n > c.capacity()) {
+      c.reserve(std::max<size_t>(n, 2 * c.capacity()));
+    }
+  } else {
+    c.reserve(n);
+  }
+}
+
+/**
+ * @brief Type trait to check if a container has a shrink_to_fit method.
+ *
+ * @tparam T The container type to check.
+ * @tparam void SFINAE parameter.
+ */
+template <typename T, typename = void>
+struct HasShrinkToFit : std::false_type {};
+
+template <typename T>
+struct HasShrinkToFit<T,
+                      std::void_t<decltype(std::declval<T>().shrink_to_fit())>>
+    : std::true_type {};
+
+/**
+ * @brief Helper function to check if a container has a shrink_to_fit method.
+ *
+ * @tparam T The container type to check.
+ * @return true if container has shrink_to_fit, false otherwise.
+ */
+template <typename T> constexpr bool has_shrink_to_fit() {
+  return HasShrinkToFit<T>::value;
+}
+
+/**
+ * @brief Type trait to check if a container can splice in another one of the
+ * same type through merge (node-based maps and sets).
+ *
+ * @tparam T The container type to check.
+ * @tparam void SFINAE parameter.
+ */
+template <typename T, typename = void> struct HasMerge : std::false_type {};
+
+template <typename T>
+struct HasMerge<
+    T, std::void_t<decltype(std::declval<T &>().merge(std::declval<T &>()))>>
+    : std::true_type {};
+
+/**
+ * @brief Helper function to check if a container has a merge method.
+ *
+ * @tparam T The container type to check.
+ * @return true if container has merge, false otherwise.
+ */
+template <typename T> constexpr bool has_merge() { return HasMerge<T>::value; }
+
+/**
+ * @brief Type trait to check if a dictionary is ordered by a comparator.
+ *
+ * @tparam T The dictionary type to check.
+ * @tparam void SFINAE parameter.
+ */
+template <typename T, typename = void>
+struct HasKeyCompare : std::false_type {};
+
+template <typename T>
+struct HasKeyCompare<T, std::void_t<typename T::key_compare,
+                                    decltype(std::declval<T>().key_comp())>>
+    : std::true_type {};
+
+/**
+ * @brief Type trait to check if a dictionary reports its load factor.
+ *
+ * @tparam T The dictionary type to check.
+ * @tparam void SFINAE parameter.
+ */
+template <typename T, typename = void>
+struct HasLoadFactor : std::false_type {};
+
+template <typename T>
+struct HasLoadFactor<
+    T, std::void_t<decltype(std::declval<const T &>().load_factor())>>
+    : std::true_type {};
+
+/**
+ * @brief Type trait to check if a dictionary reports its bucket count.
+ *
+ * @tparam T The dictionary type to check.
+ * @tparam void SFINAE parameter.
+ */
+template <typename T, typename = void>
+struct HasBucketCount : std::false_type {};
+
+template <typename T>
+struct HasBucketCount<
+    T, std::void_t<decltype(std::declval<const T &>().bucket_count())>>
+    : std::true_type {};
+
+/**
+ * @brief Type trait to check if a dictionary is node based, i.e. references
+ * to its elements survive rehashing.
+ *
+ * @tparam T The dictionary type to check.
+ * @tparam void SFINAE parameter.
+ */
+template <typename T, typename = void>
+struct HasNodeType : std::false_type {};
+
+template <typename T>
+struct HasNodeType<T, std::void_t<typename T::node_type>> : std::true_type {};
+
+/**
+ * @brief Type trait to check if a container is allocator-aware.
+ *
+ * @tparam T The container type to check.
+ * @tparam void SFINAE parameter.
+ */
+template <typename T, typename = void>
+struct HasAllocator : std::false_type {};
+
+template <typename T>
+struct HasAllocator<T,
+                    std::void_t<typename T::allocator_type,
+                                decltype(std::declval<const T &>()
+                                             .get_allocator())>>
+    : std::true_type {};
+
+/**
+ * @brief Allocator type of a container, std::allocator for containers that
+ * do not take one.
+ *
+ * @tparam T The container type.
+ * @tparam void SFINAE parameter.
+ */
+template <typename T, typename = void> struct AllocatorOf {
+  using type = std::allocator<typename T::value_type>;
+};
+
+template <typename T>
+struct AllocatorOf<T, std::void_t<typename T::allocator_type>> {
+  using type = typename T::allocator_type;
+};
+
+/**
+ * @brief Check whether nodes of b can be spliced into a, which requires
+ * equal allocators.
+ *
+ * @tparam T The container type.
+ * @param a Destination container.
+ * @param b Source container.
+ * @return true if a.merge(b) is allowed, false otherwise.
+ */
+template <typename T> bool can_splice(const T &a, const T &b) {
+  if constexpr (HasAllocator<T>::value) {
+    using Traits = std::allocator_traits<typename T::allocator_type>;
+    if constexpr (!Traits::is_always_equal::value) {
+      return a.get_allocator() == b.get_allocator();
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief std::map with a transparent comparator, usable as the DTemplate of
+ * MultiMap to look up e.g. std::string keys by std::string_view.
+ */
+template <typename K, typename V>
+using TransparentMap = std::map<K, V, std::less<>>;
+
 template <typename T, template <typename...> class CTemplate = std::vector>
 static void container_emplace(CTemplate<T> &c, const T &elem) {
   using Container = CTemplate<T>;
@@ -89,16 +381,107 @@ static void container_emplace(CTemplate<T> &c, const T &elem) {
  * std::vector).
  * @tparam DTemplate Dictionary template for storing key-container pairs
  * (default: std::map).
+ * @tparam Stats Instrumentation policy (default: NoStats, which records
+ * nothing and adds no state). CountingStats counts lookups, inserts,
+ * erases, container growths and rehashes; see counters() and stats().
  */
 template <typename K, typename V,
           template <typename...> class CTemplate = std::vector,
-          template <typename...> class DTemplate = std::map>
-class MultiMap {
+          template <typename...> class DTemplate = std::map,
+          typename Stats = NoStats>
+class MultiMap : private Stats {
 private:
   using Container = CTemplate<V>; /**< Type of the value container */
   using Dict =
       DTemplate<K, Container>; /**< Type of the underlying dictionary */
   Dict data;                   /**< The underlying data storage */
+  size_t values = 0;           /**< Running total of values in all keys */
+  bool values_stale = false;   /**< Set by operator[] until recount() */
+
+  /** Walk all keys and sum their values, for when the count is stale */
+  size_t count_values() const {
+    size_t n = 0;
+    for (const auto &pair : data) {
+      n += pair.second.size();
+    }
+    return n;
+  }
+
+  /** The instrumentation policy, an empty base unless it counts */
+  const Stats &policy() const { return *this; }
+
+  void add_values(size_t n) {
+    values += n;
+    policy().on_insert(n);
+  }
+
+  void remove_values(size_t n) {
+    values -= n;
+    policy().on_erase(n);
+  }
+
+  /** Capacity of a value container, or 0 when growths are not counted */
+  static size_t capacity_of(const Container &c) {
+    if constexpr (Stats::enabled && HasCapacity<Container>::value) {
+      return c.capacity();
+    } else {
+      return 0;
+    }
+  }
+
+  /** Report a growth if c's capacity is no longer before */
+  void note_growth(const Container &c, size_t before) const {
+    if (capacity_of(c) != before) {
+      policy().on_growth();
+    }
+  }
+
+  /** Bucket count of the dictionary, or 0 when rehashes are not counted */
+  size_t bucket_count_of() const {
+    if constexpr (Stats::enabled && HasBucketCount<Dict>::value) {
+      return data.bucket_count();
+    } else {
+      return 0;
+    }
+  }
+
+  /** Find a key's node for a read-only lookup, reporting it to the policy */
+  template <typename Self, typename KL>
+  static auto lookup(Self &self, const KL &key) {
+    auto found = self.data.find(key);
+    self.policy().on_lookup(found != self.data.end());
+    return found;
+  }
+
+  /**
+   * @brief Find the node for a key, adding an empty container if missing.
+   *
+   * One lookup in the underlying dictionary; the key is only copied or moved
+   * in when it is new.
+   *
+   * @param hint Position hint, or nullptr for an unhinted lookup.
+   * @param key Key (or argument convertible to a key) to look up.
+   * @return typename Dict::iterator Node holding the key.
+   */
+  template <typename Hint, typename KArg>
+  typename Dict::iterator find_or_add(Hint hint, KArg &&key) {
+    if constexpr (!std::is_same_v<std::decay_t<KArg>, K>) {
+      return find_or_add(hint, K(std::forward<KArg>(key)));
+    } else {
+      size_t buckets = bucket_count_of();
+      auto it = [&] {
+        if constexpr (std::is_same_v<Hint, std::nullptr_t>) {
+          return data.try_emplace(std::forward<KArg>(key)).first;
+        } else {
+          return data.try_emplace(hint, std::forward<KArg>(key));
+        }
+      }();
+      if (bucket_count_of() != buckets) {
+        policy().on_rehash();
+      }
+      return it;
+    }
+  }
 
   // Static assertion to ensure container has required methods
   static_assert(has_emplace_back<Container>() || has_emplace_value<Container>(),
@@ -115,24 +498,40 @@ public:
   using const_reference = const value_type &; /**< Const reference type */
   using pointer = value_type *;               /**< Pointer type */
   using const_pointer = const value_type *;   /**< Const pointer type */
+  using view_type = ViewOf<Container>; /**< Non-owning view of a key's values */
+  using allocator_type =
+      typename AllocatorOf<Dict>::type; /**< Allocator of the dictionary */
+  using dictionary_type = Dict; /**< Key-container dictionary */
 
   /**
-   * @brief Const iterator for MultiMap.
+   * @brief Iterator for MultiMap.
    *
-   * Provides read-only access to key-value pairs.
+   * Walks every key-value pair and carries real positions in both the outer
+   * dictionary and the inner container, so erase through it is positional.
+   *
+   * @tparam Const true for read-only access to the values.
    */
-  class Iterator {
+  template <bool Const> class BasicIterator {
   private:
     using outer_iterator =
-        typename Dict::const_iterator; /**< Iterator for the outer dictionary */
+        std::conditional_t<Const, typename Dict::const_iterator,
+                           typename Dict::iterator>; /**< Iterator for the
+                                                        outer dictionary */
     using inner_iterator =
-        typename Container::const_iterator; /**< Iterator for the inner
-                                               container */
+        std::conditional_t<Const, typename Container::const_iterator,
+                           typename Container::iterator>; /**< Iterator for
+                                                             the inner
+                                                             container */
+    using inner_reference =
+        typename std::iterator_traits<inner_iterator>::reference;
 
     outer_iterator outer_it;  /**< Current outer iterator position */
     outer_iterator outer_end; /**< End of outer dictionary */
     inner_iterator inner_it;  /**< Current inner iterator position */
 
+    friend class MultiMap;
+    friend class BasicIterator<!Const>;
+
     /**
      * @brief Advance to the next valid position.
      *
@@ -148,6 +547,14 @@ public:
     }
 
   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = typename MultiMap::value_type;
+    using difference_type = ptrdiff_t;
+    using reference = std::pair<const K &, inner_reference>;
+    using pointer = void;
+
+    BasicIterator() = default;
+
     /**
      * @brief Construct a new iterator object.
      *
@@ -155,11 +562,21 @@ public:
      * @param oend End of outer dictionary.
      * @param iit Inner iterator position.
      */
-    Iterator(outer_iterator oit, outer_iterator oend, inner_iterator iit)
+    BasicIterator(outer_iterator oit, outer_iterator oend, inner_iterator iit)
         : outer_it(oit), outer_end(oend), inner_it(iit) {
       advance_to_next_valid();
     }
 
+    /**
+     * @brief Convert a mutable iterator to a const one.
+     *
+     * @param other Mutable iterator at the same position.
+     */
+    template <bool C = Const, typename = std::enable_if_t<C>>
+    BasicIterator(const BasicIterator<false> &other)
+        : outer_it(other.outer_it), outer_end(other.outer_end),
+          inner_it(other.inner_it) {}
+
     /**
      * @brief Get the current key.
      *
@@ -170,32 +587,31 @@ public:
     /**
      * @brief Get the current value.
      *
-     * @return const mapped_type& Const reference to the current value.
+     * @return inner_reference Reference to the current value, const unless
+     * this is a mutable iterator over a sequence container.
      */
-    const mapped_type &value() const { return *inner_it; }
+    inner_reference value() const { return *inner_it; }
 
     /**
      * @brief Convert the current position to a key-value pair.
      *
-     * @return std::pair<const key_type&, const mapped_type&> Key-value pair.
+     * @return reference Key-value pair of references.
      */
-    std::pair<const key_type &, const mapped_type &> to_pair() const {
-      return {key(), value()};
-    }
+    reference to_pair() const { return {key(), value()}; }
 
     /**
      * @brief Dereference operator.
      *
-     * @return std::pair<const K&, const V&> Key-value pair.
+     * @return reference Key-value pair of references.
      */
-    std::pair<const K &, const V &> operator*() const { return to_pair(); }
+    reference operator*() const { return to_pair(); }
 
     /**
      * @brief Pre-increment operator.
      *
      * @return iterator& Reference to the incremented iterator.
      */
-    Iterator &operator++() {
+    BasicIterator &operator++() {
       if (outer_it != outer_end) {
         ++inner_it;
         advance_to_next_valid();
@@ -208,8 +624,8 @@ public:
      *
      * @return iterator Copy of the iterator before incrementing.
      */
-    Iterator operator++(int) {
-      Iterator tmp = *this;
+    BasicIterator operator++(int) {
+      BasicIterator tmp = *this;
       ++(*this);
       return tmp;
     }
@@ -220,7 +636,7 @@ public:
      * @param other Other iterator to compare with.
      * @return true if iterators are equal, false otherwise.
      */
-    bool operator==(const Iterator &other) const {
+    template <bool C> bool operator==(const BasicIterator<C> &other) const {
       return outer_it == other.outer_it &&
              (outer_it == outer_end || inner_it == other.inner_it);
     }
@@ -231,9 +647,76 @@ public:
      * @param other Other iterator to compare with.
      * @return true if iterators are not equal, false otherwise.
      */
-    bool operator!=(const Iterator &other) const { return !(*this == other); }
+    template <bool C> bool operator!=(const BasicIterator<C> &other) const {
+      return !(*this == other);
+    }
   };
 
+  using iterator = BasicIterator<false>;      /**< Mutable iterator */
+  using const_iterator = BasicIterator<true>; /**< Read-only iterator */
+  using Iterator = iterator; /**< Iterator returned by mutating methods */
+
+  /**
+   * @brief Iterator over key groups, yielding (key, view of its values).
+   */
+  class GroupIterator {
+  private:
+    typename Dict::const_iterator it; /**< Current dictionary position */
+
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::pair<const K &, view_type>;
+    using difference_type = ptrdiff_t;
+    using reference = value_type;
+    using pointer = void;
+
+    GroupIterator() = default;
+
+    /**
+     * @brief Construct a group iterator at a dictionary position.
+     *
+     * @param it Dictionary position.
+     */
+    explicit GroupIterator(typename Dict::const_iterator it) : it(it) {}
+
+    /**
+     * @brief Dereference operator.
+     *
+     * @return reference The key and a view of its values.
+     */
+    reference operator*() const { return {it->first, make_view(it->second)}; }
+
+    GroupIterator &operator++() {
+      ++it;
+      return *this;
+    }
+
+    GroupIterator operator++(int) {
+      GroupIterator tmp = *this;
+      ++it;
+      return tmp;
+    }
+
+    bool operator==(const GroupIterator &other) const {
+      return it == other.it;
+    }
+    bool operator!=(const GroupIterator &other) const {
+      return it != other.it;
+    }
+  };
+
+private:
+  /**
+   * @brief Enabled for key-like types the dictionary can compare or hash
+   * directly, so lookups skip building a temporary key.
+   */
+  template <typename KL>
+  using EnableHeterogeneous = std::enable_if_t<
+      !std::is_same_v<std::decay_t<KL>, K> &&
+      !std::is_convertible_v<const KL &, const_iterator> &&
+      has_heterogeneous_find<Dict, KL>()>;
+
+public:
   // ========== std::multimap compatible API ==========
 
   /**
@@ -249,7 +732,7 @@ public:
    * @param last End of the range.
    */
   template <typename InputIt> MultiMap(InputIt first, InputIt last) {
-    insert(first, last);
+    bulk_load(first, last);
   }
 
   /**
@@ -257,7 +740,159 @@ public:
    *
    * @param init Initializer list of key-value pairs.
    */
-  MultiMap(std::initializer_list<value_type> init) { insert(init); }
+  MultiMap(std::initializer_list<value_type> init) {
+    bulk_load(init.begin(), init.end());
+  }
+
+  /**
+   * @brief Construct an empty multimap using an allocator.
+   *
+   * The allocator is handed to the dictionary. With std::pmr containers
+   * (e.g. MultiMap<K, V, std::pmr::vector, std::pmr::map>) the value
+   * containers are built with uses-allocator construction, so keys, nodes
+   * and values all draw from the same memory resource.
+   *
+   * @param alloc Allocator for the dictionary.
+   */
+  explicit MultiMap(const allocator_type &alloc) : data(alloc) {}
+
+  /**
+   * @brief Range constructor using an allocator.
+   *
+   * @tparam InputIt Input iterator type.
+   * @param first Beginning of the range.
+   * @param last End of the range.
+   * @param alloc Allocator for the dictionary.
+   */
+  template <typename InputIt>
+  MultiMap(InputIt first, InputIt last, const allocator_type &alloc)
+      : data(alloc) {
+    bulk_load(first, last);
+  }
+
+  /**
+   * @brief Initializer list constructor using an allocator.
+   *
+   * @param init Initializer list of key-value pairs.
+   * @param alloc Allocator for the dictionary.
+   */
+  MultiMap(std::initializer_list<value_type> init,
+           const allocator_type &alloc)
+      : data(alloc) {
+    bulk_load(init.begin(), init.end());
+  }
+
+  /**
+   * @brief Build a multimap from unsorted key-value pairs.
+   *
+   * See bulk_load().
+   *
+   * @param pairs Key-value pairs in any order.
+   * @return MultiMap The loaded multimap.
+   */
+  static MultiMap from_unsorted(std::vector<std::pair<K, V>> pairs) {
+    MultiMap res;
+    res.bulk_load(std::move(pairs));
+    return res;
+  }
+
+  /**
+   * @brief Build a multimap from an unsorted range of key-value pairs.
+   *
+   * @tparam InputIt Input iterator type.
+   * @param first Beginning of the range.
+   * @param last End of the range.
+   * @return MultiMap The loaded multimap.
+   */
+  template <typename InputIt>
+  static MultiMap from_unsorted(InputIt first, InputIt last) {
+    MultiMap res;
+    res.bulk_load(first, last);
+    return res;
+  }
+
+  MultiMap(const MultiMap &) = default;
+  MultiMap &operator=(const MultiMap &) = default;
+
+  /**
+   * @brief Copy constructor using an allocator.
+   *
+   * @param other MultiMap to copy.
+   * @param alloc Allocator for the copy.
+   */
+  MultiMap(const MultiMap &other, const allocator_type &alloc)
+      : Stats(other), data(other.data, alloc), values(other.values),
+        values_stale(other.values_stale) {}
+
+  /**
+   * @brief Move constructor using an allocator, leaves other empty. The
+   * elements are moved one by one when the allocators differ.
+   *
+   * @param other MultiMap to move from.
+   * @param alloc Allocator for the new multimap.
+   */
+  MultiMap(MultiMap &&other, const allocator_type &alloc)
+      : Stats(other), data(std::move(other.data), alloc), values(other.values),
+        values_stale(other.values_stale) {
+    other.data.clear();
+    other.values = 0;
+    other.values_stale = false;
+  }
+
+  /**
+   * @brief Adopt a key-container dictionary, e.g. one from release(),
+   * without copying its nodes. Walks the keys once to count the values.
+   *
+   * @param dict Dictionary to take over.
+   */
+  explicit MultiMap(dictionary_type &&dict)
+      : data(std::move(dict)), values(count_values()) {}
+
+  /**
+   * @brief Move constructor, leaves other empty with a zero count.
+   * noexcept when moving the dictionary cannot throw.
+   *
+   * @param other MultiMap to move from.
+   */
+  MultiMap(MultiMap &&other) noexcept(
+      std::is_nothrow_move_constructible_v<Dict> &&
+      std::is_nothrow_copy_constructible_v<Stats>)
+      : Stats(other), data(std::move(other.data)), values(other.values),
+        values_stale(other.values_stale) {
+    other.data.clear();
+    other.values = 0;
+    other.values_stale = false;
+  }
+
+  /**
+   * @brief Move assignment, leaves other empty with a zero count.
+   *
+   * noexcept only when the dictionary's move assignment is, i.e. its
+   * allocator propagates or always compares equal. Two std::pmr maps on
+   * different memory resources move element by element, which allocates
+   * and may throw.
+   *
+   * @param other MultiMap to move from.
+   * @return MultiMap& Reference to this multimap.
+   */
+  MultiMap &operator=(MultiMap &&other) noexcept(
+      std::is_nothrow_move_assignable_v<Dict> &&
+      std::is_nothrow_copy_assignable_v<Stats>) {
+    if (this != &other) {
+      Stats::operator=(other);
+      size_type moved = other.size();
+      // If moving element by element throws, both maps are left partly
+      // moved; have size() count them until then
+      values_stale = other.values_stale = true;
+      data = std::move(other.data);
+      values = moved;
+      values_stale = false;
+      other.data.clear();
+      other.values = 0;
+      other.values_stale = false;
+    }
+    return *this;
+  }
 
   // Capacity methods
 
@@ -271,14 +906,39 @@ public:
   /**
    * @brief Get the total number of values in the multimap.
    *
+   * O(1) unless operator[] was called since the last clear() or
+   * recount(); until then every call walks all keys. Never writes to the
+   * map, so concurrent readers may call it.
+   *
    * @return size_type Total number of values.
    */
   [[nodiscard]] size_type size() const {
-    size_type count = 0;
-    for (const auto &pair : data) {
-      count += pair.second.size();
+    return values_stale ? count_values() : values;
+  }
+
+  /**
+   * @brief Take the running count back after writes through operator[].
+   *
+   * Walks all keys once so that size() is O(1) again, and reports the net
+   * change since the count went stale to the Stats policy, as inserts if
+   * values were added and erases if removed. Writes through a reference
+   * from operator[] made after this call are not counted, so call it once
+   * those references are no longer used.
+   */
+  void recount() {
+    if (values_stale) {
+      size_t actual = count_values();
+      // values may have wrapped below zero if erase() removed values that
+      // operator[] added; the modular difference is still the net change
+      size_t added = actual - values;
+      if (static_cast<std::ptrdiff_t>(added) >= 0) {
+        policy().on_insert(added);
+      } else {
+        policy().on_erase(values - actual);
+      }
+      values = actual;
+      values_stale = false;
     }
-    return count;
   }
 
   /**
@@ -288,12 +948,73 @@ public:
    */
   [[nodiscard]] size_type max_size() const { return data.max_size(); }
 
+  /**
+   * @brief Get the allocator of the dictionary.
+   *
+   * @return allocator_type Copy of the allocator.
+   */
+  allocator_type get_allocator() const { return data.get_allocator(); }
+
+  /**
+   * @brief Pre-size the dictionary for a number of keys.
+   *
+   * Only available when the dictionary has reserve (e.g. hashed ones).
+   *
+   * @param key_count Number of keys to make room for.
+   */
+  template <typename D = Dict, typename = std::enable_if_t<has_reserve<D>()>>
+  void reserve(size_type key_count) {
+    data.reserve(key_count);
+  }
+
+  /**
+   * @brief Pre-size the container of a key, adding the key if missing.
+   *
+   * Only available when the container has reserve (e.g. std::vector).
+   *
+   * @param key Key whose container to size.
+   * @param n Number of values to make room for.
+   */
+  template <typename C = Container,
+            typename = std::enable_if_t<has_reserve<C>()>>
+  void reserve_values(const K &key, size_type n) {
+    find_or_add(nullptr, key)->second.reserve(n);
+  }
+
+  /**
+   * @brief Release spare capacity of every container after a load.
+   *
+   * Only available when the container (or the dictionary) has
+   * shrink_to_fit.
+   */
+  template <typename C = Container,
+            typename = std::enable_if_t<has_shrink_to_fit<C>() ||
+                                        has_shrink_to_fit<Dict>()>>
+  void shrink_to_fit() {
+    if constexpr (has_shrink_to_fit<C>()) {
+      for (auto &pair : data) {
+        pair.second.shrink_to_fit();
+      }
+    }
+    if constexpr (has_shrink_to_fit<Dict>()) {
+      data.shrink_to_fit();
+    }
+  }
+
   // Modifiers
 
   /**
    * @brief Clear all data from the multimap.
    */
-  void clear() { data.clear(); }
+  void clear() {
+    if constexpr (Stats::enabled) {
+      recount();
+      policy().on_erase(values);
+    }
+    data.clear();
+    values = 0;
+    values_stale = false;
+  }
 
   // Insert methods
 
@@ -356,11 +1077,102 @@ public:
   template <typename InputIt>
   void insert(const K &key, InputIt first, InputIt last) {
     auto &container = data[key];
+    size_type before = container.size();
+    size_t capacity = capacity_of(container);
     if constexpr (has_emplace_back<Container>()) {
       container.insert(container.end(), first, last);
     } else {
       container.insert(first, last);
     }
+    note_growth(container, capacity);
+    add_values(container.size() - before);
+  }
+
+  /**
+   * @brief Append many key-value pairs at once.
+   *
+   * Ordered dictionaries stable-sort the pairs by key so each key costs one
+   * hinted lookup. Node-based hashed dictionaries look each pair up once and
+   * count the values per key. Other hashed dictionaries sort by hash. Either
+   * way each container is reserved for its final size before the values
+   * are moved in, growing at least geometrically so that repeated loads
+   * stay amortized, and values keep their input order within a key.
+   * The temporary sort and lookup buffers come from the global heap, not
+   * from the multimap's allocator.
+   *
+   * @param pairs Key-value pairs in any order.
+   */
+  void bulk_load(std::vector<std::pair<K, V>> pairs) {
+    if constexpr (HasKeyCompare<Dict>::value) {
+      auto comp = data.key_comp();
+      std::stable_sort(
+          pairs.begin(), pairs.end(),
+          [&](const auto &a, const auto &b) { return comp(a.first, b.first); });
+      load_grouped(
+          pairs.size(), [&](size_t i) -> auto & { return pairs[i]; },
+          [&](size_t i, size_t j) {
+            return !comp(pairs[i].first, pairs[j].first);
+          });
+    } else if constexpr (HasHasher<Dict>::value && HasNodeType<Dict>::value) {
+      std::vector<Container *> slots;
+      slots.reserve(pairs.size());
+      for (auto &pair : pairs) {
+        slots.push_back(&find_or_add(nullptr, std::move(pair.first))->second);
+      }
+      if constexpr (has_reserve<Container>()) {
+        std::unordered_map<Container *, size_type> counts;
+        for (auto *slot : slots) {
+          ++counts[slot];
+        }
+        for (auto &[slot, count] : counts) {
+          size_t capacity = capacity_of(*slot);
+          reserve_amortized(*slot, slot->size() + count);
+          note_growth(*slot, capacity);
+        }
+      }
+      for (size_t i = 0; i < pairs.size(); ++i) {
+        size_type before = slots[i]->size();
+        if constexpr (has_emplace_back<Container>()) {
+          slots[i]->emplace_back(std::move(pairs[i].second));
+        } else {
+          slots[i]->emplace(std::move(pairs[i].second));
+        }
+        add_values(slots[i]->size() - before);
+      }
+    } else if constexpr (HasHasher<Dict>::value) {
+      auto hash = data.hash_function();
+      std::vector<std::pair<size_t, size_t>> order;
+      order.reserve(pairs.size());
+      for (size_t i = 0; i < pairs.size(); ++i) {
+        order.emplace_back(hash(pairs[i].first), i);
+      }
+      // (hash, index) pairs are unique, so this keeps input order per key
+      std::sort(order.begin(), order.end());
+      auto equal = data.key_eq();
+      load_grouped(
+          pairs.size(),
+          [&](size_t i) -> auto & { return pairs[order[i].second]; },
+          [&](size_t i, size_t j) {
+            return order[i].first == order[j].first &&
+                   equal(pairs[order[i].second].first,
+                         pairs[order[j].second].first);
+          });
+    } else {
+      for (auto &[key, value] : pairs) {
+        try_emplace(std::move(key), std::move(value));
+      }
+    }
+  }
+
+  /**
+   * @brief Append a range of key-value pairs at once.
+   *
+   * @tparam InputIt Input iterator type.
+   * @param first Beginning of the range.
+   * @param last End of the range.
+   */
+  template <typename InputIt> void bulk_load(InputIt first, InputIt last) {
+    bulk_load(std::vector<std::pair<K, V>>(first, last));
   }
 
   // Emplace methods
@@ -373,63 +1185,237 @@ public:
    * @return iterator Iterator to the emplaced element.
    */
   template <typename... Args> Iterator emplace(Args &&...args) {
-    // Construct pair to decompose arguments
-    value_type pair(std::forward<Args>(args)...);
-    auto &container = data[pair.first];
+    return emplace_with(nullptr, std::forward<Args>(args)...);
+  }
+
+  /**
+   * @brief Construct a key-value pair in place near a position hint.
+   *
+   * Feeding the previously returned iterator (or end()) back as the hint
+   * makes inserting sorted input amortized O(1) for ordered dictionaries.
+   *
+   * @tparam Args Types of arguments to forward.
+   * @param hint Iterator close to where the key belongs.
+   * @param args Arguments to forward to value constructor.
+   * @return iterator Iterator to the emplaced element.
+   */
+  template <typename... Args>
+  Iterator emplace_hint(const_iterator hint, Args &&...args) {
+    return emplace_with(hint.outer_it, std::forward<Args>(args)...);
+  }
 
+  /**
+   * @brief Append a value built from args under key.
+   *
+   * The key is looked up once and only constructed if it is new, the value is
+   * constructed in place inside the key's container.
+   *
+   * @tparam KArg Type of the key argument.
+   * @tparam Args Types of arguments to forward to the value constructor.
+   * @param key Key to append to.
+   * @param args Arguments to forward to value constructor.
+   * @return iterator Iterator to the emplaced element.
+   */
+  template <typename KArg, typename... Args>
+  Iterator try_emplace(KArg &&key, Args &&...args) {
+    return emplace_into(find_or_add(nullptr, std::forward<KArg>(key)),
+                        std::forward<Args>(args)...);
+  }
+
+private:
+  /**
+   * @brief Construct a value at the back of an existing node's container.
+   *
+   * @param outer Node to append to.
+   * @param args Arguments to forward to value constructor.
+   * @return iterator Iterator to the emplaced element.
+   */
+  template <typename... Args>
+  Iterator emplace_into(typename Dict::iterator outer, Args &&...args) {
+    auto &container = outer->second;
     if constexpr (has_emplace_back<Container>()) {
-      container.emplace_back(std::move(pair.second));
-      return Iterator(data.find(pair.first), data.end(), --container.end());
-    } else if constexpr (has_emplace_value<Container>()) {
-      auto it = container.emplace(std::move(pair.second));
-      return Iterator(data.find(pair.first), data.end(), it.first);
+      size_t capacity = capacity_of(container);
+      container.emplace_back(std::forward<Args>(args)...);
+      note_growth(container, capacity);
+      add_values(1);
+      return Iterator(outer, data.end(), std::prev(container.end()));
+    } else {
+      auto it = container.emplace(std::forward<Args>(args)...);
+      add_values(it.second);
+      return Iterator(outer, data.end(), it.first);
     }
   }
 
+  /**
+   * @brief Load n pairs laid out so that equal keys are adjacent.
+   *
+   * @param n Number of pairs.
+   * @param pair_at Accessor returning the i-th pair, consumed by the load.
+   * @param same_key Predicate telling whether pairs i and j have equal keys.
+   */
+  template <typename PairAt, typename SameKey>
+  void load_grouped(size_t n, PairAt pair_at, SameKey same_key) {
+    // Only a first load sizes the dictionary: later loads mostly hit
+    // existing keys, and the dictionary grows geometrically on its own
+    if constexpr (has_reserve<Dict>()) {
+      if (data.empty()) {
+        size_type groups = 0;
+        for (size_t i = 0; i < n; ++i) {
+          groups += i == 0 || !same_key(i - 1, i);
+        }
+        data.reserve(groups);
+      }
+    }
+
+    typename Dict::const_iterator hint = data.end();
+    for (size_t run = 0; run < n;) {
+      size_t run_end = run + 1;
+      while (run_end < n && same_key(run, run_end)) {
+        ++run_end;
+      }
+      auto outer_it = find_or_add(hint, std::move(pair_at(run).first));
+      auto &container = outer_it->second;
+      size_type before = container.size();
+      size_t capacity = capacity_of(container);
+      if constexpr (has_reserve<Container>()) {
+        reserve_amortized(container, before + (run_end - run));
+      }
+      for (; run != run_end; ++run) {
+        if constexpr (has_emplace_back<Container>()) {
+          container.emplace_back(std::move(pair_at(run).second));
+        } else {
+          container.emplace(std::move(pair_at(run).second));
+        }
+      }
+      note_growth(container, capacity);
+      add_values(container.size() - before);
+      hint = std::next(outer_it);
+    }
+  }
+
+  /**
+   * @brief Dispatch emplace arguments to a single dictionary lookup.
+   *
+   * (key, value) and piecewise arguments are forwarded without building a
+   * temporary value_type; anything else is decomposed through one.
+   *
+   * @param hint Position hint, or nullptr for an unhinted lookup.
+   * @param args Arguments to forward to value_type constructor.
+   * @return iterator Iterator to the emplaced element.
+   */
+  template <typename Hint, typename... Args>
+  Iterator emplace_with(Hint hint, Args &&...args) {
+    if constexpr (IsPiecewise<Args...>::value) {
+      return emplace_piecewise(hint, std::forward<Args>(args)...);
+    } else if constexpr (sizeof...(Args) == 2) {
+      return emplace_pair(hint, std::forward<Args>(args)...);
+    } else {
+      // Construct pair to decompose arguments
+      value_type pair(std::forward<Args>(args)...);
+      return emplace_pair(hint, std::move(const_cast<K &>(pair.first)),
+                          std::move(pair.second));
+    }
+  }
+
+  template <typename Hint, typename KArg, typename VArg>
+  Iterator emplace_pair(Hint hint, KArg &&key, VArg &&value) {
+    return emplace_into(find_or_add(hint, std::forward<KArg>(key)),
+                        std::forward<VArg>(value));
+  }
+
+  template <typename Hint, typename KTuple, typename VTuple>
+  Iterator emplace_piecewise(Hint hint, std::piecewise_construct_t,
+                             KTuple &&kargs, VTuple &&vargs) {
+    auto outer =
+        find_or_add(hint, std::make_from_tuple<K>(std::forward<KTuple>(kargs)));
+    return std::apply(
+        [&](auto &&...vs) {
+          return emplace_into(outer, std::forward<decltype(vs)>(vs)...);
+        },
+        std::forward<VTuple>(vargs));
+  }
+
+public:
   // Erase methods
 
   /**
    * @brief Erase element at position.
    *
+   * Erases exactly the element pos points at, in O(1) plus the cost of the
+   * inner container's erase.
+   *
    * @param pos Iterator to the element to erase.
    * @return iterator Iterator following the erased element.
    */
-  Iterator erase(Iterator pos) {
+  Iterator erase(iterator pos) {
     if (pos == end())
       return end();
 
-    auto outer_it = data.find(pos.key());
-    if (outer_it != data.end()) {
-      auto &container = outer_it->second;
-      auto inner_it =
-          std::find(container.begin(), container.end(), pos.value());
-      if (inner_it != container.end()) {
-        inner_it = container.erase(inner_it);
-        if (container.empty()) {
-          outer_it = data.erase(outer_it);
-          if (outer_it == data.end())
-            return end();
-          return Iterator(outer_it, data.end(), outer_it->second.begin());
-        }
-        return Iterator(outer_it, data.end(), inner_it);
-      }
+    auto outer_it = pos.outer_it;
+    auto &container = outer_it->second;
+    auto inner_it = container.erase(pos.inner_it);
+    remove_values(1);
+    if (container.empty()) {
+      return node_begin(data.erase(outer_it));
     }
-    return end();
+    return Iterator(outer_it, data.end(), inner_it);
   }
 
+  /**
+   * @brief Erase element at a read-only position.
+   *
+   * @param pos Iterator to the element to erase.
+   * @return iterator Iterator following the erased element.
+   */
+  Iterator erase(const_iterator pos) { return erase(mutable_position(pos)); }
+
   /**
    * @brief Erase a range of elements.
    *
+   * Each key's part of the range is erased with one container call and keys
+   * left empty are dropped, so the cost is linear in the range length.
+   *
    * @param first Beginning of the range to erase.
    * @param last End of the range to erase.
    * @return iterator Iterator following the last erased element.
    */
-  Iterator erase(Iterator first, Iterator last) {
-    Iterator result = end();
-    while (first != last) {
-      result = erase(first++);
+  Iterator erase(const_iterator first, const_iterator last) {
+    Iterator pos = mutable_position(first);
+    if (first == last)
+      return pos;
+
+    auto outer_it = pos.outer_it;
+    auto inner_it = pos.inner_it;
+    // Dictionaries storing nodes in a vector (flat_map) shift them on
+    // erase, which invalidates last. Count the nodes to cross and the
+    // values to erase from the last one before erasing anything.
+    using ConstInner = typename Container::const_iterator;
+    auto crossed =
+        std::distance(typename Dict::const_iterator(outer_it), last.outer_it);
+    size_type tail = 0;
+    if (crossed == 0) {
+      tail = std::distance(ConstInner(inner_it), last.inner_it);
+    } else if (last.outer_it != data.cend()) {
+      tail = std::distance(last.outer_it->second.begin(), last.inner_it);
     }
-    return result;
+
+    for (; crossed > 0; --crossed) {
+      auto &container = outer_it->second;
+      remove_values(std::distance(inner_it, container.end()));
+      container.erase(inner_it, container.end());
+      outer_it = container.empty() ? data.erase(outer_it) : std::next(outer_it);
+      if (outer_it == data.end())
+        return end();
+      inner_it = outer_it->second.begin();
+    }
+
+    auto &container = outer_it->second;
+    remove_values(tail);
+    inner_it = container.erase(inner_it, std::next(inner_it, tail));
+    if (container.empty()) {
+      return node_begin(data.erase(outer_it));
+    }
+    return Iterator(outer_it, data.end(), inner_it);
   }
 
   /**
@@ -438,14 +1424,19 @@ public:
    * @param key Key to erase.
    * @return size_type Number of elements erased.
    */
-  size_type erase(const key_type &key) {
-    auto it = data.find(key);
-    if (it != data.end()) {
-      size_type count = it->second.size();
-      data.erase(it);
-      return count;
-    }
-    return 0;
+  size_type erase(const key_type &key) { return erase_key(key); }
+
+  /**
+   * @brief Erase all elements with a key comparing equal to key.
+   *
+   * Only available when the dictionary has a transparent comparator or hasher.
+   *
+   * @param key Key-like value to erase.
+   * @return size_type Number of elements erased.
+   */
+  template <typename KL, typename = EnableHeterogeneous<KL>>
+  size_type erase(const KL &key) {
+    return erase_key(key);
   }
 
   /**
@@ -464,16 +1455,77 @@ public:
         auto pos = std::find(container.begin(), container.end(), value);
         if (pos != container.end()) {
           container.erase(pos);
+          remove_values(1);
           return true;
         }
       } else {
         // For associative containers, direct erase
-        return container.erase(value) > 0;
+        if (container.erase(value) > 0) {
+          remove_values(1);
+          return true;
+        }
       }
     }
     return false;
   }
 
+  /**
+   * @brief Erase every value matching a predicate in one sweep.
+   *
+   * pred is either bool(const K&, const V&), tested per value, or
+   * bool(const K&, const Container&), tested once per key to drop the whole
+   * group. Sequence containers are compacted with erase-remove, associative
+   * ones erase node by node, and keys left empty are dropped on the way.
+   *
+   * @tparam Pred Predicate type.
+   * @param pred Predicate selecting what to erase.
+   * @return size_type Number of values erased.
+   */
+  template <typename Pred> size_type erase_if(Pred pred) {
+    size_type removed = 0;
+    for (auto outer_it = data.begin(); outer_it != data.end();) {
+      const K &key = outer_it->first;
+      auto &container = outer_it->second;
+      size_type before = container.size();
+      if constexpr (std::is_invocable_r_v<bool, Pred &, const K &,
+                                          const V &>) {
+        if constexpr (has_emplace_back<Container>()) {
+          container.erase(std::remove_if(container.begin(), container.end(),
+                                         [&](const V &value) {
+                                           return pred(key, value);
+                                         }),
+                          container.end());
+        } else {
+          for (auto it = container.begin(); it != container.end();) {
+            it = pred(key, *it) ? container.erase(it) : std::next(it);
+          }
+        }
+      } else {
+        static_assert(
+            std::is_invocable_r_v<bool, Pred &, const K &, const Container &>,
+            "Predicate must take (key, value) or (key, container)");
+        if (pred(key, std::as_const(container))) {
+          container.clear();
+        }
+      }
+      removed += before - container.size();
+      outer_it = container.empty() ? data.erase(outer_it) : std::next(outer_it);
+    }
+    remove_values(removed);
+    return removed;
+  }
+
+  /**
+   * @brief Keep only the values matching a predicate.
+   *
+   * @tparam Pred Predicate type, same forms as erase_if.
+   * @param pred Predicate selecting what to keep.
+   * @return size_type Number of values erased.
+   */
+  template <typename Pred> size_type retain(Pred pred) {
+    return erase_if(std::not_fn(std::move(pred)));
+  }
+
   // Lookup methods
 
   /**
@@ -482,41 +1534,175 @@ public:
    * @param key Key to count.
    * @return size_type Number of elements with the key.
    */
-  size_type count(const key_type &key) const {
-    auto it = data.find(key);
-    return it != data.end() ? it->second.size() : 0;
+  size_type count(const key_type &key) const { return count_key(key); }
+
+  /**
+   * @brief Count elements with a key comparing equal to key.
+   *
+   * Only available when the dictionary has a transparent comparator or hasher.
+   *
+   * @param key Key-like value to count.
+   * @return size_type Number of elements with the key.
+   */
+  template <typename KL, typename = EnableHeterogeneous<KL>>
+  size_type count(const KL &key) const {
+    return count_key(key);
   }
 
+  /**
+   * @brief Find an element with the given key.
+   *
+   * @param key Key to find.
+   * @return iterator Iterator to the first element with the key, or end() if
+   * not found.
+   */
+  Iterator find(const key_type &key) { return find_key(*this, key); }
+
   /**
    * @brief Find an element with the given key (const version).
    *
    * @param key Key to find.
+   * @return const_iterator Iterator to the first element with the key, or
+   * end() if not found.
+   */
+  const_iterator find(const key_type &key) const {
+    return find_key(*this, key);
+  }
+
+  /**
+   * @brief Find an element with a key comparing equal to key.
+   *
+   * Only available when the dictionary has a transparent comparator or hasher.
+   *
+   * @param key Key-like value to find.
    * @return iterator Iterator to the first element with the key, or end() if
    * not found.
    */
-  Iterator find(const key_type &key) const {
-    auto it = data.find(key);
-    if (it != data.end() && !it->second.empty()) {
-      return Iterator(it, data.end(), it->second.begin());
-    }
-    return end();
+  template <typename KL, typename = EnableHeterogeneous<KL>>
+  Iterator find(const KL &key) {
+    return find_key(*this, key);
+  }
+
+  template <typename KL, typename = EnableHeterogeneous<KL>>
+  const_iterator find(const KL &key) const {
+    return find_key(*this, key);
+  }
+
+  /**
+   * @brief Get the range of elements with the given key.
+   *
+   * @param key Key to find.
+   * @return std::pair<iterator, iterator> Range of elements with the key.
+   */
+  std::pair<Iterator, Iterator> equal_range(const key_type &key) {
+    return equal_range_key(*this, key);
   }
 
   /**
    * @brief Get the range of elements with the given key (const version).
    *
    * @param key Key to find.
+   * @return std::pair<const_iterator, const_iterator> Range of elements with
+   * the key.
+   */
+  std::pair<const_iterator, const_iterator>
+  equal_range(const key_type &key) const {
+    return equal_range_key(*this, key);
+  }
+
+  /**
+   * @brief Get the range of elements with a key comparing equal to key.
+   *
+   * Only available when the dictionary has a transparent comparator or hasher.
+   *
+   * @param key Key-like value to find.
    * @return std::pair<iterator, iterator> Range of elements with the key.
    */
-  std::pair<Iterator, Iterator> equal_range(const key_type &key) const {
+  template <typename KL, typename = EnableHeterogeneous<KL>>
+  std::pair<Iterator, Iterator> equal_range(const KL &key) {
+    return equal_range_key(*this, key);
+  }
+
+  template <typename KL, typename = EnableHeterogeneous<KL>>
+  std::pair<const_iterator, const_iterator> equal_range(const KL &key) const {
+    return equal_range_key(*this, key);
+  }
+
+private:
+  template <typename KL> size_type erase_key(const KL &key) {
     auto it = data.find(key);
-    if (it == data.end()) {
-      return {end(), end()};
+    if (it != data.end()) {
+      size_type count = it->second.size();
+      data.erase(it);
+      remove_values(count);
+      return count;
+    }
+    return 0;
+  }
+
+  template <typename KL> view_type view_key(const KL &key) const {
+    auto it = lookup(*this, key);
+    return it != data.end() ? make_view(it->second) : view_type();
+  }
+
+  template <typename KL> size_type count_key(const KL &key) const {
+    auto it = lookup(*this, key);
+    return it != data.end() ? it->second.size() : 0;
+  }
+
+  template <typename Self>
+  using IteratorFor = BasicIterator<std::is_const_v<Self>>;
+
+  template <typename Self, typename KL>
+  static IteratorFor<Self> find_key(Self &self, const KL &key) {
+    auto it = lookup(self, key);
+    if (it != self.data.end() && !it->second.empty()) {
+      return {it, self.data.end(), it->second.begin()};
+    }
+    return self.end();
+  }
+
+  template <typename Self, typename KL>
+  static std::pair<IteratorFor<Self>, IteratorFor<Self>>
+  equal_range_key(Self &self, const KL &key) {
+    auto it = lookup(self, key);
+    if (it == self.data.end()) {
+      return {self.end(), self.end()};
     }
-    return {Iterator(it, data.end(), it->second.begin()),
-            Iterator(it, data.end(), it->second.end())};
+    return {IteratorFor<Self>(it, self.data.end(), it->second.begin()),
+            IteratorFor<Self>(it, self.data.end(), it->second.end())};
+  }
+
+  /**
+   * @brief Iterator at the first value of a node, or end().
+   *
+   * @param outer_it Node position in the dictionary.
+   * @return iterator Iterator to the node's first value.
+   */
+  Iterator node_begin(typename Dict::iterator outer_it) {
+    if (outer_it == data.end())
+      return end();
+    return Iterator(outer_it, data.end(), outer_it->second.begin());
   }
 
+  /**
+   * @brief Turn a read-only position into a mutable one in O(1).
+   *
+   * Erasing an empty range is the standard constant-time way to get a
+   * mutable iterator from a const_iterator of a non-const container.
+   *
+   * @param pos Read-only position.
+   * @return iterator Mutable iterator at the same position.
+   */
+  Iterator mutable_position(const_iterator pos) {
+    if (pos.outer_it == data.cend())
+      return end();
+    auto outer_it = data.erase(pos.outer_it, pos.outer_it);
+    auto inner_it = outer_it->second.erase(pos.inner_it, pos.inner_it);
+    return Iterator(outer_it, data.end(), inner_it);
+  }
+
+public:
   // Iterator methods
 
   /**
@@ -524,20 +1710,69 @@ public:
    *
    * @return iterator Iterator to the first element.
    */
-  Iterator begin() const {
+  Iterator begin() {
     if (data.empty())
       return end();
     return Iterator(data.begin(), data.end(), data.begin()->second.begin());
   }
 
   /**
-   * @brief Get iterator to the end (const version).
+   * @brief Get iterator to the beginning (const version).
+   *
+   * @return const_iterator Iterator to the first element.
+   */
+  const_iterator begin() const {
+    if (data.empty())
+      return end();
+    return const_iterator(data.begin(), data.end(),
+                          data.begin()->second.begin());
+  }
+
+  /**
+   * @brief Get iterator to the end.
    *
    * @return iterator Iterator to the end.
    */
-  Iterator end() const {
-    return Iterator(data.end(), data.end(),
-                    typename Container::const_iterator());
+  Iterator end() {
+    return Iterator(data.end(), data.end(), typename Container::iterator());
+  }
+
+  /**
+   * @brief Get iterator to the end (const version).
+   *
+   * @return const_iterator Iterator to the end.
+   */
+  const_iterator end() const {
+    return const_iterator(data.end(), data.end(),
+                          typename Container::const_iterator());
+  }
+
+  const_iterator cbegin() const { return begin(); }
+  const_iterator cend() const { return end(); }
+
+  /**
+   * @brief Get a range over key groups.
+   *
+   * Each element is (key, view of the key's values), handed out once per
+   * key, so inner loops run over plain spans for contiguous containers.
+   *
+   * @return Range<GroupIterator> Range over all keys.
+   */
+  Range<GroupIterator> groups() const {
+    return {GroupIterator(data.begin()), GroupIterator(data.end()),
+            data.size()};
+  }
+
+  /**
+   * @brief Call f(key, view) once per key.
+   *
+   * @tparam F Callable taking (const K&, view_type).
+   * @param f Function to call for each key group.
+   */
+  template <typename F> void for_each_group(F &&f) const {
+    for (const auto &[key, container] : data) {
+      f(key, make_view(container));
+    }
   }
 
   // Additional convenience methods (non-std::multimap API)
@@ -549,7 +1784,20 @@ public:
    * @return true if key exists, false otherwise.
    */
   bool contains(const key_type &key) const {
-    return data.find(key) != data.end();
+    return lookup(*this, key) != data.end();
+  }
+
+  /**
+   * @brief Check if the multimap contains a key comparing equal to key.
+   *
+   * Only available when the dictionary has a transparent comparator or hasher.
+   *
+   * @param key Key-like value to check.
+   * @return true if key exists, false otherwise.
+   */
+  template <typename KL, typename = EnableHeterogeneous<KL>>
+  bool contains(const KL &key) const {
+    return lookup(*this, key) != data.end();
   }
 
   /**
@@ -581,23 +1829,99 @@ public:
    * exist).
    */
   [[nodiscard]] Container get(const K &key, Container defval = {}) const {
-    auto it = data.find(key);
+    auto it = lookup(*this, key);
+    return it != data.end() ? it->second : defval;
+  }
+
+  /**
+   * @brief Get the container for a key-like value safely.
+   *
+   * Only available when the dictionary has a transparent comparator or hasher.
+   *
+   * @param key Key-like value to look up.
+   * @return Container Copy of the container (defval if key doesn't exist).
+   */
+  template <typename KL, typename = EnableHeterogeneous<KL>>
+  [[nodiscard]] Container get(const KL &key, Container defval = {}) const {
+    auto it = lookup(*this, key);
     return it != data.end() ? it->second : defval;
   }
 
+  /**
+   * @brief Get a non-owning view of a key's values.
+   *
+   * Nothing is copied, allocated or inserted: a missing key yields an empty
+   * view. The view is a Span for contiguous containers and a Range of const
+   * iterators otherwise, and is invalidated like the container's iterators.
+   *
+   * @param key Key to look up.
+   * @return view_type View of the key's values.
+   */
+  [[nodiscard]] view_type view(const K &key) const { return view_key(key); }
+
+  /**
+   * @brief Get a non-owning view of the values of a key-like value.
+   *
+   * Only available when the dictionary has a transparent comparator or hasher.
+   *
+   * @param key Key-like value to look up.
+   * @return view_type View of the key's values.
+   */
+  template <typename KL, typename = EnableHeterogeneous<KL>>
+  [[nodiscard]] view_type view(const KL &key) const {
+    return view_key(key);
+  }
+
+  /**
+   * @brief Get a view of the values of a key if it is present, with a
+   * single lookup.
+   *
+   * @param key Key to look up.
+   * @return std::optional<view_type> View of the key's values, or
+   * std::nullopt if the key is absent.
+   */
+  [[nodiscard]] std::optional<view_type> find_view(const K &key) const {
+    auto it = lookup(*this, key);
+    if (it == data.end()) {
+      return std::nullopt;
+    }
+    return make_view(it->second);
+  }
+
   /**
    * get the internal data struct
    * @return const reference of internal Dict Container
    */
   const Dict &cdata() const { return data; }
 
+  /**
+   * @brief Move the internal dictionary out, leaving the map empty. Hands
+   * over the key-container nodes without copying them.
+   *
+   * @return Dict The key-container dictionary.
+   */
+  [[nodiscard]] Dict release() {
+    Dict out = std::move(data);
+    data.clear();
+    values = 0;
+    values_stale = false;
+    return out;
+  }
+
   /**
    * @brief Access container for a key (creates if not exists).
    *
+   * Writes through the returned reference are not tracked: size() walks
+   * all keys from then on, until recount() or clear(), and the Stats
+   * policy sees their net effect only then.
+   *
    * @param key Key to access.
    * @return Container& Reference to the container for the key.
    */
-  Container &operator[](const K &key) { return data[key]; }
+  Container &operator[](const K &key) {
+    values_stale = true;
+    return data[key];
+  }
 
   /**
    * @brief Access container for a key with bounds checking.
@@ -606,7 +1930,31 @@ public:
    * @return const Container& Reference to the container for the key.
    * @throw std::out_of_range if key doesn't exist.
    */
-  [[nodiscard]] const Container &at(const K &key) const { return data.at(key); }
+  [[nodiscard]] const Container &at(const K &key) const {
+    auto it = lookup(*this, key);
+    if (it == data.end()) {
+      throw std::out_of_range("MultiMap::at");
+    }
+    return it->second;
+  }
+
+  /**
+   * @brief Access container for a key-like value with bounds checking.
+   *
+   * Only available when the dictionary has a transparent comparator or hasher.
+   *
+   * @param key Key-like value to access.
+   * @return const Container& Reference to the container for the key.
+   * @throw std::out_of_range if key doesn't exist.
+   */
+  template <typename KL, typename = EnableHeterogeneous<KL>>
+  [[nodiscard]] const Container &at(const KL &key) const {
+    auto it = lookup(*this, key);
+    if (it == data.end()) {
+      throw std::out_of_range("MultiMap::at");
+    }
+    return it->second;
+  }
 
   /**
    * @brief Merge another MultiMap into this one.
@@ -619,6 +1967,55 @@ public:
     }
   }
 
+  /**
+   * @brief Merge another MultiMap into this one, consuming it.
+   *
+   * Keys missing here are spliced over as whole nodes when the dictionary
+   * supports merge. For a key whose container here is empty, the other
+   * container is moved in whole. For other keys the values are appended
+   * with move semantics (set containers splice their nodes). other is left
+   * empty.
+   *
+   * @param other Other MultiMap to merge.
+   */
+  void merge(MultiMap &&other) {
+    if (this == &other)
+      return;
+
+    size_type incoming = other.size();
+    if constexpr (has_merge<Dict>()) {
+      if (can_splice(data, other.data)) {
+        data.merge(other.data);
+      }
+    }
+
+    size_type left = 0;
+    for (auto &[key, container] : other.data) {
+      left += container.size();
+      auto &dest = find_or_add(nullptr, key)->second;
+      size_type before = dest.size();
+      if (dest.empty()) {
+        dest = std::move(container);
+      } else if constexpr (has_merge<Container>()) {
+        if (can_splice(dest, container)) {
+          dest.merge(container);
+        } else {
+          dest.insert(std::make_move_iterator(container.begin()),
+                      std::make_move_iterator(container.end()));
+        }
+      } else if constexpr (has_emplace_back<Container>()) {
+        dest.insert(dest.end(), std::make_move_iterator(container.begin()),
+                    std::make_move_iterator(container.end()));
+      } else {
+        dest.insert(std::make_move_iterator(container.begin()),
+                    std::make_move_iterator(container.end()));
+      }
+      add_values(dest.size() - before);
+    }
+    add_values(incoming - left);
+    other.clear();
+  }
+
   /**
    * @brief Get the number of keys in the multimap.
    *
@@ -639,25 +2036,104 @@ public:
    *
    * @return size_t Total number of values.
    */
-  [[nodiscard]] size_t total_value_count() const {
-    size_t count = 0;
-    for (const auto &pair : data) {
-      count += pair.second.size();
-    }
-    return count;
-  }
+  [[nodiscard]] size_t total_value_count() const { return size(); }
+
+  /**
+   * @brief Get the operation counts recorded by the Stats policy.
+   *
+   * @return OperationCounts Counts so far, all zero with NoStats.
+   */
+  [[nodiscard]] OperationCounts counters() const { return policy().counts(); }
 
   /**
-   * @brief Print statistics for debugging.
+   * @brief Zero the operation counters.
    */
-  void print_stats(std::ostream &os = std::cout) const {
-    os << "Total keys: " << key_count() << "\n";
-    os << "Total values: " << total_value_count() << "\n";
+  void reset_counters() { static_cast<Stats &>(*this).reset(); }
+
+  /**
+   * @brief Summarize how the values are spread over the keys.
+   *
+   * One pass over the keys fills a log-scale histogram of values per key
+   * and keeps the top_n heaviest keys in a bounded heap, so the cost is
+   * O(keys log top_n) and the summary stays small whatever the map size.
+   * Keys with equal counts are ranked in iteration order. The load factor
+   * is filled in for dictionaries that have one, and the operation counts
+   * when the Stats policy records them.
+   *
+   * @param top_n Number of heaviest keys to report.
+   * @return MultiMapStats<K> The summary.
+   */
+  [[nodiscard]] MultiMapStats<K> stats(size_t top_n = 10) const {
+    MultiMapStats<K> result;
+    result.keys = data.size();
+    result.values = size();
+
+    // (values, position, key); the heap keeps the lightest on top
+    using Entry = std::tuple<size_t, size_t, const K *>;
+    auto heavier = [](const Entry &a, const Entry &b) {
+      if (std::get<0>(a) != std::get<0>(b)) {
+        return std::get<0>(a) > std::get<0>(b);
+      }
+      return std::get<1>(a) < std::get<1>(b);
+    };
+    std::vector<Entry> heap;
+    heap.reserve(std::min(top_n, data.size()));
+    size_t position = 0;
     for (const auto &[key, container] : data) {
-      os << "Key " << key << ": " << container.size() << " values\n";
+      size_t n = container.size();
+      size_t bucket = detail::log2_bucket(n);
+      if (bucket >= result.histogram.size()) {
+        result.histogram.resize(bucket + 1);
+      }
+      ++result.histogram[bucket];
+      result.max_values = std::max(result.max_values, n);
+
+      Entry entry{n, position++, &key};
+      if (heap.size() < top_n) {
+        heap.push_back(entry);
+        std::push_heap(heap.begin(), heap.end(), heavier);
+      } else if (top_n != 0 && heavier(entry, heap.front())) {
+        std::pop_heap(heap.begin(), heap.end(), heavier);
+        heap.back() = entry;
+        std::push_heap(heap.begin(), heap.end(), heavier);
+      }
     }
+    std::sort_heap(heap.begin(), heap.end(), heavier);
+    for (const auto &[n, pos, key] : heap) {
+      result.top_keys.emplace_back(*key, n);
+    }
+
+    if constexpr (HasLoadFactor<Dict>::value) {
+      result.load_factor = data.load_factor();
+    }
+    if constexpr (Stats::enabled) {
+      result.counts = counters();
+    }
+    return result;
+  }
+
+  /**
+   * @brief Estimate the bytes this map occupies: the map object, the
+   * dictionary's nodes or buckets, keys, value container headers, values
+   * and their spare capacity, heap memory owned by keys and values, and
+   * malloc overhead. Walks every key, and every value when the key or
+   * value type owns heap memory. See MemoryUsage for how to customize the
+   * estimate.
+   *
+   * @return MemoryUsage The breakdown.
+   */
+  [[nodiscard]] MemoryUsage memory_usage() const {
+    MemoryUsage usage;
+    usage.object = sizeof(*this);
+    DictionaryUsage<Dict>::add(data, usage);
+    return usage;
   }
 
+  /**
+   * @brief Print a summary of stats() for debugging.
+   */
+  void print_stats(std::ostream &os = std::cout) const { stats().print(os); }
+
   /**
    * @brief Print all data for debugging.
    */
@@ -672,6 +2148,34 @@ public:
   }
 };
 
+/**
+ * @brief Erase every value of a MultiMap matching a predicate.
+ *
+ * @param mm MultiMap to prune.
+ * @param pred bool(key, value) or bool(key, container) predicate.
+ * @return size_t Number of values erased.
+ */
+template <typename K, typename V, template <typename...> class CTemplate,
+          template <typename...> class DTemplate, typename Stats,
+          typename Pred>
+size_t erase_if(MultiMap<K, V, CTemplate, DTemplate, Stats> &mm, Pred pred) {
+  return mm.erase_if(std::move(pred));
+}
+
+/**
+ * @brief Keep only the values of a MultiMap matching a predicate.
+ *
+ * @param mm MultiMap to prune.
+ * @param pred bool(key, value) or bool(key, container) predicate.
+ * @return size_t Number of values erased.
+ */
+template <typename K, typename V, template <typename...> class CTemplate,
+          template <typename...> class DTemplate, typename Stats,
+          typename Pred>
+size_t retain(MultiMap<K, V, CTemplate, DTemplate, Stats> &mm, Pred pred) {
+  return mm.retain(std::move(pred));
+}
+
 template <typename K, typename V,
           template <typename...> class DTemplate = std::map>
 class UniqueMultiDict : public MultiMap<K, V, std::set> {};
@@ -681,5 +2185,3 @@ template <typename K, typename V,
 class VectorMultiDict : public MultiMap<K, V, std::vector> {};
 
 } // namespace dictool
-
-#endif
\ No newline at end of file
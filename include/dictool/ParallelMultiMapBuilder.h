@@ -0,0 +1,250 @@
+#pragma once
+
+#include "dictool/MultiDict.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace dictool {
+
+/**
+ * @brief Builds one MultiMap from many threads without shared state.
+ *
+ * Each worker thread appends to its own Worker, which splits its pairs by
+ * key hash into one append buffer per partition. Workers share nothing,
+ * so appends never contend and cost a push_back. finish() bulk-loads each
+ * partition from the buffers of all workers, in parallel across
+ * partitions, and splices the partitions, whose keys are disjoint, into
+ * the result with MultiMap::merge(MultiMap &&). Values are moved at every
+ * step, never copied.
+ *
+ * The final splice runs on the calling thread and costs one node move per
+ * key (one container move when the dictionary has no node handles), so
+ * with many threads and few values per key it bounds the speedup.
+ *
+ * Buffering instead of keeping a local MultiMap per worker means a key
+ * seen by many workers is still looked up and allocated once, in its
+ * partition, rather than once per worker and again when reducing.
+ *
+ * Values of a key keep the order in which their worker appended them,
+ * with workers taken in index order.
+ *
+ * @tparam K Key type.
+ * @tparam V Value type.
+ * @tparam CTemplate Container template for storing values (default:
+ * std::vector).
+ * @tparam DTemplate Dictionary template (default: std::map).
+ * @tparam Hash Hash function used to partition keys (default:
+ * std::hash<K>).
+ * @tparam Stats Instrumentation policy of the result (default: NoStats).
+ * Its counts cover the bulk loads and merges done by finish().
+ */
+template <typename K, typename V,
+          template <typename...> class CTemplate = std::vector,
+          template <typename...> class DTemplate = std::map,
+          typename Hash = std::hash<K>, typename Stats = NoStats>
+class ParallelMultiMapBuilder {
+public:
+  using map_type =
+      MultiMap<K, V, CTemplate, DTemplate, Stats>; /**< Result type */
+  using size_type = size_t;                        /**< Size type */
+
+  /**
+   * @brief Append-only view for one thread. Aligned to its own cache
+   * lines so that neighbouring workers do not false-share.
+   */
+  class alignas(64) Worker {
+  private:
+    friend class ParallelMultiMapBuilder;
+
+    using Buffer = std::vector<std::pair<K, V>>;
+
+    std::vector<Buffer> parts;  /**< Append buffer of each partition */
+    const Hash *hash = nullptr; /**< Owner's partition hash */
+
+  public:
+    /**
+     * @brief Append a value built from args under key.
+     *
+     * @param key Key to append to.
+     * @param args Arguments to forward to the value constructor.
+     */
+    template <typename KArg, typename... Args>
+    void emplace(KArg &&key, Args &&...args) {
+      auto &part = parts[partition_of(*hash, key, parts.size())];
+      part.emplace_back(std::piecewise_construct,
+                        std::forward_as_tuple(std::forward<KArg>(key)),
+                        std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+
+    /**
+     * @brief Append a range of key-value pairs.
+     *
+     * @param first Beginning of the range.
+     * @param last End of the range.
+     */
+    template <typename InputIt> void insert(InputIt first, InputIt last) {
+      for (; first != last; ++first) {
+        auto &&[key, value] = *first;
+        emplace(key, value);
+      }
+    }
+
+    /**
+     * @brief Get the number of values appended so far.
+     *
+     * @return size_type Number of values.
+     */
+    [[nodiscard]] size_type size() const {
+      size_type total = 0;
+      for (const auto &part : parts) {
+        total += part.size();
+      }
+      return total;
+    }
+  };
+
+private:
+  std::vector<Worker> workers; /**< One per producing thread */
+  size_type partitions;        /**< Partitions per worker */
+  Hash hash;                   /**< Partition hash function */
+
+  /** Partition of a key, mixed since std::hash is the identity for ints */
+  static size_type partition_of(const Hash &hash, const K &key,
+                                size_type count) {
+    uint64_t h = static_cast<uint64_t>(hash(key)) * 0x9e3779b97f4a7c15ull;
+    return static_cast<size_type>((h >> 32) % count);
+  }
+
+public:
+  /**
+   * @brief Construct a builder.
+   *
+   * @param worker_count Number of producing threads (at least 1).
+   * @param partition_count Number of key partitions reduced in parallel by
+   * finish(); 0 picks one per worker.
+   * @param hash Partition hash function.
+   */
+  explicit ParallelMultiMapBuilder(size_type worker_count,
+                                   size_type partition_count = 0,
+                                   const Hash &hash = Hash())
+      : workers(worker_count == 0 ? 1 : worker_count),
+        partitions(partition_count == 0 ? workers.size() : partition_count),
+        hash(hash) {
+    for (Worker &w : workers) {
+      w.parts.resize(partitions);
+      w.hash = &this->hash;
+    }
+  }
+
+  ParallelMultiMapBuilder(const ParallelMultiMapBuilder &) = delete;
+  ParallelMultiMapBuilder &operator=(const ParallelMultiMapBuilder &) = delete;
+
+  /**
+   * @brief Get the Worker of thread i. Each Worker must be used by one
+   * thread at a time.
+   *
+   * @param i Worker index.
+   * @return Worker& The worker.
+   * @throws std::out_of_range if i is not a worker index.
+   */
+  Worker &worker(size_type i) {
+    if (i >= workers.size()) {
+      throw std::out_of_range("ParallelMultiMapBuilder::worker");
+    }
+    return workers[i];
+  }
+
+  [[nodiscard]] size_type worker_count() const { return workers.size(); }
+  [[nodiscard]] size_type partition_count() const { return partitions; }
+
+  /**
+   * @brief Run f(i, worker(i)) on worker_count() threads and wait for all
+   * of them.
+   *
+   * @tparam F Callable taking (size_type, Worker&).
+   * @param f Producer body.
+   */
+  template <typename F> void run(F &&f) {
+    std::vector<std::thread> threads;
+    threads.reserve(workers.size() - 1);
+    for (size_type i = 1; i < workers.size(); ++i) {
+      threads.emplace_back([&f, this, i] { f(i, workers[i]); });
+    }
+    f(size_type(0), workers[0]);
+    for (auto &t : threads) {
+      t.join();
+    }
+  }
+
+  /**
+   * @brief Reduce all workers into one MultiMap and reset the builder.
+   *
+   * Partitions are loaded on up to threads threads, each gathering the
+   * buffers of one partition from all workers and bulk-loading them at a
+   * time. The disjoint partitions are then spliced into the result on the
+   * calling thread, after reserving room for every key when the dictionary
+   * has reserve. No worker may be appending meanwhile.
+   *
+   * @param threads Number of reducing threads; 0 uses one per worker.
+   * @return map_type All appended key-value pairs.
+   */
+  map_type finish(size_type threads = 0) {
+    std::vector<map_type> reduced(partitions);
+    std::atomic<size_type> next{0};
+    auto reduce = [&] {
+      for (size_type p; (p = next.fetch_add(1)) < partitions;) {
+        reduced[p].bulk_load(gather(p));
+      }
+    };
+
+    threads = std::min(threads == 0 ? workers.size() : threads, partitions);
+    std::vector<std::thread> pool;
+    for (size_type i = 1; i < threads; ++i) {
+      pool.emplace_back(reduce);
+    }
+    reduce();
+    for (auto &t : pool) {
+      t.join();
+    }
+
+    map_type result = std::move(reduced[0]);
+    if constexpr (has_reserve<typename map_type::dictionary_type>()) {
+      size_type keys = result.key_count();
+      for (size_type p = 1; p < partitions; ++p) {
+        keys += reduced[p].key_count();
+      }
+      result.reserve(keys);
+    }
+    for (size_type p = 1; p < partitions; ++p) {
+      result.merge(std::move(reduced[p]));
+    }
+    return result;
+  }
+
+private:
+  /** Move the buffers of partition p out of all workers, in worker order */
+  std::vector<std::pair<K, V>> gather(size_type p) {
+    size_type total = 0;
+    for (Worker &w : workers) {
+      total += w.parts[p].size();
+    }
+    std::vector<std::pair<K, V>> pairs = std::move(workers[0].parts[p]);
+    pairs.reserve(total);
+    for (size_type i = 1; i < workers.size(); ++i) {
+      auto &part = workers[i].parts[p];
+      pairs.insert(pairs.end(), std::make_move_iterator(part.begin()),
+                   std::make_move_iterator(part.end()));
+      typename Worker::Buffer().swap(part);
+    }
+    return pairs;
+  }
+};
+
+} // namespace dictool
@@ -0,0 +1,615 @@
+#pragma once
+
+#include "dictool/MemoryUsage.h"
+#include <algorithm>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace dictool {
+
+/**
+ * @brief Sequence container storing up to N elements inline and spilling to
+ * the heap beyond that.
+ *
+ * Behaves like std::vector: contiguous storage, emplace_back, insert,
+ * erase, reserve and shrink_to_fit. While size() <= N no allocation is made,
+ * which suits MultiMap keys that hold a handful of values each. Moving an
+ * inline small vector moves its elements one by one.
+ *
+ * @tparam T Element type.
+ * @tparam N Number of elements stored inline, at least 1.
+ */
+template <typename T, size_t N> class basic_small_vector {
+  static_assert(N > 0, "basic_small_vector needs an inline capacity");
+  static_assert(N <= std::numeric_limits<uint32_t>::max(),
+                "inline capacity does not fit the size fields");
+
+public:
+  using value_type = T;                    /**< Element type */
+  using size_type = size_t;                /**< Size type */
+  using difference_type = ptrdiff_t;       /**< Difference type */
+  using reference = T &;                   /**< Element reference */
+  using const_reference = const T &;       /**< Const element reference */
+  using pointer = T *;                     /**< Element pointer */
+  using const_pointer = const T *;         /**< Const element pointer */
+  using iterator = T *;                    /**< Iterator type */
+  using const_iterator = const T *;        /**< Const iterator type */
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  static constexpr size_type inline_capacity = N; /**< Inline elements */
+
+private:
+  T *ptr = inline_data(); /**< Inline buffer or heap block */
+  uint32_t len = 0;       /**< Number of elements */
+  uint32_t cap = N;       /**< Capacity of ptr */
+  alignas(T) unsigned char buffer[N * sizeof(T)]; /**< Inline storage */
+
+  T *inline_data() { return reinterpret_cast<T *>(buffer); }
+  const T *inline_data() const { return reinterpret_cast<const T *>(buffer); }
+
+public:
+  /**
+   * @brief Construct an empty small vector. Does not allocate.
+   */
+  basic_small_vector() noexcept {}
+
+  /**
+   * @brief Construct n value-initialized elements.
+   *
+   * @param n Number of elements.
+   */
+  explicit basic_small_vector(size_type n) {
+    construct([&] { resize(n); });
+  }
+
+  /**
+   * @brief Construct n copies of value.
+   *
+   * @param n Number of elements.
+   * @param value Value to copy.
+   */
+  basic_small_vector(size_type n, const T &value) {
+    construct([&] { resize(n, value); });
+  }
+
+  /**
+   * @brief Construct from a range of elements.
+   *
+   * @param first Beginning of the range.
+   * @param last End of the range.
+   */
+  template <typename InputIt, typename = typename std::iterator_traits<
+                                  InputIt>::iterator_category>
+  basic_small_vector(InputIt first, InputIt last) {
+    construct([&] { insert(end(), first, last); });
+  }
+
+  /**
+   * @brief Construct from an initializer list.
+   *
+   * @param init Initializer list of elements.
+   */
+  basic_small_vector(std::initializer_list<T> init)
+      : basic_small_vector(init.begin(), init.end()) {}
+
+  basic_small_vector(const basic_small_vector &other) {
+    construct([&] {
+      reserve(other.size());
+      std::uninitialized_copy(other.begin(), other.end(), ptr);
+      len = other.len;
+    });
+  }
+
+  basic_small_vector(basic_small_vector &&other) noexcept(
+      std::is_nothrow_move_constructible_v<T>) {
+    take(other);
+  }
+
+  basic_small_vector &operator=(const basic_small_vector &other) {
+    if (this != &other) {
+      assign(other.begin(), other.end());
+    }
+    return *this;
+  }
+
+  basic_small_vector &operator=(basic_small_vector &&other) noexcept(
+      std::is_nothrow_move_constructible_v<T>) {
+    if (this != &other) {
+      clear();
+      release();
+      take(other);
+    }
+    return *this;
+  }
+
+  basic_small_vector &operator=(std::initializer_list<T> init) {
+    assign(init.begin(), init.end());
+    return *this;
+  }
+
+  ~basic_small_vector() {
+    clear();
+    release();
+  }
+
+  /**
+   * @brief Replace the contents with a range of elements.
+   *
+   * @param first Beginning of the range.
+   * @param last End of the range.
+   */
+  template <typename InputIt> void assign(InputIt first, InputIt last) {
+    clear();
+    insert(end(), first, last);
+  }
+
+  // Iterator methods
+
+  iterator begin() noexcept { return ptr; }
+  const_iterator begin() const noexcept { return ptr; }
+  iterator end() noexcept { return ptr + len; }
+  const_iterator end() const noexcept { return ptr + len; }
+  const_iterator cbegin() const noexcept { return ptr; }
+  const_iterator cend() const noexcept { return ptr + len; }
+  reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+  const_reverse_iterator rbegin() const noexcept {
+    return const_reverse_iterator(end());
+  }
+  reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+  const_reverse_iterator rend() const noexcept {
+    return const_reverse_iterator(begin());
+  }
+
+  // Capacity methods
+
+  [[nodiscard]] bool empty() const noexcept { return len == 0; }
+  [[nodiscard]] size_type size() const noexcept { return len; }
+  [[nodiscard]] size_type capacity() const noexcept { return cap; }
+  [[nodiscard]] size_type max_size() const noexcept {
+    return std::numeric_limits<uint32_t>::max();
+  }
+
+  /**
+   * @brief Check whether the elements are stored in the inline buffer.
+   *
+   * @return true if no heap block is in use, false otherwise.
+   */
+  [[nodiscard]] bool is_inline() const noexcept {
+    return ptr == inline_data();
+  }
+
+  /**
+   * @brief Make room for n elements.
+   *
+   * @param n Number of elements.
+   */
+  void reserve(size_type n) {
+    if (n > cap) {
+      reallocate(n);
+    }
+  }
+
+  /**
+   * @brief Release unused capacity, moving back inline when size() <= N.
+   */
+  void shrink_to_fit() {
+    if (is_inline() || len == cap) {
+      return;
+    }
+    if (len <= N) {
+      T *heap = ptr;
+      uint32_t heap_cap = cap;
+      ptr = inline_data();
+      cap = N;
+      std::uninitialized_move(heap, heap + len, ptr);
+      std::destroy(heap, heap + len);
+      std::allocator<T>().deallocate(heap, heap_cap);
+    } else {
+      reallocate(len);
+    }
+  }
+
+  // Element access
+
+  reference operator[](size_type i) { return ptr[i]; }
+  const_reference operator[](size_type i) const { return ptr[i]; }
+
+  reference at(size_type i) {
+    if (i >= len)
+      throw std::out_of_range("small_vector::at");
+    return ptr[i];
+  }
+
+  const_reference at(size_type i) const {
+    if (i >= len)
+      throw std::out_of_range("small_vector::at");
+    return ptr[i];
+  }
+
+  reference front() { return ptr[0]; }
+  const_reference front() const { return ptr[0]; }
+  reference back() { return ptr[len - 1]; }
+  const_reference back() const { return ptr[len - 1]; }
+  T *data() noexcept { return ptr; }
+  const T *data() const noexcept { return ptr; }
+
+  // Modifiers
+
+  /**
+   * @brief Construct an element at the end.
+   *
+   * @param args Arguments to forward to the element constructor.
+   * @return reference The new element.
+   */
+  template <typename... Args> reference emplace_back(Args &&...args) {
+    if (len == cap) {
+      return grow_emplace_back(std::forward<Args>(args)...);
+    }
+    new (ptr + len) T(std::forward<Args>(args)...);
+    return ptr[len++];
+  }
+
+  void push_back(const T &value) { emplace_back(value); }
+  void push_back(T &&value) { emplace_back(std::move(value)); }
+
+  void pop_back() { ptr[--len].~T(); }
+
+  /**
+   * @brief Construct an element before pos.
+   *
+   * @param pos Position to insert before.
+   * @param args Arguments to forward to the element constructor.
+   * @return iterator The new element.
+   */
+  template <typename... Args>
+  iterator emplace(const_iterator pos, Args &&...args) {
+    size_type index = pos - begin();
+    emplace_back(std::forward<Args>(args)...);
+    std::rotate(begin() + index, end() - 1, end());
+    return begin() + index;
+  }
+
+  iterator insert(const_iterator pos, const T &value) {
+    return emplace(pos, value);
+  }
+
+  iterator insert(const_iterator pos, T &&value) {
+    return emplace(pos, std::move(value));
+  }
+
+  /**
+   * @brief Insert a range of elements before pos.
+   *
+   * @param pos Position to insert before.
+   * @param first Beginning of the range.
+   * @param last End of the range.
+   * @return iterator First inserted element, or pos if the range is empty.
+   */
+  template <typename InputIt, typename = typename std::iterator_traits<
+                                  InputIt>::iterator_category>
+  iterator insert(const_iterator pos, InputIt first, InputIt last) {
+    size_type index = pos - begin();
+    size_type old_len = len;
+    using Category = typename std::iterator_traits<InputIt>::iterator_category;
+    if constexpr (std::is_base_of_v<std::forward_iterator_tag, Category>) {
+      size_type n = static_cast<size_type>(std::distance(first, last));
+      if (n > cap - len) {
+        // Copy before moving the old elements, the range may be one of them
+        relocate(grown_capacity(n), n, [&](T *slot) {
+          std::uninitialized_copy(first, last, slot);
+        });
+      } else {
+        std::uninitialized_copy(first, last, end());
+      }
+      len += static_cast<uint32_t>(n);
+    } else {
+      for (; first != last; ++first) {
+        emplace_back(*first);
+      }
+    }
+    std::rotate(begin() + index, begin() + old_len, end());
+    return begin() + index;
+  }
+
+  iterator insert(const_iterator pos, std::initializer_list<T> init) {
+    return insert(pos, init.begin(), init.end());
+  }
+
+  /**
+   * @brief Erase the element at pos.
+   *
+   * @param pos Position to erase.
+   * @return iterator Element following the erased one.
+   */
+  iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+
+  /**
+   * @brief Erase the elements in [first, last).
+   *
+   * @param first Beginning of the range.
+   * @param last End of the range.
+   * @return iterator Element following the erased ones.
+   */
+  iterator erase(const_iterator first, const_iterator last) {
+    iterator dest = begin() + (first - cbegin());
+    if (first != last) {
+      iterator tail = std::move(begin() + (last - cbegin()), end(), dest);
+      std::destroy(tail, end());
+      len = static_cast<uint32_t>(tail - begin());
+    }
+    return dest;
+  }
+
+  /**
+   * @brief Resize to n elements, value-initializing new ones.
+   *
+   * @param n New size.
+   */
+  void resize(size_type n) {
+    reserve(n);
+    while (len < n) {
+      new (ptr + len) T();
+      ++len;
+    }
+    if (n < len) {
+      erase(begin() + n, end());
+    }
+  }
+
+  /**
+   * @brief Resize to n elements, copying value into new ones.
+   *
+   * @param n New size.
+   * @param value Value to copy.
+   */
+  void resize(size_type n, const T &value) {
+    if (n > len) {
+      insert(end(), n - len, value);
+    } else {
+      erase(begin() + n, end());
+    }
+  }
+
+  /**
+   * @brief Insert n copies of value before pos.
+   *
+   * @return iterator First inserted element, or pos if n is 0.
+   */
+  iterator insert(const_iterator pos, size_type n, const T &value) {
+    size_type index = pos - begin();
+    size_type old_len = len;
+    T copy(value); // value may be an element moved by growth
+    for (size_type i = 0; i < n; ++i) {
+      emplace_back(copy);
+    }
+    std::rotate(begin() + index, begin() + old_len, end());
+    return begin() + index;
+  }
+
+  /**
+   * @brief Destroy all elements, keeping the capacity.
+   */
+  void clear() noexcept {
+    std::destroy(begin(), end());
+    len = 0;
+  }
+
+  void swap(basic_small_vector &other) {
+    basic_small_vector tmp(std::move(other));
+    other = std::move(*this);
+    *this = std::move(tmp);
+  }
+
+  friend bool operator==(const basic_small_vector &a,
+                         const basic_small_vector &b) {
+    return std::equal(a.begin(), a.end(), b.begin(), b.end());
+  }
+
+  friend bool operator!=(const basic_small_vector &a,
+                         const basic_small_vector &b) {
+    return !(a == b);
+  }
+
+  friend bool operator<(const basic_small_vector &a,
+                        const basic_small_vector &b) {
+    return std::lexicographical_compare(a.begin(), a.end(), b.begin(),
+                                        b.end());
+  }
+
+private:
+  /**
+   * @brief Run fill from a constructor. The destructor does not run if a
+   * constructor throws, so the elements built so far and the heap block
+   * are freed here instead.
+   */
+  template <typename Fill> void construct(Fill &&fill) {
+    try {
+      fill();
+    } catch (...) {
+      clear();
+      release();
+      throw;
+    }
+  }
+
+  /**
+   * @brief Take other's elements, stealing its heap block if it has one.
+   * other is left empty and inline.
+   */
+  void take(basic_small_vector &other) {
+    if (other.is_inline()) {
+      std::uninitialized_move(other.begin(), other.end(), ptr);
+      len = other.len;
+      other.clear();
+    } else {
+      ptr = other.ptr;
+      len = other.len;
+      cap = other.cap;
+      other.ptr = other.inline_data();
+      other.len = 0;
+      other.cap = N;
+    }
+  }
+
+  /**
+   * @brief Free the heap block, if any, and go back to the inline buffer.
+   * The elements must already be destroyed.
+   */
+  void release() {
+    if (!is_inline()) {
+      std::allocator<T>().deallocate(ptr, cap);
+      ptr = inline_data();
+      cap = N;
+    }
+  }
+
+  /**
+   * @brief Move the elements to a heap block of new_cap elements.
+   */
+  void reallocate(size_type new_cap) {
+    if (new_cap > max_size()) {
+      throw std::length_error("small_vector::reserve");
+    }
+    relocate(new_cap, 0, [](T *) {});
+  }
+
+  /**
+   * @brief Capacity to grow to for extra more elements: at least double,
+   * clamped to max_size().
+   *
+   * @throws std::length_error if size() + extra exceeds max_size().
+   */
+  size_type grown_capacity(size_type extra) const {
+    if (extra > max_size() - len) {
+      throw std::length_error("small_vector");
+    }
+    size_type doubled = std::min<size_type>(size_type(cap) * 2, max_size());
+    return std::max<size_type>(len + extra, doubled);
+  }
+
+  /**
+   * @brief Move the elements to a heap block of new_cap elements, after
+   * build(block + size()) has constructed the count elements that follow
+   * them. If anything throws, what was built in the block is destroyed,
+   * the block freed and the small vector left unchanged.
+   */
+  template <typename Build>
+  void relocate(size_type new_cap, size_type count, Build &&build) {
+    T *block = std::allocator<T>().allocate(new_cap);
+    size_type built = 0;
+    try {
+      build(block + len);
+      built = count;
+      move_into(block);
+    } catch (...) {
+      std::destroy(block + len, block + len + built);
+      std::allocator<T>().deallocate(block, new_cap);
+      throw;
+    }
+    adopt(block, new_cap);
+  }
+
+  /**
+   * @brief Grow and construct the new last element, building it before the
+   * old elements move so args may refer to one of them.
+   */
+  template <typename... Args> reference grow_emplace_back(Args &&...args) {
+    relocate(grown_capacity(1), 1,
+             [&](T *slot) { new (slot) T(std::forward<Args>(args)...); });
+    return ptr[len++];
+  }
+
+  /**
+   * @brief Move, or copy when moving may throw, the elements into block
+   * and destroy the originals. Copies already made are destroyed if one
+   * throws, and the originals are then left as they were.
+   */
+  void move_into(T *block) {
+    if constexpr (std::is_nothrow_move_constructible_v<T> ||
+                  !std::is_copy_constructible_v<T>) {
+      std::uninitialized_move(begin(), end(), block);
+    } else {
+      std::uninitialized_copy(begin(), end(), block);
+    }
+    std::destroy(begin(), end());
+  }
+
+  void adopt(T *block, size_type new_cap) {
+    release();
+    ptr = block;
+    cap = static_cast<uint32_t>(new_cap);
+  }
+};
+
+/**
+ * @brief Swap two small vectors.
+ */
+template <typename T, size_t N>
+void swap(basic_small_vector<T, N> &a, basic_small_vector<T, N> &b) {
+  a.swap(b);
+}
+
+/**
+ * @brief Footprint of a small vector used as a MultiMap value container.
+ * The inline buffer counts as values while in use, and as slack while
+ * empty slots remain or the elements have moved to the heap.
+ */
+template <typename T, size_t N>
+struct ContainerUsage<basic_small_vector<T, N>> {
+  static void add(const basic_small_vector<T, N> &c, MemoryUsage &usage) {
+    size_t inline_bytes = N * sizeof(T);
+    usage.headers += sizeof(c) - inline_bytes;
+    usage.values += c.size() * sizeof(T);
+    if (c.is_inline()) {
+      usage.slack += inline_bytes - c.size() * sizeof(T);
+    } else {
+      usage.slack += inline_bytes + (c.capacity() - c.size()) * sizeof(T);
+      usage.add_block(c.capacity() * sizeof(T));
+    }
+    detail::add_payload<T>(c, usage);
+  }
+};
+
+template <typename T, size_t N> struct HeapUsage<basic_small_vector<T, N>> {
+  static constexpr bool owns_heap = true;
+
+  static void add(const basic_small_vector<T, N> &v, MemoryUsage &usage) {
+    if (!v.is_inline()) {
+      usage.payload += v.capacity() * sizeof(T);
+      usage.add_block(v.capacity() * sizeof(T));
+    }
+    detail::add_payload<T>(v, usage);
+  }
+};
+
+/**
+ * @brief Default inline capacity of small_vector.
+ */
+inline constexpr size_t small_vector_default_capacity = 3;
+
+/**
+ * @brief Small vector with the default inline capacity, usable directly as
+ * the CTemplate of MultiMap: MultiMap<K, V, dictool::small_vector>.
+ */
+template <typename T>
+using small_vector = basic_small_vector<T, small_vector_default_capacity>;
+
+/**
+ * @brief Small vector with a custom inline capacity, as a single-parameter
+ * template for MultiMap: MultiMap<K, V, small_vector_of<8>::type>.
+ *
+ * @tparam N Number of elements stored inline.
+ */
+template <size_t N> struct small_vector_of {
+  template <typename T> using type = basic_small_vector<T, N>;
+};
+
+} // namespace dictool
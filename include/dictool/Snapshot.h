@@ -0,0 +1,661 @@
+#pragma once
+
+#include "dictool/FrozenMultiMap.h"
+#include "dictool/MappedFile.h"
+#include "dictool/MultiDict.h"
+#include "dictool/View.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace dictool {
+
+/**
+ * @brief Position of a string in a snapshot's string table.
+ */
+struct StringRef {
+  uint64_t offset; /**< First byte in the string table */
+  uint64_t length; /**< Number of bytes */
+};
+
+/**
+ * @brief How a key or value type is stored in a snapshot: trivially
+ * copyable types as their own bytes, std::string as a StringRef into the
+ * string table. Other types cannot be saved.
+ *
+ * @tparam T The key or value type.
+ * @tparam void SFINAE parameter.
+ */
+template <typename T, typename = void> struct SnapshotType {
+  static constexpr bool supported = false;
+};
+
+template <typename T>
+struct SnapshotType<T, std::enable_if_t<std::is_trivially_copyable_v<T>>> {
+  static constexpr bool supported = true;
+  static constexpr bool is_string = false;
+  using stored = T; /**< Type of the on-disk element */
+  using view = T;   /**< Type handed out by a mapped snapshot */
+};
+
+template <> struct SnapshotType<std::string> {
+  static constexpr bool supported = true;
+  static constexpr bool is_string = true;
+  using stored = StringRef;
+  using view = std::string_view;
+};
+
+namespace detail {
+
+/** On-disk header, followed by the key, offset, value and string sections */
+struct SnapshotHeader {
+  char magic[8];         /**< "DICTSNAP" */
+  uint32_t version;      /**< Format version */
+  uint32_t byte_order;   /**< snapshot_byte_order as written */
+  uint32_t flags;        /**< Bit 0: string keys, bit 1: string values */
+  uint32_t key_size;     /**< sizeof the stored key */
+  uint32_t value_size;   /**< sizeof the stored value */
+  uint32_t reserved;     /**< Zero */
+  uint64_t key_count;    /**< Number of distinct keys */
+  uint64_t value_count;  /**< Number of values */
+  uint64_t string_bytes; /**< Size of the string table */
+  uint64_t checksum;     /**< FNV-1a of everything after the header */
+};
+
+static_assert(sizeof(SnapshotHeader) == 64, "header layout changed");
+
+constexpr char snapshot_magic[8] = {'D', 'I', 'C', 'T', 'S', 'N', 'A', 'P'};
+constexpr uint32_t snapshot_version = 1;
+constexpr uint32_t snapshot_byte_order = 0x01020304;
+constexpr uint64_t snapshot_align = 64;
+constexpr uint64_t fnv_offset = 0xcbf29ce484222325ull;
+
+/** Continue a 64-bit FNV-1a hash over n bytes */
+inline uint64_t fnv1a(const void *data, size_t n, uint64_t h = fnv_offset) {
+  const auto *p = static_cast<const unsigned char *>(data);
+  for (size_t i = 0; i < n; ++i) {
+    h = (h ^ p[i]) * 0x100000001b3ull;
+  }
+  return h;
+}
+
+inline uint64_t align_up(uint64_t n) {
+  return (n + snapshot_align - 1) / snapshot_align * snapshot_align;
+}
+
+/** Section offsets from the start of the file, derived from the header */
+struct SnapshotLayout {
+  uint64_t keys;
+  uint64_t offsets;
+  uint64_t values;
+  uint64_t strings;
+  uint64_t end;
+  bool overflow = false; /**< The header's counts do not fit in 64 bits */
+
+  explicit SnapshotLayout(const SnapshotHeader &h) {
+    keys = align_up(sizeof(SnapshotHeader));
+    offsets = align(add(keys, mul(h.key_count, h.key_size)));
+    values = align(add(offsets, mul(add(h.key_count, 1), sizeof(uint64_t))));
+    strings = align(add(values, mul(h.value_count, h.value_size)));
+    end = add(strings, h.string_bytes);
+  }
+
+private:
+  // Checked arithmetic: a crafted header must not wrap around to a layout
+  // that matches the file size
+  uint64_t add(uint64_t a, uint64_t b) {
+    overflow = overflow || a > UINT64_MAX - b;
+    return a + b;
+  }
+
+  uint64_t mul(uint64_t a, uint64_t b) {
+    overflow = overflow || (b != 0 && a > UINT64_MAX / b);
+    return a * b;
+  }
+
+  uint64_t align(uint64_t n) {
+    return add(n, snapshot_align - 1) / snapshot_align * snapshot_align;
+  }
+};
+
+/**
+ * @brief Sequential file writer that tracks the position and payload
+ * checksum. It writes to path + ".tmp" and finish() renames that over
+ * path, so processes mapping the old snapshot keep a valid mapping.
+ */
+class SnapshotWriter {
+private:
+  std::string path;
+  std::string tmp;
+  std::ofstream out;
+  uint64_t pos = 0;
+  uint64_t hash = fnv_offset;
+  bool done = false;
+
+public:
+  explicit SnapshotWriter(const std::string &path)
+      : path(path), tmp(path + ".tmp"),
+        out(tmp, std::ios::binary | std::ios::trunc) {
+    if (!out) {
+      throw std::runtime_error("save_binary: cannot open " + tmp);
+    }
+  }
+
+  SnapshotWriter(const SnapshotWriter &) = delete;
+  SnapshotWriter &operator=(const SnapshotWriter &) = delete;
+
+  /** Drop the temporary file unless finish() renamed it */
+  ~SnapshotWriter() {
+    if (!done) {
+      out.close();
+      std::remove(tmp.c_str());
+    }
+  }
+
+  void write(const void *data, size_t n) {
+    out.write(static_cast<const char *>(data),
+              static_cast<std::streamsize>(n));
+    if (pos >= sizeof(SnapshotHeader)) {
+      hash = fnv1a(data, n, hash);
+    }
+    pos += n;
+  }
+
+  /** Zero-fill up to the given offset */
+  void pad_to(uint64_t offset) {
+    static const char zeros[snapshot_align] = {};
+    while (pos < offset) {
+      write(zeros, std::min<uint64_t>(offset - pos, snapshot_align));
+    }
+  }
+
+  uint64_t checksum() const { return hash; }
+
+  /**
+   * @brief Rewrite the header now that the checksum is known, fsync the
+   * file and rename it into place.
+   */
+  void finish(const SnapshotHeader &header) {
+    out.seekp(0);
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.close();
+    if (!out) {
+      throw std::runtime_error("save_binary: cannot write " + tmp);
+    }
+    fsync_path(tmp, "save_binary");
+    rename_durably(tmp, path, "save_binary");
+    done = true;
+  }
+};
+
+/** Stored form of a span of keys or values, appending strings to table */
+template <typename T>
+std::vector<typename SnapshotType<T>::stored> encode(Span<const T> items,
+                                                     std::string &table) {
+  std::vector<StringRef> refs;
+  refs.reserve(items.size());
+  for (const T &s : items) {
+    refs.push_back({table.size(), s.size()});
+    table += s;
+  }
+  return refs;
+}
+
+/**
+ * @brief Random-access view of stored strings as std::string_view.
+ */
+class StringSpan {
+private:
+  const StringRef *refs = nullptr; /**< First reference */
+  size_t len = 0;                  /**< Number of strings */
+  const char *table = nullptr;     /**< String table */
+
+public:
+  class iterator {
+  private:
+    const StringRef *ref = nullptr;
+    const char *table = nullptr;
+
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = std::string_view;
+    using difference_type = ptrdiff_t;
+    using reference = std::string_view;
+    using pointer = void;
+
+    iterator() = default;
+    iterator(const StringRef *ref, const char *table)
+        : ref(ref), table(table) {}
+
+    reference operator*() const {
+      return {table + ref->offset, static_cast<size_t>(ref->length)};
+    }
+    reference operator[](difference_type n) const { return *(*this + n); }
+
+    iterator &operator++() {
+      ++ref;
+      return *this;
+    }
+    iterator operator++(int) { return iterator(ref++, table); }
+    iterator &operator--() {
+      --ref;
+      return *this;
+    }
+    iterator operator--(int) { return iterator(ref--, table); }
+    iterator &operator+=(difference_type n) {
+      ref += n;
+      return *this;
+    }
+    iterator &operator-=(difference_type n) {
+      ref -= n;
+      return *this;
+    }
+    friend iterator operator+(iterator it, difference_type n) {
+      return it += n;
+    }
+    friend iterator operator+(difference_type n, iterator it) {
+      return it += n;
+    }
+    friend iterator operator-(iterator it, difference_type n) {
+      return it -= n;
+    }
+    friend difference_type operator-(const iterator &a, const iterator &b) {
+      return a.ref - b.ref;
+    }
+    bool operator==(const iterator &other) const { return ref == other.ref; }
+    bool operator!=(const iterator &other) const { return ref != other.ref; }
+    bool operator<(const iterator &other) const { return ref < other.ref; }
+    bool operator>(const iterator &other) const { return ref > other.ref; }
+    bool operator<=(const iterator &other) const { return ref <= other.ref; }
+    bool operator>=(const iterator &other) const { return ref >= other.ref; }
+  };
+
+  using value_type = std::string_view;
+  using size_type = size_t;
+
+  StringSpan() = default;
+  StringSpan(const StringRef *refs, size_t n, const char *table)
+      : refs(refs), len(n), table(table) {}
+
+  iterator begin() const { return iterator(refs, table); }
+  iterator end() const { return iterator(refs + len, table); }
+  [[nodiscard]] size_type size() const { return len; }
+  [[nodiscard]] bool empty() const { return len == 0; }
+  std::string_view operator[](size_type i) const { return begin()[i]; }
+  std::string_view front() const { return (*this)[0]; }
+  std::string_view back() const { return (*this)[len - 1]; }
+};
+
+/** View of n stored elements: a Span, or a StringSpan for strings */
+template <typename T>
+using MappedSpan = std::conditional_t<SnapshotType<T>::is_string, StringSpan,
+                                      Span<const T>>;
+
+} // namespace detail
+
+/**
+ * @brief Save a FrozenMultiMap as a binary snapshot.
+ *
+ * The file holds a 64-byte header (magic, format version, byte order,
+ * stored type sizes, counts and an FNV-1a checksum of the payload), then
+ * the sorted keys, the key_count() + 1 value offsets as uint64_t, the
+ * values, and a table holding the bytes of std::string keys and values.
+ * Every section starts on a 64-byte boundary, so a mapping of the file
+ * can be read in place. The format uses the native byte order.
+ *
+ * The snapshot is written to path + ".tmp", synced and renamed over path,
+ * so a crash never leaves a partial file and existing mappings of path
+ * stay valid.
+ *
+ * @param frozen Map to save.
+ * @param path File to write.
+ * @throws std::runtime_error if the file cannot be written.
+ */
+template <typename K, typename V>
+void save_binary(const FrozenMultiMap<K, V> &frozen, const std::string &path) {
+  static_assert(SnapshotType<K>::supported && SnapshotType<V>::supported,
+                "snapshot keys and values must be trivially copyable or "
+                "std::string");
+  using KStored = typename SnapshotType<K>::stored;
+  using VStored = typename SnapshotType<V>::stored;
+  static_assert(alignof(KStored) <= detail::snapshot_align &&
+                    alignof(VStored) <= detail::snapshot_align,
+                "over-aligned types cannot be mapped");
+
+  std::string table;
+  std::vector<KStored> key_refs;
+  std::vector<VStored> value_refs;
+  if constexpr (SnapshotType<K>::is_string) {
+    key_refs = detail::encode(frozen.keys(), table);
+  }
+  if constexpr (SnapshotType<V>::is_string) {
+    value_refs = detail::encode(frozen.values(), table);
+  }
+
+  detail::SnapshotHeader header{};
+  std::memcpy(header.magic, detail::snapshot_magic, sizeof(header.magic));
+  header.version = detail::snapshot_version;
+  header.byte_order = detail::snapshot_byte_order;
+  header.flags = (SnapshotType<K>::is_string ? 1u : 0u) |
+                 (SnapshotType<V>::is_string ? 2u : 0u);
+  header.key_size = sizeof(KStored);
+  header.value_size = sizeof(VStored);
+  header.key_count = frozen.key_count();
+  header.value_count = frozen.size();
+  header.string_bytes = table.size();
+  detail::SnapshotLayout layout(header);
+
+  detail::SnapshotWriter out(path);
+  out.write(&header, sizeof(header));
+  out.pad_to(layout.keys);
+  if constexpr (SnapshotType<K>::is_string) {
+    out.write(key_refs.data(), key_refs.size() * sizeof(KStored));
+  } else {
+    out.write(frozen.keys().data(), frozen.key_count() * sizeof(K));
+  }
+  out.pad_to(layout.offsets);
+  for (size_t offset : frozen.offsets()) {
+    uint64_t stored = offset;
+    out.write(&stored, sizeof(stored));
+  }
+  out.pad_to(layout.values);
+  if constexpr (SnapshotType<V>::is_string) {
+    out.write(value_refs.data(), value_refs.size() * sizeof(VStored));
+  } else {
+    out.write(frozen.values().data(), frozen.size() * sizeof(V));
+  }
+  out.pad_to(layout.strings);
+  out.write(table.data(), table.size());
+
+  header.checksum = out.checksum();
+  out.finish(header);
+}
+
+/**
+ * @brief Save a MultiMap as a binary snapshot, see the FrozenMultiMap
+ * overload. Keys are written in std::less order whatever the dictionary.
+ *
+ * @param mm Map to save.
+ * @param path File to write.
+ * @throws std::runtime_error if the file cannot be written.
+ */
+template <typename K, typename V, template <typename...> class CTemplate,
+          template <typename...> class DTemplate, typename Stats>
+void save_binary(const MultiMap<K, V, CTemplate, DTemplate, Stats> &mm,
+                 const std::string &path) {
+  save_binary(FrozenMultiMap<K, V>(mm), path);
+}
+
+/**
+ * @brief Multimap read in place from a memory-mapped snapshot.
+ *
+ * Nothing is deserialized: lookups binary-search the mapped key section
+ * and views point straight into the mapped values, so opening costs a
+ * header check and pages are faulted in as they are touched. std::string
+ * keys and values are handed out as std::string_view into the mapping.
+ * The map is immutable and stays valid until it is destroyed.
+ *
+ * @tparam K Key type the snapshot was saved with.
+ * @tparam V Value type the snapshot was saved with.
+ */
+template <typename K, typename V> class MappedMultiMap {
+  static_assert(SnapshotType<K>::supported && SnapshotType<V>::supported,
+                "snapshot keys and values must be trivially copyable or "
+                "std::string");
+
+private:
+  using KStored = typename SnapshotType<K>::stored;
+  using VStored = typename SnapshotType<V>::stored;
+
+  MappedFile file;                   /**< The mapping */
+  const KStored *key_data = nullptr; /**< Sorted keys */
+  const uint64_t *starts = nullptr;  /**< key_total + 1 value offsets */
+  const VStored *value_data = nullptr; /**< Values grouped by key */
+  const char *strings = nullptr;       /**< String table */
+  size_t key_total = 0;                /**< Number of keys */
+  size_t value_total = 0;              /**< Number of values */
+  uint64_t payload_checksum = 0;       /**< Checksum from the header */
+
+public:
+  using key_type = typename SnapshotType<K>::view; /**< Type of keys */
+  using mapped_type =
+      typename SnapshotType<V>::view; /**< Type of values handed out */
+  using size_type = size_t;           /**< Size type */
+  using view_type =
+      detail::MappedSpan<V>; /**< Non-owning view of a key's values */
+
+  /**
+   * @brief Map a snapshot written by save_binary.
+   *
+   * @param path Snapshot file.
+   * @param verify Also check the payload checksum and offsets, which
+   * reads the whole file once; pass false to only check the header.
+   * @throws std::runtime_error if the file is missing, truncated, corrupt
+   * or was saved with other key or value types.
+   */
+  explicit MappedMultiMap(const std::string &path, bool verify = true)
+      : file(path) {
+    detail::SnapshotHeader header;
+    if (file.size() < sizeof(header)) {
+      throw std::runtime_error("load_mmap: truncated header in " + path);
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, detail::snapshot_magic,
+                    sizeof(header.magic)) != 0) {
+      throw std::runtime_error("load_mmap: not a snapshot: " + path);
+    }
+    if (header.version != detail::snapshot_version) {
+      throw std::runtime_error("load_mmap: unsupported version in " + path);
+    }
+    if (header.byte_order != detail::snapshot_byte_order) {
+      throw std::runtime_error("load_mmap: foreign byte order in " + path);
+    }
+    uint32_t flags = (SnapshotType<K>::is_string ? 1u : 0u) |
+                     (SnapshotType<V>::is_string ? 2u : 0u);
+    if (header.flags != flags || header.key_size != sizeof(KStored) ||
+        header.value_size != sizeof(VStored)) {
+      throw std::runtime_error("load_mmap: key or value type mismatch in " +
+                               path);
+    }
+    detail::SnapshotLayout layout(header);
+    if (layout.overflow || layout.end != file.size()) {
+      throw std::runtime_error("load_mmap: size mismatch in " + path);
+    }
+    if (verify) {
+      const char *payload = file.data() + sizeof(header);
+      if (detail::fnv1a(payload, file.size() - sizeof(header)) !=
+          header.checksum) {
+        throw std::runtime_error("load_mmap: checksum mismatch in " + path);
+      }
+    }
+
+    key_total = static_cast<size_t>(header.key_count);
+    value_total = static_cast<size_t>(header.value_count);
+    payload_checksum = header.checksum;
+    key_data = reinterpret_cast<const KStored *>(file.data() + layout.keys);
+    starts = reinterpret_cast<const uint64_t *>(file.data() + layout.offsets);
+    value_data =
+        reinterpret_cast<const VStored *>(file.data() + layout.values);
+    strings = file.data() + layout.strings;
+
+    if (verify && !consistent(header.string_bytes)) {
+      throw std::runtime_error("load_mmap: corrupt offsets in " + path);
+    }
+  }
+
+  // Capacity methods
+
+  [[nodiscard]] size_type size() const { return value_total; }
+  [[nodiscard]] size_type key_count() const { return key_total; }
+  [[nodiscard]] bool empty() const { return value_total == 0; }
+
+  /**
+   * @brief Estimate the bytes this map occupies. Everything but the
+   * object lives in the mapping, reported as mapped bytes: page cache
+   * shared with other mappings of the file, not heap.
+   *
+   * @return MemoryUsage The breakdown.
+   */
+  [[nodiscard]] MemoryUsage memory_usage() const {
+    MemoryUsage usage;
+    usage.object = sizeof(*this);
+    usage.mapped = file.size();
+    return usage;
+  }
+
+  /**
+   * @brief Get the payload checksum recorded in the header. Snapshots of
+   * equal contents have equal checksums, so it identifies a snapshot.
+   *
+   * @return uint64_t FNV-1a of everything after the header.
+   */
+  [[nodiscard]] uint64_t checksum() const { return payload_checksum; }
+
+  // Lookup methods
+
+  /**
+   * @brief Get a view of a key's values, empty if the key is absent.
+   *
+   * @param key Key to look up.
+   * @return view_type View into the mapped values.
+   */
+  [[nodiscard]] view_type view(const key_type &key) const {
+    size_t i = index_of(key);
+    return i == key_total ? view_type() : values_of(i);
+  }
+
+  size_type count(const key_type &key) const {
+    size_t i = index_of(key);
+    return i == key_total ? 0 : static_cast<size_type>(starts[i + 1] -
+                                                       starts[i]);
+  }
+
+  bool contains(const key_type &key) const {
+    return index_of(key) != key_total;
+  }
+
+  /**
+   * @brief Get the i-th key in sorted order.
+   *
+   * @param i Key index, less than key_count().
+   * @return key_type The key.
+   */
+  key_type key_at(size_t i) const { return decode<K>(key_data[i]); }
+
+  /**
+   * @brief Call f(key, view) once per key, in key order.
+   *
+   * @tparam F Callable taking (key_type, view_type).
+   * @param f Function to call for each key group.
+   */
+  template <typename F> void for_each_group(F &&f) const {
+    for (size_t i = 0; i < key_total; ++i) {
+      f(key_at(i), values_of(i));
+    }
+  }
+
+  /**
+   * @brief Copy the snapshot into a MultiMap.
+   *
+   * @tparam Map MultiMap type to build, whose key and value types are
+   * constructible from key_type and mapped_type.
+   * @return Map The materialized map.
+   */
+  template <typename Map = MultiMap<K, V>> Map materialize() const {
+    Map result;
+    for_each_group([&](const key_type &key, const view_type &values) {
+      result.insert(typename Map::key_type(key), values.begin(),
+                    values.end());
+    });
+    return result;
+  }
+
+private:
+  template <typename T>
+  typename SnapshotType<T>::view
+  decode(const typename SnapshotType<T>::stored &item) const {
+    if constexpr (SnapshotType<T>::is_string) {
+      return {strings + item.offset, static_cast<size_t>(item.length)};
+    } else {
+      return item;
+    }
+  }
+
+  view_type values_of(size_t i) const {
+    size_t n = static_cast<size_t>(starts[i + 1] - starts[i]);
+    const VStored *first = value_data + starts[i];
+    if constexpr (SnapshotType<V>::is_string) {
+      return view_type(first, n, strings);
+    } else {
+      return view_type(first, n);
+    }
+  }
+
+  /** Index of key in the sorted key section, or key_total when absent */
+  size_t index_of(const key_type &key) const {
+    size_t lo = 0;
+    size_t hi = key_total;
+    while (lo < hi) {
+      size_t mid = lo + (hi - lo) / 2;
+      if (key_at(mid) < key) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    return lo != key_total && !(key < key_at(lo)) ? lo : key_total;
+  }
+
+  /** Offsets are monotonic and strings stay inside the table */
+  bool consistent(uint64_t string_bytes) const {
+    if (starts[0] != 0 || starts[key_total] != value_total) {
+      return false;
+    }
+    for (size_t i = 0; i < key_total; ++i) {
+      if (starts[i] > starts[i + 1]) {
+        return false;
+      }
+    }
+    auto in_table = [&](const StringRef &ref) {
+      return ref.offset <= string_bytes &&
+             ref.length <= string_bytes - ref.offset;
+    };
+    if constexpr (SnapshotType<K>::is_string) {
+      if (!std::all_of(key_data, key_data + key_total, in_table)) {
+        return false;
+      }
+    }
+    if constexpr (SnapshotType<V>::is_string) {
+      if (!std::all_of(value_data, value_data + value_total, in_table)) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+/**
+ * @brief Map a snapshot written by save_binary.
+ *
+ * @tparam K Key type the snapshot was saved with.
+ * @tparam V Value type the snapshot was saved with.
+ * @param path Snapshot file.
+ * @param verify Check the payload checksum; see MappedMultiMap.
+ * @return MappedMultiMap<K, V> Map reading from the file in place.
+ * @throws std::runtime_error if the file cannot be loaded.
+ */
+template <typename K, typename V>
+MappedMultiMap<K, V> load_mmap(const std::string &path, bool verify = true) {
+  return MappedMultiMap<K, V>(path, verify);
+}
+
+} // namespace dictool
@@ -0,0 +1,345 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <optional>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace dictool {
+
+/**
+ * @brief Operation counts of a MultiMap instrumented with CountingStats.
+ */
+struct OperationCounts {
+  uint64_t lookups = 0;  /**< Read-only key lookups */
+  uint64_t hits = 0;     /**< Lookups that found the key */
+  uint64_t misses = 0;   /**< Lookups that did not */
+  uint64_t inserts = 0;  /**< Values added */
+  uint64_t erases = 0;   /**< Values removed */
+  uint64_t growths = 0;  /**< Reallocations of a value container */
+  uint64_t rehashes = 0; /**< Rehashes of a hashed dictionary */
+
+  OperationCounts &operator+=(const OperationCounts &other) {
+    lookups += other.lookups;
+    hits += other.hits;
+    misses += other.misses;
+    inserts += other.inserts;
+    erases += other.erases;
+    growths += other.growths;
+    rehashes += other.rehashes;
+    return *this;
+  }
+};
+
+/**
+ * @brief Instrumentation policy that records nothing, and the default of
+ * MultiMap. It is empty and every hook is an inline no-op, so a MultiMap
+ * using it stores and runs nothing extra.
+ */
+struct NoStats {
+  static constexpr bool enabled = false; /**< Hooks do nothing */
+
+  void on_lookup(bool) const {}
+  void on_insert(size_t) const {}
+  void on_erase(size_t) const {}
+  void on_growth() const {}
+  void on_rehash() const {}
+  OperationCounts counts() const { return {}; }
+  void reset() {}
+};
+
+/**
+ * @brief Instrumentation policy counting MultiMap operations.
+ *
+ * The counters are relaxed atomics bumped with a plain load and store
+ * rather than a locked read-modify-write, so threads reading one map
+ * concurrently, e.g. under a shared lock, count their lookups without a
+ * data race. Such concurrent bumps may lose increments: the counts are
+ * exact for single-threaded use and approximate otherwise. Copies of the
+ * map carry the counts along.
+ *
+ * Writes through a reference from MultiMap::operator[] are not seen as
+ * they happen. MultiMap::recount() and clear() report their net effect
+ * on the number of values as inserts or erases, and never as growths.
+ */
+class CountingStats {
+private:
+  using Counter = std::atomic<uint64_t>;
+
+  mutable Counter lookups{0};
+  mutable Counter hits{0};
+  mutable Counter inserts{0};
+  mutable Counter erases{0};
+  mutable Counter growths{0};
+  mutable Counter rehashes{0};
+
+  static void bump(Counter &c, uint64_t n = 1) {
+    c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+  }
+
+  static uint64_t read(const Counter &c) {
+    return c.load(std::memory_order_relaxed);
+  }
+
+public:
+  static constexpr bool enabled = true; /**< Hooks count */
+
+  CountingStats() = default;
+  CountingStats(const CountingStats &other) noexcept {
+    assign(other.counts());
+  }
+
+  CountingStats &operator=(const CountingStats &other) noexcept {
+    assign(other.counts());
+    return *this;
+  }
+
+  void on_lookup(bool hit) const {
+    bump(lookups);
+    if (hit) {
+      bump(hits);
+    }
+  }
+  void on_insert(size_t n) const { bump(inserts, n); }
+  void on_erase(size_t n) const { bump(erases, n); }
+  void on_growth() const { bump(growths); }
+  void on_rehash() const { bump(rehashes); }
+
+  /**
+   * @brief Get the counts so far.
+   *
+   * @return OperationCounts Snapshot of the counters.
+   */
+  OperationCounts counts() const {
+    OperationCounts c;
+    c.hits = read(hits);
+    c.lookups = std::max(read(lookups), c.hits);
+    c.misses = c.lookups - c.hits;
+    c.inserts = read(inserts);
+    c.erases = read(erases);
+    c.growths = read(growths);
+    c.rehashes = read(rehashes);
+    return c;
+  }
+
+  /**
+   * @brief Zero all counters.
+   */
+  void reset() { assign({}); }
+
+private:
+  void assign(const OperationCounts &c) {
+    lookups.store(c.lookups, std::memory_order_relaxed);
+    hits.store(c.hits, std::memory_order_relaxed);
+    inserts.store(c.inserts, std::memory_order_relaxed);
+    erases.store(c.erases, std::memory_order_relaxed);
+    growths.store(c.growths, std::memory_order_relaxed);
+    rehashes.store(c.rehashes, std::memory_order_relaxed);
+  }
+};
+
+namespace detail {
+
+/**
+ * @brief Type trait to check if a type can be written to an ostream.
+ *
+ * @tparam T The type to check.
+ * @tparam void SFINAE parameter.
+ */
+template <typename T, typename = void> struct IsStreamable : std::false_type {};
+
+template <typename T>
+struct IsStreamable<T, std::void_t<decltype(std::declval<std::ostream &>()
+                                            << std::declval<const T &>())>>
+    : std::true_type {};
+
+/** Write s as a JSON string literal */
+inline void write_json_string(std::ostream &os, const std::string &s) {
+  os << '"';
+  for (char ch : s) {
+    auto c = static_cast<unsigned char>(ch);
+    if (c == '"' || c == '\\') {
+      os << '\\' << ch;
+    } else if (c == '\n') {
+      os << "\\n";
+    } else if (c == '\t') {
+      os << "\\t";
+    } else if (c < 0x20) {
+      char buf[8];
+      std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+      os << buf;
+    } else {
+      os << ch;
+    }
+  }
+  os << '"';
+}
+
+/** Write a key as a JSON number, boolean, string, or null */
+template <typename K> void write_json_key(std::ostream &os, const K &key) {
+  if constexpr (std::is_same_v<K, bool>) {
+    os << (key ? "true" : "false");
+  } else if constexpr (std::is_integral_v<K>) {
+    os << +key;
+  } else if constexpr (std::is_floating_point_v<K>) {
+    if (std::isfinite(key)) {
+      os << key;
+    } else {
+      os << "null";
+    }
+  } else if constexpr (IsStreamable<K>::value) {
+    std::ostringstream text;
+    text << key;
+    write_json_string(os, text.str());
+  } else {
+    os << "null";
+  }
+}
+
+/** Histogram bucket of a key with n values: 0, then floor(log2 n) + 1 */
+inline size_t log2_bucket(size_t n) {
+  size_t bucket = 0;
+  for (; n != 0; n >>= 1) {
+    ++bucket;
+  }
+  return bucket;
+}
+
+} // namespace detail
+
+/**
+ * @brief Summary of a MultiMap's shape, as returned by MultiMap::stats().
+ *
+ * @tparam K Key type.
+ */
+template <typename K> struct MultiMapStats {
+  size_t keys = 0;       /**< Number of keys */
+  size_t values = 0;     /**< Number of values */
+  size_t max_values = 0; /**< Values of the heaviest key */
+  /**
+   * Log-scale histogram of values per key: entry 0 counts keys without
+   * values, entry b > 0 keys with 2^(b-1) to 2^b - 1 values.
+   */
+  std::vector<size_t> histogram;
+  std::vector<std::pair<K, size_t>> top_keys; /**< Heaviest keys first */
+  std::optional<double> load_factor;          /**< Hashed dictionaries only */
+  std::optional<OperationCounts> counts; /**< With CountingStats only */
+
+  /**
+   * @brief Get the mean number of values per key.
+   *
+   * @return double Mean, 0 for an empty map.
+   */
+  [[nodiscard]] double mean_values() const {
+    return keys == 0 ? 0.0
+                     : static_cast<double>(values) / static_cast<double>(keys);
+  }
+
+  /**
+   * @brief Write the summary as one JSON object. Keys are written as JSON
+   * numbers when arithmetic, as strings through operator<< otherwise, and
+   * as null if they cannot be printed.
+   *
+   * @param os Stream to write to.
+   */
+  void write_json(std::ostream &os) const {
+    os << "{\"keys\":" << keys << ",\"values\":" << values
+       << ",\"mean_values\":" << mean_values()
+       << ",\"max_values\":" << max_values << ",\"histogram\":[";
+    for (size_t b = 0; b < histogram.size(); ++b) {
+      size_t lo = b == 0 ? 0 : size_t(1) << (b - 1);
+      size_t hi = b == 0 ? 0 : (size_t(1) << (b - 1)) * 2 - 1;
+      os << (b == 0 ? "" : ",") << "{\"min\":" << lo << ",\"max\":" << hi
+         << ",\"keys\":" << histogram[b] << "}";
+    }
+    os << "],\"top_keys\":[";
+    for (size_t i = 0; i < top_keys.size(); ++i) {
+      os << (i == 0 ? "" : ",") << "{\"key\":";
+      detail::write_json_key(os, top_keys[i].first);
+      os << ",\"values\":" << top_keys[i].second << "}";
+    }
+    os << "],\"load_factor\":";
+    if (load_factor) {
+      os << *load_factor;
+    } else {
+      os << "null";
+    }
+    os << ",\"operations\":";
+    if (counts) {
+      os << "{\"lookups\":" << counts->lookups << ",\"hits\":" << counts->hits
+         << ",\"misses\":" << counts->misses
+         << ",\"inserts\":" << counts->inserts
+         << ",\"erases\":" << counts->erases
+         << ",\"growths\":" << counts->growths
+         << ",\"rehashes\":" << counts->rehashes << "}";
+    } else {
+      os << "null";
+    }
+    os << "}";
+  }
+
+  /**
+   * @brief Get the summary as a JSON string, see write_json().
+   *
+   * @return std::string JSON object.
+   */
+  [[nodiscard]] std::string to_json() const {
+    std::ostringstream os;
+    write_json(os);
+    return os.str();
+  }
+
+  /**
+   * @brief Write the summary as human-readable text.
+   *
+   * @param os Stream to write to.
+   */
+  void print(std::ostream &os) const {
+    os << "Total keys: " << keys << "\n";
+    os << "Total values: " << values << "\n";
+    os << "Values per key: mean " << mean_values() << ", max " << max_values
+       << "\n";
+    for (size_t b = 0; b < histogram.size(); ++b) {
+      if (b <= 1) {
+        os << "  " << (b == 0 ? 0 : 1);
+      } else {
+        size_t lo = size_t(1) << (b - 1);
+        os << "  " << lo << "-" << lo * 2 - 1;
+      }
+      os << ": " << histogram[b] << " keys\n";
+    }
+    if (!top_keys.empty()) {
+      os << "Heaviest keys:\n";
+      for (const auto &[key, n] : top_keys) {
+        os << "  ";
+        if constexpr (detail::IsStreamable<K>::value) {
+          os << key;
+        } else {
+          os << "?";
+        }
+        os << ": " << n << " values\n";
+      }
+    }
+    if (load_factor) {
+      os << "Load factor: " << *load_factor << "\n";
+    }
+    if (counts) {
+      os << "Lookups: " << counts->lookups << " (" << counts->hits
+         << " hits, " << counts->misses << " misses)\n";
+      os << "Inserts: " << counts->inserts << ", erases: " << counts->erases
+         << "\n";
+      os << "Container growths: " << counts->growths
+         << ", rehashes: " << counts->rehashes << "\n";
+    }
+  }
+};
+
+} // namespace dictool
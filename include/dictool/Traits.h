@@ -0,0 +1,65 @@
+#pragma once
+
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+namespace dictool {
+
+/**
+ * @brief Type trait to check if a comparator or hasher is transparent,
+ * i.e. accepts any type comparable with its key type.
+ *
+ * @tparam T The function object type to check.
+ * @tparam void SFINAE parameter.
+ */
+template <typename T, typename = void>
+struct IsTransparent : std::false_type {};
+
+template <typename T>
+struct IsTransparent<T, std::void_t<typename T::is_transparent>>
+    : std::true_type {};
+
+/**
+ * @brief Type trait to check if std::hash is enabled for a type.
+ *
+ * @tparam T The type to check.
+ * @tparam void SFINAE parameter.
+ */
+template <typename T, typename = void> struct IsHashable : std::false_type {};
+
+template <typename T>
+struct IsHashable<
+    T, std::void_t<decltype(std::hash<T>{}(std::declval<const T &>()))>>
+    : std::true_type {};
+
+/**
+ * @brief Type trait to check if a container has a capacity method.
+ *
+ * @tparam T The container type to check.
+ * @tparam void SFINAE parameter.
+ */
+template <typename T, typename = void>
+struct HasCapacity : std::false_type {};
+
+template <typename T>
+struct HasCapacity<T, std::void_t<decltype(std::declval<const T &>()
+                                               .capacity())>>
+    : std::true_type {};
+
+/**
+ * @brief Type trait to check if a dictionary is hashed.
+ *
+ * @tparam T The dictionary type to check.
+ * @tparam void SFINAE parameter.
+ */
+template <typename T, typename = void> struct HasHasher : std::false_type {};
+
+template <typename T>
+struct HasHasher<T,
+                 std::void_t<typename T::hasher,
+                             decltype(std::declval<T>().hash_function()),
+                             decltype(std::declval<T>().key_eq())>>
+    : std::true_type {};
+
+} // namespace dictool
@@ -0,0 +1,354 @@
+#pragma once
+
+#include "dictool/MultiDict.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace dictool {
+
+/**
+ * @brief Single-writer, many-reader holder of immutable map versions with
+ * epoch-based reclamation.
+ *
+ * The writer builds or patches a new version off to the side and
+ * publishes it with one atomic exchange. Readers register once to get a
+ * Reader, then pin the current version for the length of a lookup. A pin
+ * is one load and one store of atomics plus a load of the version
+ * pointer: no lock, no reference count and no retry loop, so reads are
+ * wait-free and never contend with each other.
+ *
+ * A replaced version is retired with the epoch at which it stopped being
+ * current. Each reader slot records the epoch it pinned at, and a retired
+ * version is freed once every pinned slot has moved past its epoch, i.e.
+ * once no reader can still be looking at it.
+ *
+ * Map can be any type, typically a MultiMap or a FrozenMultiMap. Readers
+ * only get const access to it.
+ *
+ * @tparam Map Type of each published version.
+ */
+template <typename Map> class VersionedMultiMap {
+private:
+  /**
+   * @brief Per-reader epoch announcement. Slots are never freed before
+   * the map, only recycled, so the writer can scan them without locking.
+   */
+  struct alignas(64) Slot {
+    std::atomic<uint64_t> epoch{0}; /**< Pinned epoch, 0 when not reading */
+    std::atomic<bool> taken{true};  /**< Owned by a live Reader */
+    Slot *next = nullptr;           /**< Next slot in the registry */
+  };
+
+  /**
+   * @brief Version that is no longer current, waiting for its readers.
+   */
+  struct Retired {
+    const Map *map; /**< Replaced version */
+    uint64_t epoch; /**< Epoch readers must reach before it can go */
+  };
+
+  std::atomic<const Map *> current;           /**< Version new pins see */
+  std::atomic<uint64_t> epoch{1};             /**< Bumped per publish */
+  mutable std::atomic<Slot *> slots{nullptr}; /**< Reader slot registry */
+  mutable std::mutex writer;                  /**< Serializes writers */
+  std::vector<Retired> retired;               /**< Guarded by writer */
+  std::atomic<uint64_t> published{0};         /**< Publishes so far */
+
+public:
+  using map_type = Map; /**< Type of each published version */
+
+  /**
+   * @brief RAII pin on one version. The version stays alive, unchanged,
+   * until the Snapshot is destroyed.
+   */
+  class Snapshot {
+  private:
+    friend class VersionedMultiMap;
+
+    const Map *map = nullptr; /**< Pinned version */
+    Slot *slot = nullptr;     /**< Slot holding the pin */
+
+    Snapshot(const Map *map, Slot *slot) : map(map), slot(slot) {}
+
+  public:
+    Snapshot() = default;
+    Snapshot(const Snapshot &) = delete;
+    Snapshot &operator=(const Snapshot &) = delete;
+
+    Snapshot(Snapshot &&other) noexcept
+        : map(std::exchange(other.map, nullptr)),
+          slot(std::exchange(other.slot, nullptr)) {}
+
+    Snapshot &operator=(Snapshot &&other) noexcept {
+      if (this != &other) {
+        release();
+        map = std::exchange(other.map, nullptr);
+        slot = std::exchange(other.slot, nullptr);
+      }
+      return *this;
+    }
+
+    ~Snapshot() { release(); }
+
+    const Map &operator*() const { return *map; }
+    const Map *operator->() const { return map; }
+    const Map *get() const { return map; }
+
+    /**
+     * @brief Drop the pin early.
+     */
+    void release() {
+      if (slot != nullptr) {
+        slot->epoch.store(0, std::memory_order_release);
+        slot = nullptr;
+        map = nullptr;
+      }
+    }
+  };
+
+  /**
+   * @brief Registered reader. Each reading thread keeps one and pins
+   * through it. A Reader must not be shared between threads, holds at
+   * most one Snapshot at a time, and must outlive that Snapshot.
+   */
+  class Reader {
+  private:
+    friend class VersionedMultiMap;
+
+    const VersionedMultiMap *owner = nullptr; /**< Map read from */
+    Slot *slot = nullptr;                     /**< Epoch announcement */
+
+    Reader(const VersionedMultiMap *owner, Slot *slot)
+        : owner(owner), slot(slot) {}
+
+  public:
+    Reader() = default;
+    Reader(const Reader &) = delete;
+    Reader &operator=(const Reader &) = delete;
+
+    Reader(Reader &&other) noexcept
+        : owner(std::exchange(other.owner, nullptr)),
+          slot(std::exchange(other.slot, nullptr)) {}
+
+    Reader &operator=(Reader &&other) noexcept {
+      if (this != &other) {
+        unregister();
+        owner = std::exchange(other.owner, nullptr);
+        slot = std::exchange(other.slot, nullptr);
+      }
+      return *this;
+    }
+
+    ~Reader() { unregister(); }
+
+    /**
+     * @brief Pin the current version. Wait-free.
+     *
+     * @return Snapshot Handle keeping the version alive.
+     */
+    Snapshot pin() const {
+      // Announce the epoch before reading the pointer: a writer that
+      // retires the version loaded below bumps the epoch after its
+      // exchange, so it sees this announcement when it scans
+      slot->epoch.store(owner->epoch.load(std::memory_order_seq_cst),
+                        std::memory_order_seq_cst);
+      return Snapshot(owner->current.load(std::memory_order_seq_cst), slot);
+    }
+
+  private:
+    void unregister() {
+      if (slot != nullptr) {
+        slot->epoch.store(0, std::memory_order_release);
+        slot->taken.store(false, std::memory_order_release);
+        slot = nullptr;
+      }
+    }
+  };
+
+  /**
+   * @brief Construct with an initial version.
+   *
+   * @param initial First published version.
+   */
+  explicit VersionedMultiMap(Map initial = Map())
+      : current(new Map(std::move(initial))) {}
+
+  VersionedMultiMap(const VersionedMultiMap &) = delete;
+  VersionedMultiMap &operator=(const VersionedMultiMap &) = delete;
+
+  /**
+   * @brief Destroy all versions. No Snapshot may outlive the map.
+   */
+  ~VersionedMultiMap() {
+    delete current.load();
+    for (const Retired &r : retired) {
+      delete r.map;
+    }
+    for (Slot *s = slots.load(); s != nullptr;) {
+      delete std::exchange(s, s->next);
+    }
+  }
+
+  // Reader side
+
+  /**
+   * @brief Register a reader, reusing a released slot when one is free.
+   * Lock-free; meant to be called once per reading thread.
+   *
+   * @return Reader Handle to pin versions through.
+   */
+  Reader reader() const {
+    for (Slot *s = slots.load(std::memory_order_acquire); s != nullptr;
+         s = s->next) {
+      bool expected = false;
+      if (!s->taken.load(std::memory_order_relaxed) &&
+          s->taken.compare_exchange_strong(expected, true,
+                                           std::memory_order_acquire)) {
+        return Reader(this, s);
+      }
+    }
+    Slot *s = new Slot();
+    s->next = slots.load(std::memory_order_relaxed);
+    while (!slots.compare_exchange_weak(s->next, s, std::memory_order_release,
+                                        std::memory_order_relaxed)) {
+    }
+    return Reader(this, s);
+  }
+
+  // Writer side
+
+  /**
+   * @brief Make next the current version. Readers pinned before this call
+   * keep seeing the previous version until they release it.
+   *
+   * @param next New version.
+   */
+  void publish(Map next) {
+    auto *fresh = new Map(std::move(next));
+    std::lock_guard<std::mutex> guard(writer);
+    install(fresh);
+  }
+
+  /**
+   * @brief Copy the current version, apply f to the copy, and publish the
+   * result.
+   *
+   * @tparam F Callable taking Map&.
+   * @param f Patch to apply.
+   */
+  template <typename F> void update(F &&f) {
+    std::lock_guard<std::mutex> guard(writer);
+    auto next = std::make_unique<Map>(*current.load());
+    f(*next);
+    install(next.release());
+  }
+
+  /**
+   * @brief Free the retired versions no reader can still see. publish()
+   * and update() already do this; call it to release memory sooner after
+   * long-held snapshots go away.
+   *
+   * @return size_t Number of versions freed.
+   */
+  size_t reclaim() {
+    std::lock_guard<std::mutex> guard(writer);
+    return reclaim_retired();
+  }
+
+  /**
+   * @brief Get the number of replaced versions still waiting for readers.
+   *
+   * @return size_t Number of retired versions.
+   */
+  size_t retired_count() const {
+    std::lock_guard<std::mutex> guard(writer);
+    return retired.size();
+  }
+
+  /**
+   * @brief Estimate the bytes held by all versions, the current one and
+   * the retired ones still waiting for readers, each through Map's own
+   * memory_usage(), plus the reader slots as structure.
+   *
+   * @return MemoryUsage The breakdown.
+   */
+  MemoryUsage memory_usage() const {
+    std::lock_guard<std::mutex> guard(writer);
+    MemoryUsage usage;
+    usage.object = sizeof(*this);
+    auto add_version = [&usage](const Map *map) {
+      usage += map->memory_usage();
+      usage.add_block(sizeof(Map));
+    };
+    add_version(current.load());
+    for (const Retired &r : retired) {
+      add_version(r.map);
+    }
+    usage.structure += retired.capacity() * sizeof(Retired);
+    if (retired.capacity() != 0) {
+      usage.add_block(retired.capacity() * sizeof(Retired));
+    }
+    size_t slot_count = 0;
+    for (Slot *s = slots.load(std::memory_order_acquire); s != nullptr;
+         s = s->next) {
+      ++slot_count;
+    }
+    usage.structure += slot_count * sizeof(Slot);
+    usage.add_block(sizeof(Slot), slot_count);
+    return usage;
+  }
+
+  /**
+   * @brief Get the number of versions published after the initial one.
+   *
+   * @return uint64_t Number of publishes.
+   */
+  uint64_t version() const { return published.load(); }
+
+private:
+  /** Swap in fresh and retire the previous version; writer is held */
+  void install(const Map *fresh) {
+    const Map *old = current.exchange(fresh, std::memory_order_seq_cst);
+    // Readers that announce this epoch or later load the pointer after
+    // the exchange above, so they can only see fresh
+    uint64_t next_epoch = epoch.fetch_add(1, std::memory_order_seq_cst) + 1;
+    retired.push_back({old, next_epoch});
+    published.fetch_add(1, std::memory_order_relaxed);
+    reclaim_retired();
+  }
+
+  /** Oldest epoch announced by a pinned reader, or UINT64_MAX */
+  uint64_t oldest_pin() const {
+    uint64_t oldest = UINT64_MAX;
+    for (Slot *s = slots.load(std::memory_order_acquire); s != nullptr;
+         s = s->next) {
+      uint64_t e = s->epoch.load(std::memory_order_seq_cst);
+      if (e != 0 && e < oldest) {
+        oldest = e;
+      }
+    }
+    return oldest;
+  }
+
+  size_t reclaim_retired() {
+    uint64_t oldest = oldest_pin();
+    size_t freed = 0;
+    auto keep = retired.begin();
+    for (auto it = retired.begin(); it != retired.end(); ++it) {
+      if (it->epoch <= oldest) {
+        delete it->map;
+        ++freed;
+      } else {
+        *keep++ = *it;
+      }
+    }
+    retired.erase(keep, retired.end());
+    return freed;
+  }
+};
+
+} // namespace dictool
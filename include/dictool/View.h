@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+namespace dictool {
+
+/**
+ * @brief Type trait to check if a container stores its elements
+ * contiguously, i.e. exposes a data() pointer to its value_type.
+ *
+ * @tparam T The container type to check.
+ * @tparam void SFINAE parameter.
+ */
+template <typename T, typename = void>
+struct IsContiguous : std::false_type {};
+
+template <typename T>
+struct IsContiguous<T, std::void_t<decltype(std::declval<const T &>().data())>>
+    : std::is_same<decltype(std::declval<const T &>().data()),
+                   const typename T::value_type *> {};
+
+/**
+ * @brief Helper function to check if a container is contiguous.
+ *
+ * @tparam T The container type to check.
+ * @return true if container exposes contiguous storage, false otherwise.
+ */
+template <typename T> constexpr bool is_contiguous() {
+  return IsContiguous<T>::value;
+}
+
+/**
+ * @brief Non-owning view of a contiguous sequence, a minimal std::span.
+ *
+ * @tparam T Element type, usually const-qualified.
+ */
+template <typename T> class Span {
+private:
+  T *ptr = nullptr; /**< First element */
+  size_t len = 0;   /**< Number of elements */
+
+public:
+  using element_type = T;
+  using value_type = std::remove_cv_t<T>;
+  using size_type = size_t;
+  using difference_type = ptrdiff_t;
+  using pointer = T *;
+  using reference = T &;
+  using iterator = T *;
+
+  /**
+   * @brief Construct an empty span.
+   */
+  constexpr Span() = default;
+
+  /**
+   * @brief Construct a span over n elements starting at ptr.
+   *
+   * @param ptr First element.
+   * @param n Number of elements.
+   */
+  constexpr Span(T *ptr, size_t n) : ptr(ptr), len(n) {}
+
+  constexpr iterator begin() const { return ptr; }
+  constexpr iterator end() const { return ptr + len; }
+  constexpr pointer data() const { return ptr; }
+  [[nodiscard]] constexpr size_type size() const { return len; }
+  [[nodiscard]] constexpr bool empty() const { return len == 0; }
+  constexpr reference operator[](size_type i) const { return ptr[i]; }
+  constexpr reference front() const { return ptr[0]; }
+  constexpr reference back() const { return ptr[len - 1]; }
+};
+
+/**
+ * @brief Non-owning view of an iterator range with a known size.
+ *
+ * @tparam It Iterator type.
+ */
+template <typename It> class Range {
+private:
+  It first{};     /**< Beginning of the range */
+  It last{};      /**< End of the range */
+  size_t len = 0; /**< Number of elements */
+
+public:
+  using iterator = It;
+  using value_type = typename std::iterator_traits<It>::value_type;
+  using reference = typename std::iterator_traits<It>::reference;
+  using size_type = size_t;
+
+  /**
+   * @brief Construct an empty range.
+   */
+  Range() = default;
+
+  /**
+   * @brief Construct a range of n elements.
+   *
+   * @param first Beginning of the range.
+   * @param last End of the range.
+   * @param n Number of elements between first and last.
+   */
+  Range(It first, It last, size_t n)
+      : first(std::move(first)), last(std::move(last)), len(n) {}
+
+  iterator begin() const { return first; }
+  iterator end() const { return last; }
+  [[nodiscard]] size_type size() const { return len; }
+  [[nodiscard]] bool empty() const { return len == 0; }
+};
+
+/**
+ * @brief View type for a container: Span for contiguous ones, Range of
+ * const iterators otherwise.
+ *
+ * @tparam C Container type.
+ */
+template <typename C>
+using ViewOf = std::conditional_t<is_contiguous<C>(),
+                                  Span<const typename C::value_type>,
+                                  Range<typename C::const_iterator>>;
+
+/**
+ * @brief Build a non-owning view over a container.
+ *
+ * @param c Container to view.
+ * @return ViewOf<C> View over all elements of c.
+ */
+template <typename C> ViewOf<C> make_view(const C &c) {
+  if constexpr (is_contiguous<C>()) {
+    return {c.data(), c.size()};
+  } else {
+    return {c.begin(), c.end(), c.size()};
+  }
+}
+
+} // namespace dictool
@@ -0,0 +1,78 @@
+#include "heap.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<size_t> g_live{0};
+std::atomic<size_t> g_blocks{0};
+std::atomic<size_t> g_allocs{0};
+
+// Each block is prefixed with its size, padded to keep the default alignment,
+// so unsized deletes can be accounted
+constexpr size_t kHeader = alignof(std::max_align_t);
+
+} // namespace
+
+namespace counting_heap {
+
+size_t live_bytes() { return g_live.load(std::memory_order_relaxed); }
+
+size_t live_blocks() { return g_blocks.load(std::memory_order_relaxed); }
+
+size_t allocations() { return g_allocs.load(std::memory_order_relaxed); }
+
+} // namespace counting_heap
+
+// Every unaligned form is replaced: sanitizer runtimes define the array and
+// nothrow forms themselves instead of forwarding them to operator new
+void *operator new(size_t n, const std::nothrow_t &) noexcept {
+  auto *block = static_cast<char *>(std::malloc(n + kHeader));
+  if (block == nullptr) {
+    return nullptr;
+  }
+  *reinterpret_cast<size_t *>(block) = n;
+  g_live.fetch_add(n, std::memory_order_relaxed);
+  g_blocks.fetch_add(1, std::memory_order_relaxed);
+  g_allocs.fetch_add(1, std::memory_order_relaxed);
+  return block + kHeader;
+}
+
+void *operator new(size_t n) {
+  if (void *p = operator new(n, std::nothrow)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void *operator new[](size_t n) { return operator new(n); }
+
+void *operator new[](size_t n, const std::nothrow_t &) noexcept {
+  return operator new(n, std::nothrow);
+}
+
+void operator delete(void *p) noexcept {
+  if (p == nullptr) {
+    return;
+  }
+  auto *block = static_cast<char *>(p) - kHeader;
+  g_live.fetch_sub(*reinterpret_cast<size_t *>(block),
+                   std::memory_order_relaxed);
+  g_blocks.fetch_sub(1, std::memory_order_relaxed);
+  std::free(block);
+}
+
+void operator delete(void *p, size_t) noexcept { operator delete(p); }
+
+void operator delete(void *p, const std::nothrow_t &) noexcept {
+  operator delete(p);
+}
+
+void operator delete[](void *p) noexcept { operator delete(p); }
+
+void operator delete[](void *p, size_t) noexcept { operator delete(p); }
+
+void operator delete[](void *p, const std::nothrow_t &) noexcept {
+  operator delete(p);
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+
+// Global heap accounting, fed by the operator new/delete replacements in
+// heap.cc. Tests and footprint benchmarks link it through the
+// dictool_counting_heap target to see what a data structure really takes
+// from the heap; anything timing the real allocator must not link it.
+namespace counting_heap {
+
+// Bytes currently allocated through global operator new
+size_t live_bytes();
+
+// Blocks currently allocated through global operator new
+size_t live_blocks();
+
+// Number of calls to global operator new so far
+size_t allocations();
+
+} // namespace counting_heap
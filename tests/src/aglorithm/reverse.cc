@@ -1,6 +1,12 @@
 #include "dictool/Aglorithm.h"
+#include "dictool/FlatHashMap.h"
+#include "dictool/FlatMap.h"
 #include "gmock/gmock.h"
 #include <gtest/gtest.h>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 using namespace dictool;
 
@@ -61,3 +67,86 @@ TEST(ReverseMapTest, EmptyInput) {
   auto output = reverse(input);
   EXPECT_TRUE(output.empty());
 }
+
+// Test the counted variant matches reverse, keys in input order
+TEST(ReverseMapTest, Counted) {
+  std::map<int, int> input;
+  for (int k = 0; k < 1000; ++k) {
+    input.emplace(k, k % 7);
+  }
+  auto output = reverse_counted(input);
+  EXPECT_EQ(output, reverse(input));
+  ASSERT_EQ(output.size(), 7u);
+  EXPECT_EQ(output[3].capacity(), output[3].size());
+  EXPECT_EQ(output[3].front(), 3);
+  EXPECT_EQ(output[3].back(), 997);
+
+  std::unordered_map<std::string, int> hashed = {{"a", 1}, {"b", 2}};
+  auto hashed_output = reverse_counted(hashed);
+  EXPECT_THAT(hashed_output[1], ::testing::ElementsAre("a"));
+  EXPECT_THAT(hashed_output[2], ::testing::ElementsAre("b"));
+  EXPECT_TRUE(reverse_counted(std::map<int, int>()).empty());
+
+  flat_map<int, int> flat(input.begin(), input.end());
+  auto flat_output = reverse_counted(flat);
+  EXPECT_EQ(flat_output.size(), 7u);
+  EXPECT_EQ(flat_output.at(3), output.at(3));
+  flat_hash_map<int, int> flat_hash(input.begin(), input.end());
+  EXPECT_EQ(reverse_counted(flat_hash).at(3).size(), output.at(3).size());
+}
+
+// Test the parallel variant matches reverse for any thread count
+TEST(ReverseMapTest, Parallel) {
+  std::map<int, int> input;
+  for (int k = 0; k < 1000; ++k) {
+    input.emplace(k, k % 13);
+  }
+  auto expected = reverse(input);
+  for (size_t threads : {0, 1, 2, 3, 8, 2000}) {
+    EXPECT_EQ(reverse_parallel(input, threads), expected) << threads;
+  }
+
+  std::unordered_map<int, int> hashed(input.begin(), input.end());
+  auto output = reverse_parallel(hashed, 4);
+  ASSERT_EQ(output.size(), 13u);
+  EXPECT_EQ(output[5].size(), reverse(hashed)[5].size());
+  EXPECT_TRUE(reverse_parallel(std::map<int, int>(), 4).empty());
+}
+
+// Test a many-to-many MultiMap is inverted, keys in input order
+TEST(ReverseMapTest, MultiMap) {
+  MultiMap<std::string, int> mm;
+  mm.emplace("a", 1);
+  mm.emplace("a", 2);
+  mm.emplace("b", 2);
+  mm.emplace("c", 1);
+  mm.emplace("c", 3);
+
+  MultiMap<int, std::string> inverted = reverse(mm);
+  EXPECT_EQ(inverted.size(), mm.size());
+  EXPECT_THAT(inverted.at(1), ::testing::ElementsAre("a", "c"));
+  EXPECT_THAT(inverted.at(2), ::testing::ElementsAre("a", "b"));
+  EXPECT_THAT(inverted.at(3), ::testing::ElementsAre("c"));
+  // Values were added in ascending order, so inverting twice round-trips
+  EXPECT_EQ(reverse(inverted).cdata(), mm.cdata());
+
+  MultiMap<int, int, std::vector, std::unordered_map> hashed;
+  hashed.emplace(1, 10);
+  hashed.emplace(2, 10);
+  auto hashed_inverted = reverse(hashed);
+  EXPECT_THAT(hashed_inverted.at(10), ::testing::UnorderedElementsAre(1, 2));
+}
+
+// Test release moves the dictionary out and leaves the map empty
+TEST(ReverseMapTest, Release) {
+  MultiMap<int, int> mm;
+  mm.emplace(1, 1);
+  mm.emplace(1, 2);
+  auto dict = mm.release();
+  EXPECT_EQ(dict.size(), 1u);
+  EXPECT_EQ(dict[1].size(), 2u);
+  EXPECT_TRUE(mm.empty());
+  EXPECT_EQ(mm.size(), 0u);
+  mm.emplace(2, 2);
+  EXPECT_EQ(mm.size(), 1u);
+}
@@ -0,0 +1,182 @@
+#include "dictool/MultiDict.h"
+#include "heap.h"
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <memory_resource>
+#include <new>
+#include <string>
+
+using namespace dictool;
+
+// Memory resource counting what it hands out and gets back
+class CountingResource : public std::pmr::memory_resource {
+public:
+  size_t allocations = 0;
+  size_t outstanding = 0;
+
+private:
+  void *do_allocate(size_t bytes, size_t align) override {
+    ++allocations;
+    outstanding += bytes;
+    return upstream->allocate(bytes, align);
+  }
+
+  void do_deallocate(void *p, size_t bytes, size_t align) override {
+    outstanding -= bytes;
+    upstream->deallocate(p, bytes, align);
+  }
+
+  bool do_is_equal(const memory_resource &other) const noexcept override {
+    return this == &other;
+  }
+
+  std::pmr::memory_resource *upstream = std::pmr::new_delete_resource();
+};
+
+using PmrMultiMap = MultiMap<int, int, std::pmr::vector, std::pmr::map>;
+using PmrHashMultiMap =
+    MultiMap<int, int, std::pmr::vector, std::pmr::unordered_map>;
+
+// Exercise the common operations of a multimap
+template <typename Map> static void exercise(Map &mm) {
+  for (int i = 0; i < 200; ++i) {
+    mm.emplace(i % 20, i);
+  }
+  mm.try_emplace(100, 1);
+  mm.insert({101, 2});
+  EXPECT_EQ(mm.count(3), 10u);
+  EXPECT_EQ(mm.view(3).size(), 10u);
+  mm.erase(5);
+  mm.erase(mm.find(6));
+  mm.erase_if([](int, int v) { return v % 7 == 0; });
+  long sum = 0;
+  for (const auto &[key, value] : mm) {
+    sum += value;
+  }
+  EXPECT_GT(sum, 0);
+}
+
+// Test a pmr MultiMap on a stack arena makes no global allocations
+TEST(MultiMapAllocatorTest, NoGlobalAllocations) {
+  alignas(std::max_align_t) static char buffer[1 << 16];
+  size_t before = counting_heap::allocations();
+  {
+    std::pmr::monotonic_buffer_resource arena(
+        buffer, sizeof(buffer), std::pmr::null_memory_resource());
+    PmrMultiMap mm(&arena);
+    exercise(mm);
+
+    PmrHashMultiMap hashed(&arena);
+    exercise(hashed);
+
+    PmrMultiMap other(&arena);
+    other.emplace(1, 1000);
+    other.emplace(500, 1);
+    mm.merge(std::move(other));
+    EXPECT_EQ(mm.count(500), 1u);
+  }
+  EXPECT_EQ(counting_heap::allocations() - before, 0u);
+}
+
+// Test nodes and value containers all come from the map's resource
+TEST(MultiMapAllocatorTest, CountingResource) {
+  CountingResource resource;
+  {
+    PmrMultiMap mm(&resource);
+    EXPECT_EQ(mm.get_allocator().resource(), &resource);
+    exercise(mm);
+    EXPECT_GT(resource.allocations, 0u);
+    EXPECT_GT(resource.outstanding, 0u);
+    for (const auto &[key, values] : mm.groups()) {
+      EXPECT_EQ(mm.at(key).get_allocator().resource(), &resource);
+    }
+  }
+  EXPECT_EQ(resource.outstanding, 0u);
+}
+
+// Test merging maps on different resources copies instead of splicing
+TEST(MultiMapAllocatorTest, MergeAcrossResources) {
+  CountingResource a_resource;
+  CountingResource b_resource;
+  {
+    PmrMultiMap a(&a_resource);
+    PmrMultiMap b(&b_resource);
+    a.emplace(1, 1);
+    b.emplace(1, 2);
+    b.emplace(2, 3);
+    a.merge(std::move(b));
+
+    EXPECT_EQ(a.size(), 3u);
+    EXPECT_TRUE(b.empty());
+    EXPECT_THAT(a.view(1), ::testing::ElementsAre(1, 2));
+    EXPECT_EQ(a.at(2).get_allocator().resource(), &a_resource);
+  }
+  EXPECT_EQ(a_resource.outstanding, 0u);
+  EXPECT_EQ(b_resource.outstanding, 0u);
+}
+
+// Test allocator-extended copy and move
+TEST(MultiMapAllocatorTest, CopyMoveWithAllocator) {
+  CountingResource source;
+  CountingResource target;
+  PmrMultiMap mm({{1, 1}, {1, 2}, {2, 3}}, &source);
+
+  PmrMultiMap copy(mm, &target);
+  EXPECT_EQ(copy.size(), 3u);
+  EXPECT_EQ(copy.get_allocator().resource(), &target);
+
+  PmrMultiMap moved(std::move(mm), &target);
+  EXPECT_EQ(moved.size(), 3u);
+  EXPECT_TRUE(mm.empty());
+  EXPECT_THAT(moved.view(1), ::testing::ElementsAre(1, 2));
+  EXPECT_EQ(moved.at(1).get_allocator().resource(), &target);
+}
+
+// Move assignment is noexcept only when it cannot allocate
+static_assert(std::is_nothrow_move_assignable_v<MultiMap<int, int>>);
+static_assert(std::is_nothrow_move_constructible_v<MultiMap<int, int>>);
+static_assert(!std::is_nothrow_move_assignable_v<PmrMultiMap>);
+static_assert(std::is_nothrow_move_assignable_v<
+              MultiMap<int, int, std::vector, std::map, CountingStats>>);
+
+// Test move assignment between maps on different resources copies into
+// the target's resource, and reports a full resource by throwing
+TEST(MultiMapAllocatorTest, MoveAssignAcrossResources) {
+  CountingResource source;
+  CountingResource target;
+  {
+    PmrMultiMap from({{1, 1}, {1, 2}, {2, 3}}, &source);
+    PmrMultiMap to(&target);
+    to = std::move(from);
+    EXPECT_EQ(to.size(), 3u);
+    EXPECT_TRUE(from.empty());
+    EXPECT_EQ(from.size(), 0u);
+    EXPECT_THAT(to.view(1), ::testing::ElementsAre(1, 2));
+    EXPECT_EQ(to.get_allocator().resource(), &target);
+    EXPECT_EQ(to.at(1).get_allocator().resource(), &target);
+    EXPECT_GT(target.allocations, 0u);
+  }
+  EXPECT_EQ(source.outstanding, 0u);
+  EXPECT_EQ(target.outstanding, 0u);
+
+  alignas(std::max_align_t) char buffer[64];
+  std::pmr::monotonic_buffer_resource bounded(
+      buffer, sizeof(buffer), std::pmr::null_memory_resource());
+  PmrMultiMap from(&source);
+  for (int i = 0; i < 100; ++i) {
+    from.emplace(i, i);
+  }
+  PmrMultiMap to(&bounded);
+  EXPECT_THROW(to = std::move(from), std::bad_alloc);
+  EXPECT_EQ(to.size(), size_t(std::distance(to.begin(), to.end())));
+  EXPECT_EQ(from.size(), size_t(std::distance(from.begin(), from.end())));
+}
+
+// Test the default allocator keeps working for std containers
+TEST(MultiMapAllocatorTest, StdAllocator) {
+  using Map = MultiMap<std::string, int>;
+  Map mm{Map::allocator_type()};
+  mm.emplace("a", 1);
+  EXPECT_EQ(mm.size(), 1u);
+  EXPECT_TRUE(mm.get_allocator() == Map::allocator_type());
+}
@@ -0,0 +1,70 @@
+#include "dictool/ParallelMultiMapBuilder.h"
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <memory>
+#include <set>
+#include <unordered_map>
+
+using namespace dictool;
+using ::testing::ElementsAre;
+
+// Test appends from a single worker come out grouped and in order
+TEST(ParallelMultiMapBuilderTest, SingleWorker) {
+  ParallelMultiMapBuilder<int, int> builder(1, 4);
+  EXPECT_EQ(builder.partition_count(), 4u);
+  auto &w = builder.worker(0);
+  for (int i = 0; i < 100; ++i) {
+    w.emplace(i % 10, i);
+  }
+  EXPECT_EQ(w.size(), 100u);
+
+  auto mm = builder.finish();
+  EXPECT_EQ(mm.size(), 100u);
+  EXPECT_EQ(mm.key_count(), 10u);
+  EXPECT_THAT(mm.view(3), ElementsAre(3, 13, 23, 33, 43, 53, 63, 73, 83, 93));
+  EXPECT_EQ(w.size(), 0u);
+  EXPECT_THROW(builder.worker(1), std::out_of_range);
+}
+
+// Test run() feeds every worker from its own thread
+TEST(ParallelMultiMapBuilderTest, Run) {
+  ParallelMultiMapBuilder<int, int, std::vector, std::unordered_map> builder(
+      4);
+  builder.run([](size_t i, auto &w) {
+    for (int k = 0; k < 1000; ++k) {
+      w.emplace(k, static_cast<int>(i));
+    }
+  });
+
+  auto mm = builder.finish(2);
+  EXPECT_EQ(mm.size(), 4000u);
+  EXPECT_EQ(mm.key_count(), 1000u);
+  // Values of a key follow worker order
+  EXPECT_THAT(mm.view(123), ElementsAre(0, 1, 2, 3));
+}
+
+// Test move-only values are moved through the reduction
+TEST(ParallelMultiMapBuilderTest, MoveOnlyValues) {
+  ParallelMultiMapBuilder<int, std::unique_ptr<int>> builder(2);
+  builder.worker(0).emplace(1, std::make_unique<int>(10));
+  builder.worker(1).emplace(1, std::make_unique<int>(11));
+  builder.worker(1).emplace(2, std::make_unique<int>(20));
+
+  auto mm = builder.finish();
+  ASSERT_EQ(mm.count(1), 2u);
+  EXPECT_EQ(*mm.view(1)[0], 10);
+  EXPECT_EQ(*mm.view(1)[1], 11);
+  EXPECT_EQ(*mm.view(2)[0], 20);
+}
+
+// Test set containers and range insert
+TEST(ParallelMultiMapBuilderTest, SetContainer) {
+  ParallelMultiMapBuilder<int, int, std::set> builder(3, 5);
+  std::vector<std::pair<int, int>> pairs{{1, 3}, {1, 1}, {2, 2}};
+  builder.worker(0).insert(pairs.begin(), pairs.end());
+  builder.worker(2).insert(pairs.begin(), pairs.end());
+
+  auto mm = builder.finish();
+  EXPECT_EQ(mm.size(), 3u);
+  EXPECT_THAT(mm.view(1), ElementsAre(1, 3));
+}
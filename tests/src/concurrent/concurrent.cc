@@ -0,0 +1,137 @@
+#include "dictool/ConcurrentMultiMap.h"
+#include "dictool/FlatHashMap.h"
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <memory_resource>
+#include <set>
+#include <string>
+#include <unordered_map>
+
+using namespace dictool;
+using ::testing::ElementsAre;
+using ::testing::UnorderedElementsAre;
+
+// Test single-threaded emplace, lookup and erase
+TEST(ConcurrentMultiMapTest, Basic) {
+  ConcurrentMultiMap<std::string, int> cmm(4);
+  EXPECT_EQ(cmm.shard_count(), 4u);
+  EXPECT_TRUE(cmm.empty());
+
+  cmm.emplace("a", 1);
+  cmm.emplace("a", 2);
+  cmm.insert({"b", 3});
+  EXPECT_EQ(cmm.size(), 3u);
+  EXPECT_EQ(cmm.key_count(), 2u);
+  EXPECT_EQ(cmm.count("a"), 2u);
+  EXPECT_TRUE(cmm.contains("b"));
+  EXPECT_THAT(cmm.find_copy("a"), ElementsAre(1, 2));
+  EXPECT_TRUE(cmm.find_copy("z").empty());
+
+  EXPECT_TRUE(cmm.erase("a", 1));
+  EXPECT_FALSE(cmm.erase("a", 1));
+  EXPECT_EQ(cmm.erase("b"), 1u);
+  EXPECT_EQ(cmm.size(), 1u);
+
+  cmm.clear();
+  EXPECT_TRUE(cmm.empty());
+}
+
+// Test visit runs on the live values and reports missing keys
+TEST(ConcurrentMultiMapTest, Visit) {
+  ConcurrentMultiMap<int, int> cmm;
+  cmm.emplace(1, 10);
+  cmm.emplace(1, 11);
+
+  int sum = 0;
+  EXPECT_TRUE(cmm.visit(1, [&](auto values) {
+    for (int v : values) {
+      sum += v;
+    }
+  }));
+  EXPECT_EQ(sum, 21);
+  EXPECT_FALSE(cmm.visit(2, [&](auto) { sum = 0; }));
+  EXPECT_EQ(sum, 21);
+}
+
+// Test range insert, merge and snapshot
+TEST(ConcurrentMultiMapTest, MergeSnapshot) {
+  ConcurrentMultiMap<int, int, std::vector, std::unordered_map> cmm(3);
+  std::vector<std::pair<int, int>> pairs{{1, 1}, {2, 2}, {1, 3}};
+  cmm.insert(pairs.begin(), pairs.end());
+
+  MultiMap<int, int, std::vector, std::unordered_map> other{{2, 4}, {5, 5}};
+  cmm.merge(std::move(other));
+  EXPECT_TRUE(other.empty());
+  cmm.merge(MultiMap<int, int, std::vector, std::unordered_map>{{7, 7}});
+
+  auto snap = cmm.snapshot();
+  EXPECT_EQ(snap.size(), 6u);
+  EXPECT_THAT(snap.keys(), UnorderedElementsAre(1, 2, 5, 7));
+  EXPECT_THAT(snap.view(1), ElementsAre(1, 3));
+  EXPECT_THAT(snap.view(2), ElementsAre(2, 4));
+}
+
+// Test a single shard behaves like a plain MultiMap
+TEST(ConcurrentMultiMapTest, OneShard) {
+  ConcurrentMultiMap<int, int, std::vector, flat_hash_map> cmm(0);
+  EXPECT_EQ(cmm.shard_count(), 1u);
+  for (int i = 0; i < 100; ++i) {
+    cmm.emplace(i % 10, i);
+  }
+  EXPECT_EQ(cmm.snapshot().size(), 100u);
+  EXPECT_EQ(cmm.count(3), 10u);
+}
+
+// Test counters() adds up the counts of every shard
+TEST(ConcurrentMultiMapTest, Counters) {
+  ConcurrentMultiMap<int, int, std::vector, std::map, std::hash<int>,
+                     CountingStats>
+      cmm(4);
+  for (int i = 0; i < 40; ++i) {
+    cmm.emplace(i, i);
+  }
+  EXPECT_TRUE(cmm.contains(3));
+  EXPECT_FALSE(cmm.contains(40));
+  cmm.erase(5);
+
+  auto counts = cmm.counters();
+  EXPECT_EQ(counts.inserts, 40u);
+  EXPECT_EQ(counts.erases, 1u);
+  EXPECT_EQ(counts.hits, 1u);
+  EXPECT_EQ(counts.misses, 1u);
+
+  ConcurrentMultiMap<int, int> plain;
+  plain.emplace(1, 1);
+  EXPECT_EQ(plain.counters().inserts, 0u);
+}
+
+// Test merge moves set-backed and pmr-backed maps in whole, one per key
+TEST(ConcurrentMultiMapTest, MergeContainers) {
+  ConcurrentMultiMap<int, int, std::set, std::map> sets(3);
+  sets.emplace(1, 5);
+  sets.emplace(2, 2);
+  MultiMap<int, int, std::set, std::map> set_source{
+      {1, 3}, {1, 5}, {2, 2}, {4, 1}};
+  sets.merge(std::move(set_source));
+  EXPECT_TRUE(set_source.empty());
+  EXPECT_EQ(set_source.key_count(), 0u);
+  EXPECT_EQ(sets.size(), 4u);
+  EXPECT_EQ(sets.key_count(), 3u);
+  EXPECT_THAT(sets.find_copy(1), ElementsAre(3, 5));
+  EXPECT_THAT(sets.find_copy(2), ElementsAre(2));
+  EXPECT_THAT(sets.find_copy(4), ElementsAre(1));
+
+  std::pmr::monotonic_buffer_resource arena;
+  ConcurrentMultiMap<int, int, std::pmr::vector, std::pmr::map> pmrs(4);
+  pmrs.emplace(7, 0);
+  MultiMap<int, int, std::pmr::vector, std::pmr::map> pmr_source(&arena);
+  for (int i = 0; i < 20; ++i) {
+    pmr_source.emplace(i % 8, i);
+  }
+  pmrs.merge(std::move(pmr_source));
+  EXPECT_TRUE(pmr_source.empty());
+  EXPECT_EQ(pmrs.size(), 21u);
+  EXPECT_EQ(pmrs.key_count(), 8u);
+  EXPECT_THAT(pmrs.find_copy(3), ElementsAre(3, 11, 19));
+  EXPECT_THAT(pmrs.find_copy(7), ElementsAre(0, 7, 15));
+}
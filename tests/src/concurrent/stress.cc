@@ -0,0 +1,91 @@
+#include "dictool/ConcurrentMultiMap.h"
+#include <atomic>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+using namespace dictool;
+
+// Writers, erasers, readers and snapshots running at once. Build with
+// -Ddictool_SANITIZER=thread to have ThreadSanitizer check the locking.
+TEST(ConcurrentMultiMapStressTest, MixedWorkload) {
+  constexpr int writers = 4;
+  constexpr int per_writer = 5000;
+  constexpr int keys = 257;
+
+  ConcurrentMultiMap<int, int> cmm(8);
+  std::atomic<bool> done{false};
+  std::atomic<long> erased{0};
+
+  std::vector<std::thread> threads;
+  for (int w = 0; w < writers; ++w) {
+    threads.emplace_back([&, w] {
+      for (int i = 0; i < per_writer; ++i) {
+        cmm.emplace((w * per_writer + i) % keys, w);
+      }
+    });
+  }
+  // Erase one value of writer 0 now and then
+  threads.emplace_back([&] {
+    for (int i = 0; i < 1000; ++i) {
+      erased += cmm.erase(i % keys, 0);
+    }
+  });
+  // Readers check every value they see belongs to a writer
+  std::atomic<bool> bad_value{false};
+  for (int r = 0; r < 2; ++r) {
+    threads.emplace_back([&, r] {
+      int key = r;
+      while (!done) {
+        cmm.visit(key, [&](auto values) {
+          for (int v : values) {
+            bad_value = bad_value || v < 0 || v >= writers;
+          }
+        });
+        bad_value = bad_value || cmm.find_copy(key).size() > per_writer;
+        key = (key + 1) % keys;
+      }
+    });
+  }
+  threads.emplace_back([&] {
+    while (!done) {
+      auto snap = cmm.snapshot();
+      bad_value = bad_value || snap.size() > writers * per_writer;
+    }
+  });
+
+  for (int i = 0; i < writers + 1; ++i) {
+    threads[i].join();
+  }
+  done = true;
+  for (size_t i = writers + 1; i < threads.size(); ++i) {
+    threads[i].join();
+  }
+
+  EXPECT_FALSE(bad_value);
+  EXPECT_EQ(cmm.size(), size_t(writers * per_writer - erased));
+  EXPECT_EQ(cmm.key_count(), size_t(keys));
+  EXPECT_EQ(cmm.snapshot().size(), cmm.size());
+}
+
+// Merging from several threads loses nothing
+TEST(ConcurrentMultiMapStressTest, ParallelMerge) {
+  ConcurrentMultiMap<int, int> cmm(4);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&, t] {
+      for (int round = 0; round < 20; ++round) {
+        MultiMap<int, int> part;
+        for (int i = 0; i < 100; ++i) {
+          part.emplace(i, t);
+        }
+        cmm.merge(std::move(part));
+      }
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  EXPECT_EQ(cmm.size(), 4u * 20 * 100);
+  EXPECT_EQ(cmm.count(42), 80u);
+}
@@ -0,0 +1,186 @@
+#include "dictool/Delimited.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <string>
+#include <unordered_map>
+
+using namespace dictool;
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+
+namespace {
+
+// Text file in the temp directory, removed at the end of the test
+struct TempFile {
+  std::string path;
+
+  TempFile(const std::string &name, const std::string &text)
+      : path((std::filesystem::temp_directory_path() /
+              ("dictool_" + name + ".tsv"))
+                 .string()) {
+    std::ofstream(path, std::ios::binary) << text;
+  }
+  ~TempFile() { std::remove(path.c_str()); }
+};
+
+// Message of the runtime_error thrown by f, or "" if none
+template <typename F> std::string error_of(F f) {
+  try {
+    f();
+  } catch (const std::runtime_error &e) {
+    return e.what();
+  }
+  return "";
+}
+
+// Key without a std::hash specialization, ordered for std::map
+struct Tag {
+  std::string name;
+  bool operator<(const Tag &other) const { return name < other.name; }
+};
+
+} // namespace
+
+namespace dictool {
+
+template <> struct FieldParser<Tag> {
+  static bool parse(std::string_view field, Tag &out) {
+    out.name.assign(field.data(), field.size());
+    return !field.empty();
+  }
+};
+
+} // namespace dictool
+
+// Test numeric fields, blank lines and a missing final newline
+TEST(DelimitedTest, Numbers) {
+  TempFile file("numbers", "1\t10\n2\t-20\n\n1\t+30\n3\t40");
+  MultiMap<int, long> mm;
+  EXPECT_EQ(load_delimited(file.path, mm), 4u);
+  EXPECT_THAT(mm.view(1), ElementsAre(10, 30));
+  EXPECT_THAT(mm.view(2), ElementsAre(-20));
+  EXPECT_THAT(mm.view(3), ElementsAre(40));
+}
+
+// Test string values keep everything after the first delimiter
+TEST(DelimitedTest, Strings) {
+  TempFile file("strings", "fruit,apple\r\nfruit,fig, dried\r\n\r\nveg,\r\n");
+  DelimitedOptions options;
+  options.delimiter = ',';
+  auto mm = load_delimited<MultiMap<std::string, std::string>>(file.path,
+                                                              options);
+  EXPECT_THAT(mm.view("fruit"), ElementsAre("apple", "fig, dried"));
+  EXPECT_THAT(mm.view("veg"), ElementsAre(""));
+}
+
+// Test floating-point values and small chunks
+TEST(DelimitedTest, ChunkedFloats) {
+  std::string text;
+  for (int i = 0; i < 100; ++i) {
+    text += std::to_string(i % 7) + "\t" + std::to_string(i) + ".5\n";
+  }
+  TempFile file("floats", text);
+  DelimitedOptions options;
+  options.chunk_size = 8;
+  MultiMap<int, double, std::vector, std::unordered_map> mm;
+  EXPECT_EQ(load_delimited(file.path, mm, options), 100u);
+  EXPECT_EQ(mm.size(), 100u);
+  EXPECT_THAT(mm.view(6), ElementsAre(6.5, 13.5, 20.5, 27.5, 34.5, 41.5,
+                                      48.5, 55.5, 62.5, 69.5, 76.5, 83.5,
+                                      90.5, 97.5));
+}
+
+// Test the parallel path yields the same map, in file order
+TEST(DelimitedTest, Parallel) {
+  std::string text;
+  for (int i = 0; i < 20000; ++i) {
+    text += std::to_string(i % 101) + "\t" + std::to_string(i) + "\n";
+  }
+  TempFile file("parallel", text);
+
+  auto serial = load_delimited<MultiMap<int, int>>(file.path);
+  DelimitedOptions options;
+  options.threads = 4;
+  options.min_parallel = 0;
+  MultiMap<int, int> parallel{{5, -1}};
+  EXPECT_EQ(load_delimited(file.path, parallel, options), 20000u);
+
+  EXPECT_EQ(parallel.size(), serial.size() + 1);
+  EXPECT_EQ(parallel.view(5)[0], -1);
+  for (int k = 0; k < 101; ++k) {
+    auto expected = serial.view(k);
+    auto got = parallel.view(k);
+    size_t skip = k == 5 ? 1 : 0;
+    ASSERT_EQ(got.size(), expected.size() + skip);
+    EXPECT_TRUE(std::equal(expected.begin(), expected.end(),
+                           got.begin() + skip));
+  }
+}
+
+// Test malformed input reports the line
+TEST(DelimitedTest, Errors) {
+  TempFile no_delim("no_delim", "1\t1\n2\n");
+  TempFile bad_value("bad_value", "1\t1\n\n2\t2x\n");
+  TempFile bad_key("bad_key", "k\t1\n");
+  TempFile double_sign("double_sign", "1\t+-5\n");
+  MultiMap<int, int> mm;
+
+  EXPECT_THAT(error_of([&] { load_delimited(no_delim.path, mm); }),
+              HasSubstr("missing delimiter on line 2"));
+  EXPECT_THAT(error_of([&] { load_delimited(bad_value.path, mm); }),
+              HasSubstr("bad value on line 3"));
+  EXPECT_THAT(error_of([&] { load_delimited(bad_key.path, mm); }),
+              HasSubstr("bad key on line 1"));
+  EXPECT_THAT(error_of([&] { load_delimited(double_sign.path, mm); }),
+              HasSubstr("bad value on line 1"));
+  EXPECT_THROW(load_delimited(no_delim.path + ".missing", mm),
+               std::runtime_error);
+
+  DelimitedOptions options;
+  options.threads = 3;
+  options.min_parallel = 0;
+  EXPECT_THAT(error_of([&] { load_delimited(bad_value.path, mm, options); }),
+              HasSubstr("line 3"));
+}
+
+// Test keys without std::hash load serially even when threads are asked
+TEST(DelimitedTest, UnhashableKey) {
+  TempFile file("unhashable", "b\t1\na\t2\nb\t3\n");
+  DelimitedOptions options;
+  options.threads = 4;
+  options.min_parallel = 0;
+  MultiMap<Tag, int> mm;
+  EXPECT_EQ(load_delimited(file.path, mm, options), 3u);
+  EXPECT_THAT(mm.view(Tag{"b"}), ElementsAre(1, 3));
+  EXPECT_THAT(mm.view(Tag{"a"}), ElementsAre(2));
+}
+
+// Test maps with a Stats policy load on both paths and count the inserts
+TEST(DelimitedTest, CountingStats) {
+  std::string text;
+  for (int i = 0; i < 1000; ++i) {
+    text += std::to_string(i % 13) + "\t" + std::to_string(i) + "\n";
+  }
+  TempFile file("counting", text);
+  using CountingMap =
+      MultiMap<int, int, std::vector, std::map, CountingStats>;
+
+  auto serial = load_delimited<CountingMap>(file.path);
+  EXPECT_EQ(serial.counters().inserts, 1000u);
+
+  DelimitedOptions options;
+  options.threads = 3;
+  options.min_parallel = 0;
+  CountingMap parallel;
+  EXPECT_EQ(load_delimited(file.path, parallel, options), 1000u);
+  EXPECT_EQ(parallel.counters().inserts, 1000u);
+  for (int k = 0; k < 13; ++k) {
+    auto expected = serial.view(k);
+    auto got = parallel.view(k);
+    EXPECT_TRUE(
+        std::equal(expected.begin(), expected.end(), got.begin(), got.end()));
+  }
+}
@@ -0,0 +1,67 @@
+#include "dictool/FlatHashMap.h"
+#include "dictool/MultiDict.h"
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <string>
+
+using namespace dictool;
+using ::testing::ElementsAre;
+using ::testing::UnorderedElementsAre;
+
+template <typename K, typename V>
+using FlatMultiMap = MultiMap<K, V, std::vector, flat_hash_map>;
+
+// Test flat_hash_map as the dictionary of a MultiMap
+TEST(FlatHashMultiMapTest, Basic) {
+  FlatMultiMap<std::string, int> mm;
+  for (int i = 0; i < 1000; ++i) {
+    mm.emplace(std::to_string(i % 100), i);
+  }
+  EXPECT_EQ(mm.size(), 1000u);
+  EXPECT_EQ(mm.key_count(), 100u);
+  EXPECT_EQ(mm.count("7"), 10u);
+  EXPECT_TRUE(mm.contains("99"));
+  EXPECT_THAT(mm.view("0"), ElementsAre(0, 100, 200, 300, 400, 500, 600, 700,
+                                        800, 900));
+
+  size_t visited = 0;
+  for (const auto &[key, value] : mm) {
+    EXPECT_EQ(std::to_string(value % 100), key);
+    ++visited;
+  }
+  EXPECT_EQ(visited, 1000u);
+}
+
+// Test erase paths of a flat_hash_map backed MultiMap
+TEST(FlatHashMultiMapTest, Erase) {
+  FlatMultiMap<int, int> mm{{1, 10}, {1, 11}, {2, 20}, {3, 30}};
+  EXPECT_EQ(mm.erase(2), 1u);
+  mm.erase(mm.find(3));
+  EXPECT_FALSE(mm.contains(3));
+  EXPECT_EQ(mm.size(), 2u);
+
+  EXPECT_EQ(mm.erase_if([](int, int v) { return v == 10; }), 1u);
+  EXPECT_THAT(mm.view(1), ElementsAre(11));
+
+  mm.erase(mm.cbegin());
+  EXPECT_TRUE(mm.empty());
+  EXPECT_EQ(mm.key_count(), 0u);
+}
+
+// Test bulk loading and merging with flat_hash_map dictionaries
+TEST(FlatHashMultiMapTest, BulkLoadMerge) {
+  auto a = FlatMultiMap<int, int>::from_unsorted(
+      {{3, 1}, {1, 1}, {3, 2}, {2, 1}, {1, 2}});
+  EXPECT_EQ(a.size(), 5u);
+  EXPECT_THAT(a.view(3), ElementsAre(1, 2));
+
+  FlatMultiMap<int, int> b{{3, 3}, {4, 1}};
+  a.merge(std::move(b));
+  EXPECT_TRUE(b.empty());
+  EXPECT_EQ(a.size(), 7u);
+  EXPECT_THAT(a.view(3), ElementsAre(1, 2, 3));
+  EXPECT_THAT(a.keys(), UnorderedElementsAre(1, 2, 3, 4));
+
+  a.reserve(100);
+  EXPECT_EQ(a.size(), 7u);
+}
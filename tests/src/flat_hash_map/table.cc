@@ -0,0 +1,215 @@
+#include "dictool/FlatHashMap.h"
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+using namespace dictool;
+using ::testing::UnorderedElementsAre;
+
+// Test insertion and lookup
+TEST(FlatHashMapTest, InsertFind) {
+  flat_hash_map<int, std::string> m;
+  EXPECT_TRUE(m.empty());
+  EXPECT_EQ(m.find(1), m.end());
+
+  auto [it, inserted] = m.try_emplace(1, "one");
+  EXPECT_TRUE(inserted);
+  EXPECT_EQ(it->second, "one");
+  EXPECT_FALSE(m.try_emplace(1, "uno").second);
+  EXPECT_EQ(m.at(1), "one");
+
+  m[2] = "two";
+  m.insert({3, "three"});
+  EXPECT_EQ(m.size(), 3u);
+  EXPECT_TRUE(m.contains(2));
+  EXPECT_EQ(m.count(3), 1u);
+  EXPECT_EQ(m.count(4), 0u);
+  EXPECT_THROW(m.at(4), std::out_of_range);
+}
+
+// Test growth keeps every element reachable
+TEST(FlatHashMapTest, Growth) {
+  flat_hash_map<int, int> m;
+  for (int i = 0; i < 10000; ++i) {
+    m[i] = i * 2;
+  }
+  EXPECT_EQ(m.size(), 10000u);
+  EXPECT_LE(m.load_factor(), m.max_load_factor());
+  for (int i = 0; i < 10000; ++i) {
+    ASSERT_EQ(m.at(i), i * 2);
+  }
+
+  size_t visited = 0;
+  for (const auto &[key, value] : m) {
+    EXPECT_EQ(value, key * 2);
+    ++visited;
+  }
+  EXPECT_EQ(visited, 10000u);
+}
+
+// Test erase by key, iterator and range
+TEST(FlatHashMapTest, Erase) {
+  flat_hash_map<int, int> m{{1, 10}, {2, 20}, {3, 30}, {4, 40}};
+  EXPECT_EQ(m.erase(2), 1u);
+  EXPECT_EQ(m.erase(2), 0u);
+
+  auto it = m.erase(m.find(3));
+  EXPECT_EQ(m.size(), 2u);
+  EXPECT_FALSE(m.contains(3));
+  if (it != m.end()) {
+    EXPECT_TRUE(it->first == 1 || it->first == 4);
+  }
+
+  m.erase(m.cbegin(), m.cend());
+  EXPECT_TRUE(m.empty());
+  EXPECT_EQ(m.begin(), m.end());
+}
+
+// Test random inserts and erases against std::unordered_map
+TEST(FlatHashMapTest, MatchesUnorderedMap) {
+  flat_hash_map<int, int> m;
+  std::unordered_map<int, int> expected;
+  std::mt19937 rng(7);
+  for (int i = 0; i < 100000; ++i) {
+    int key = static_cast<int>(rng() % 3000);
+    if (rng() % 3 != 0) {
+      m[key] += i;
+      expected[key] += i;
+    } else {
+      ASSERT_EQ(m.erase(key), expected.erase(key));
+    }
+    ASSERT_EQ(m.size(), expected.size());
+  }
+  for (const auto &[key, value] : expected) {
+    ASSERT_EQ(m.at(key), value);
+  }
+}
+
+// Test reserve avoids rehashing and clear keeps capacity
+TEST(FlatHashMapTest, ReserveClear) {
+  flat_hash_map<int, int> m;
+  m.reserve(1000);
+  size_t buckets = m.bucket_count();
+  for (int i = 0; i < 1000; ++i) {
+    m[i] = i;
+  }
+  EXPECT_EQ(m.bucket_count(), buckets);
+
+  m.clear();
+  EXPECT_TRUE(m.empty());
+  EXPECT_EQ(m.bucket_count(), buckets);
+  m[5] = 5;
+  EXPECT_EQ(m.size(), 1u);
+
+  m.rehash(0);
+  EXPECT_LT(m.bucket_count(), buckets);
+  EXPECT_EQ(m.at(5), 5);
+}
+
+// Test copy, move, swap and equality
+TEST(FlatHashMapTest, CopyMove) {
+  flat_hash_map<std::string, int> a{{"x", 1}, {"y", 2}};
+  flat_hash_map<std::string, int> b = a;
+  EXPECT_EQ(a, b);
+
+  b["z"] = 3;
+  EXPECT_NE(a, b);
+
+  flat_hash_map<std::string, int> c = std::move(b);
+  EXPECT_TRUE(b.empty());
+  EXPECT_EQ(c.size(), 3u);
+
+  swap(a, c);
+  EXPECT_EQ(a.size(), 3u);
+  EXPECT_EQ(c.size(), 2u);
+
+  a = c;
+  EXPECT_EQ(a, c);
+}
+
+// A value counting its live instances, whose copies throw on demand
+struct Fragile {
+  static inline int live = 0;
+  static inline int copies_left = -1;
+
+  Fragile() { ++live; }
+  Fragile(const Fragile &) {
+    if (copies_left == 0) {
+      throw std::runtime_error("copy");
+    }
+    --copies_left;
+    ++live;
+  }
+  ~Fragile() { --live; }
+};
+
+// Test a copy that throws partway destroys what it built
+TEST(FlatHashMapTest, CopyThrows) {
+  {
+    flat_hash_map<int, Fragile> m;
+    for (int i = 0; i < 50; ++i) {
+      m.try_emplace(i);
+    }
+    Fragile::copies_left = 20;
+    using Map = flat_hash_map<int, Fragile>;
+    EXPECT_THROW(Map copy(m), std::runtime_error);
+    Fragile::copies_left = -1;
+    EXPECT_EQ(Fragile::live, 50);
+  }
+  EXPECT_EQ(Fragile::live, 0);
+}
+
+// Test move-only mapped values
+TEST(FlatHashMapTest, MoveOnlyValues) {
+  flat_hash_map<int, std::unique_ptr<int>> m;
+  for (int i = 0; i < 100; ++i) {
+    m.try_emplace(i, std::make_unique<int>(i));
+  }
+  EXPECT_EQ(*m.at(42), 42);
+}
+
+// Test merge moves absent keys only
+TEST(FlatHashMapTest, Merge) {
+  flat_hash_map<int, int> a{{1, 10}, {2, 20}};
+  flat_hash_map<int, int> b{{2, 200}, {3, 300}};
+  a.merge(b);
+
+  EXPECT_EQ(a.size(), 3u);
+  EXPECT_EQ(a.at(2), 20);
+  EXPECT_EQ(a.at(3), 300);
+  EXPECT_EQ(b.size(), 1u);
+  EXPECT_EQ(b.at(2), 200);
+}
+
+struct StringHash {
+  using is_transparent = void;
+  size_t operator()(std::string_view s) const {
+    return std::hash<std::string_view>()(s);
+  }
+};
+
+// Test heterogeneous lookup with a transparent hasher
+TEST(FlatHashMapTest, TransparentLookup) {
+  flat_hash_map<std::string, int, StringHash, std::equal_to<>> m{{"key", 1}};
+  std::string_view key = "key";
+  EXPECT_NE(m.find(key), m.end());
+  EXPECT_TRUE(m.contains(key));
+  EXPECT_EQ(m.erase(key), 1u);
+  EXPECT_TRUE(m.empty());
+}
+
+// Test iteration yields each element once
+TEST(FlatHashMapTest, Iteration) {
+  flat_hash_map<int, char> m{{1, 'a'}, {2, 'b'}, {3, 'c'}};
+  std::vector<char> values;
+  for (auto it = m.cbegin(); it != m.cend(); ++it) {
+    values.push_back(it->second);
+  }
+  EXPECT_THAT(values, UnorderedElementsAre('a', 'b', 'c'));
+  EXPECT_EQ(std::distance(m.begin(), m.end()), 3);
+}
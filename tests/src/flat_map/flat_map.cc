@@ -0,0 +1,123 @@
+#include "dictool/FlatMap.h"
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <map>
+#include <random>
+#include <string>
+#include <string_view>
+
+using namespace dictool;
+using ::testing::ElementsAre;
+using ::testing::Pair;
+
+// Test insertion and lookup
+TEST(FlatMapTest, InsertFind) {
+  flat_map<int, std::string> m;
+  EXPECT_TRUE(m.empty());
+  EXPECT_EQ(m.find(1), m.end());
+
+  auto [it, inserted] = m.try_emplace(2, "two");
+  EXPECT_TRUE(inserted);
+  EXPECT_EQ(it->second, "two");
+  EXPECT_FALSE(m.try_emplace(2, "deux").second);
+
+  m[1] = "one";
+  m.insert({3, "three"});
+  EXPECT_EQ(m.size(), 3u);
+  EXPECT_TRUE(m.contains(1));
+  EXPECT_EQ(m.count(4), 0u);
+  EXPECT_EQ(m.at(3), "three");
+  EXPECT_THROW(m.at(4), std::out_of_range);
+  EXPECT_EQ(m.find(1)->second, "one");
+}
+
+// Test iteration is sorted while keys wait in the tail
+TEST(FlatMapTest, SortedIterationWithTail) {
+  flat_map<int, int> m;
+  for (int k : {10, 20, 30, 40}) {
+    m.try_emplace(k, k);
+  }
+  EXPECT_EQ(m.pending(), 0u);
+  for (int k : {25, 5, 35}) {
+    m.try_emplace(k, k);
+  }
+  EXPECT_EQ(m.pending(), 3u);
+
+  std::vector<int> keys;
+  for (const auto &[key, value] : m) {
+    keys.push_back(key);
+  }
+  EXPECT_THAT(keys, ElementsAre(5, 10, 20, 25, 30, 35, 40));
+  EXPECT_EQ(m.find(25)->second, 25);
+
+  m.flush();
+  EXPECT_EQ(m.pending(), 0u);
+  EXPECT_THAT(m, ElementsAre(Pair(5, 5), Pair(10, 10), Pair(20, 20),
+                             Pair(25, 25), Pair(30, 30), Pair(35, 35),
+                             Pair(40, 40)));
+}
+
+// Test erase by key, iterator and range across both runs
+TEST(FlatMapTest, Erase) {
+  flat_map<int, int> m{{1, 1}, {3, 3}, {5, 5}};
+  m.try_emplace(2, 2);
+  m.try_emplace(4, 4);
+
+  auto next = m.erase(m.find(2));
+  EXPECT_EQ(next->first, 3);
+  next = m.erase(m.find(3));
+  EXPECT_EQ(next->first, 4);
+  EXPECT_EQ(m.erase(5), 1u);
+  EXPECT_EQ(m.erase(5), 0u);
+  EXPECT_THAT(m, ElementsAre(Pair(1, 1), Pair(4, 4)));
+
+  m.erase(m.cbegin(), m.cend());
+  EXPECT_TRUE(m.empty());
+}
+
+// Test random operations against std::map
+TEST(FlatMapTest, MatchesStdMap) {
+  flat_map<int, int> m;
+  std::map<int, int> expected;
+  std::mt19937 rng(11);
+  for (int i = 0; i < 20000; ++i) {
+    int key = static_cast<int>(rng() % 2000);
+    if (rng() % 3 != 0) {
+      ASSERT_EQ(m.try_emplace(key, i).second,
+                expected.try_emplace(key, i).second);
+    } else {
+      ASSERT_EQ(m.erase(key), expected.erase(key));
+    }
+  }
+  ASSERT_EQ(m.size(), expected.size());
+  EXPECT_TRUE(std::equal(m.begin(), m.end(), expected.begin(),
+                         [](const auto &a, const auto &b) {
+                           return a.first == b.first && a.second == b.second;
+                         }));
+}
+
+// Test merge moves absent keys only
+TEST(FlatMapTest, Merge) {
+  flat_map<int, int> a{{1, 10}, {3, 30}};
+  flat_map<int, int> b{{2, 20}, {3, 300}};
+  a.merge(b);
+  EXPECT_THAT(a, ElementsAre(Pair(1, 10), Pair(2, 20), Pair(3, 30)));
+  EXPECT_THAT(b, ElementsAre(Pair(3, 300)));
+}
+
+// Test construction from unsorted pairs keeps the first of each key
+TEST(FlatMapTest, RangeConstructor) {
+  std::vector<std::pair<int, char>> pairs{{3, 'a'}, {1, 'b'}, {3, 'c'}};
+  flat_map<int, char> m(pairs.begin(), pairs.end());
+  EXPECT_THAT(m, ElementsAre(Pair(1, 'b'), Pair(3, 'a')));
+}
+
+// Test heterogeneous lookup with a transparent comparator
+TEST(FlatMapTest, TransparentLookup) {
+  flat_map<std::string, int, std::less<>> m{{"alpha", 1}, {"beta", 2}};
+  std::string_view key = "beta";
+  EXPECT_NE(m.find(key), m.end());
+  EXPECT_TRUE(m.contains(key));
+  EXPECT_EQ(m.erase(key), 1u);
+  EXPECT_EQ(m.size(), 1u);
+}
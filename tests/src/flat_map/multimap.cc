@@ -0,0 +1,73 @@
+#include "dictool/FlatMap.h"
+#include "dictool/MultiDict.h"
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <string>
+
+using namespace dictool;
+using ::testing::ElementsAre;
+
+template <typename K, typename V>
+using FlatMultiMap = MultiMap<K, V, std::vector, flat_map>;
+
+// Test flat_map as the dictionary of a MultiMap
+TEST(FlatMapMultiMapTest, Basic) {
+  FlatMultiMap<int, int> mm;
+  for (int i = 0; i < 300; ++i) {
+    mm.emplace((i * 37) % 100, i);
+  }
+  EXPECT_EQ(mm.size(), 300u);
+  EXPECT_EQ(mm.key_count(), 100u);
+  EXPECT_EQ(mm.count(0), 3u);
+
+  std::vector<int> keys = mm.keys();
+  EXPECT_TRUE(std::is_sorted(keys.begin(), keys.end()));
+  EXPECT_EQ(keys.size(), 100u);
+}
+
+// Test bulk loading appends keys in order
+TEST(FlatMapMultiMapTest, BulkLoad) {
+  auto mm = FlatMultiMap<std::string, int>::from_unsorted(
+      {{"b", 1}, {"a", 2}, {"b", 3}, {"c", 4}});
+  EXPECT_EQ(mm.cdata().pending(), 0u);
+  EXPECT_THAT(mm.view("b"), ElementsAre(1, 3));
+  EXPECT_THAT(mm.keys(), ElementsAre("a", "b", "c"));
+}
+
+// Test erase and merge on flat_map dictionaries
+TEST(FlatMapMultiMapTest, EraseMerge) {
+  FlatMultiMap<int, int> mm{{1, 1}, {2, 2}, {2, 3}, {3, 4}};
+  mm.erase(mm.cbegin());
+  EXPECT_FALSE(mm.contains(1));
+  EXPECT_EQ(mm.erase_if([](int, int v) { return v == 3; }), 1u);
+
+  mm.merge(FlatMultiMap<int, int>{{0, 5}, {2, 6}});
+  EXPECT_THAT(mm.keys(), ElementsAre(0, 2, 3));
+  EXPECT_THAT(mm.view(2), ElementsAre(2, 6));
+  EXPECT_EQ(mm.size(), 4u);
+}
+
+// Test range erase, which shifts the nodes behind each erased key
+TEST(FlatMapMultiMapTest, EraseRange) {
+  FlatMultiMap<int, int> mm{{1, 1}, {2, 2}, {3, 3}, {4, 4}};
+  auto it = mm.erase(mm.find(1), mm.find(3));
+  EXPECT_THAT(mm.keys(), ElementsAre(3, 4));
+  EXPECT_EQ(mm.size(), 2u);
+  ASSERT_NE(it, mm.end());
+  EXPECT_EQ((*it).first, 3);
+
+  // Ending inside a key keeps the rest of its values
+  FlatMultiMap<int, int> split{{1, 1}, {1, 2}, {2, 3}, {2, 4}, {3, 5}};
+  auto last = std::next(split.cbegin(), 3);
+  it = split.erase(std::next(split.cbegin()), last);
+  EXPECT_THAT(split.keys(), ElementsAre(1, 2, 3));
+  EXPECT_THAT(split.view(1), ElementsAre(1));
+  EXPECT_THAT(split.view(2), ElementsAre(4));
+  EXPECT_EQ(split.size(), 3u);
+  EXPECT_EQ((*it).second, 4);
+
+  it = split.erase(split.cbegin(), split.cend());
+  EXPECT_EQ(it, split.end());
+  EXPECT_TRUE(split.empty());
+  EXPECT_EQ(split.size(), 0u);
+}
@@ -0,0 +1,127 @@
+#include "dictool/FrozenMultiMap.h"
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+using namespace dictool;
+using ::testing::ElementsAre;
+
+// Test freezing an ordered MultiMap keeps keys sorted and values grouped
+TEST(FrozenMultiMapTest, FromOrderedMultiMap) {
+  MultiMap<int, int> mm{{2, 30}, {1, 10}, {1, 20}, {3, 40}};
+  FrozenMultiMap<int, int> fm(mm);
+
+  EXPECT_EQ(fm.size(), 4u);
+  EXPECT_EQ(fm.key_count(), 3u);
+  EXPECT_THAT(fm.keys(), ElementsAre(1, 2, 3));
+  EXPECT_THAT(fm.offsets(), ElementsAre(0, 2, 3, 4));
+  EXPECT_THAT(fm.values(), ElementsAre(10, 20, 30, 40));
+}
+
+// Test freezing a hashed MultiMap sorts its keys
+TEST(FrozenMultiMapTest, FromUnorderedMultiMap) {
+  MultiMap<int, int, std::vector, std::unordered_map> mm;
+  for (int k = 50; k > 0; --k) {
+    mm.emplace(k, k * 10);
+    mm.emplace(k, k * 10 + 1);
+  }
+  FrozenMultiMap<int, int> fm(mm);
+
+  ASSERT_EQ(fm.key_count(), 50u);
+  EXPECT_TRUE(std::is_sorted(fm.keys().begin(), fm.keys().end()));
+  EXPECT_THAT(fm.view(7), ElementsAre(70, 71));
+  EXPECT_EQ(fm.size(), 100u);
+}
+
+// Test freezing a set-backed MultiMap and skipping emptied keys
+TEST(FrozenMultiMapTest, FromSetMultiMap) {
+  MultiMap<int, int, std::set> mm{{1, 3}, {1, 1}, {2, 5}};
+  mm[3];
+  FrozenMultiMap<int, int> fm(mm);
+
+  EXPECT_THAT(fm.keys(), ElementsAre(1, 2));
+  EXPECT_THAT(fm.view(1), ElementsAre(1, 3));
+  EXPECT_FALSE(fm.contains(3));
+}
+
+// Test lookup methods
+TEST(FrozenMultiMapTest, Lookup) {
+  MultiMap<int, int> mm{{1, 10}, {1, 20}, {2, 30}};
+  FrozenMultiMap<int, int> fm(mm);
+
+  EXPECT_EQ(fm.count(1), 2u);
+  EXPECT_EQ(fm.count(4), 0u);
+  EXPECT_TRUE(fm.contains(2));
+  EXPECT_FALSE(fm.contains(0));
+
+  auto it = fm.find(2);
+  ASSERT_NE(it, fm.end());
+  EXPECT_EQ(it.key(), 2);
+  EXPECT_EQ(it.value(), 30);
+  EXPECT_EQ(fm.find(5), fm.end());
+
+  auto [first, last] = fm.equal_range(1);
+  std::vector<int> values;
+  for (; first != last; ++first) {
+    values.push_back((*first).second);
+  }
+  EXPECT_THAT(values, ElementsAre(10, 20));
+
+  auto [none_first, none_last] = fm.equal_range(9);
+  EXPECT_EQ(none_first, none_last);
+  EXPECT_TRUE(fm.view(9).empty());
+}
+
+// Test heterogeneous lookup with a transparent comparator
+TEST(FrozenMultiMapTest, TransparentLookup) {
+  MultiMap<std::string, int> mm{{"alpha", 1}, {"beta", 2}, {"beta", 3}};
+  FrozenMultiMap<std::string, int, std::less<>> fm(mm);
+
+  std::string_view key = "beta";
+  EXPECT_EQ(fm.count(key), 2u);
+  EXPECT_TRUE(fm.contains(key));
+  EXPECT_THAT(fm.view(key), ElementsAre(2, 3));
+  EXPECT_EQ(fm.find(key).value(), 2);
+}
+
+// Test flat iteration and group iteration
+TEST(FrozenMultiMapTest, Iteration) {
+  MultiMap<int, char> mm{{1, 'a'}, {1, 'b'}, {2, 'c'}};
+  FrozenMultiMap<int, char> fm(mm);
+
+  std::vector<std::pair<int, char>> pairs;
+  for (const auto &[key, value] : fm) {
+    pairs.emplace_back(key, value);
+  }
+  EXPECT_THAT(pairs, ElementsAre(std::pair(1, 'a'), std::pair(1, 'b'),
+                                 std::pair(2, 'c')));
+  EXPECT_EQ(std::distance(fm.begin(), fm.end()), 3);
+
+  std::vector<size_t> sizes;
+  for (const auto &[key, values] : fm.groups()) {
+    sizes.push_back(values.size());
+  }
+  EXPECT_THAT(sizes, ElementsAre(2, 1));
+
+  int groups = 0;
+  fm.for_each_group([&](int, FrozenMultiMap<int, char>::view_type values) {
+    groups += static_cast<int>(values.size());
+  });
+  EXPECT_EQ(groups, 3);
+}
+
+// Test an empty frozen multimap
+TEST(FrozenMultiMapTest, Empty) {
+  FrozenMultiMap<int, int> fm;
+  EXPECT_TRUE(fm.empty());
+  EXPECT_EQ(fm.begin(), fm.end());
+  EXPECT_EQ(fm.groups().size(), 0u);
+  EXPECT_FALSE(fm.contains(1));
+
+  FrozenMultiMap<int, int> from_empty{MultiMap<int, int>()};
+  EXPECT_TRUE(from_empty.empty());
+  EXPECT_THAT(from_empty.offsets(), ElementsAre(0));
+}
@@ -0,0 +1,321 @@
+#include "dictool/Journal.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <string>
+#include <unordered_map>
+
+using namespace dictool;
+using ::testing::ElementsAre;
+
+namespace {
+
+// Journal path prefix in the temp directory; its files are removed at the
+// start and end of the test
+struct TempJournal {
+  std::string path;
+
+  explicit TempJournal(const std::string &name)
+      : path((std::filesystem::temp_directory_path() / ("dictool_" + name))
+                 .string()) {
+    remove_all();
+  }
+  ~TempJournal() { remove_all(); }
+
+  std::string log() const { return path + ".log"; }
+  std::string snap() const { return path + ".snap"; }
+
+  void remove_all() const {
+    for (const char *suffix : {".log", ".snap", ".log.tmp", ".snap.tmp"}) {
+      std::remove((path + suffix).c_str());
+    }
+  }
+};
+
+// Overwrite one byte of a file
+void poke(const std::string &path, long offset, char byte) {
+  std::fstream f(path, std::ios::in | std::ios::out | std::ios::binary);
+  f.seekp(offset);
+  f.put(byte);
+}
+
+} // namespace
+
+// Test every operation is replayed in order on reopen
+TEST(JournalTest, ReopenReplays) {
+  TempJournal file("reopen");
+  {
+    JournaledMultiMap<int, int> jm(file.path);
+    jm.emplace(1, 10);
+    jm.emplace(2, 20);
+    jm.emplace(1, 11);
+    jm.emplace(1, 12);
+    EXPECT_TRUE(jm.erase(1, 11));
+    EXPECT_FALSE(jm.erase(1, 99));
+    jm.emplace(3, 30);
+    EXPECT_EQ(jm.erase(2), 1u);
+    jm.emplace(2, 21);
+  }
+
+  JournaledMultiMap<int, int> jm(file.path);
+  EXPECT_EQ(jm.size(), 4u);
+  EXPECT_THAT(jm.view(1), ElementsAre(10, 12));
+  EXPECT_THAT(jm.view(2), ElementsAre(21));
+  EXPECT_THAT(jm.view(3), ElementsAre(30));
+  EXPECT_EQ(jm.recovery().records, 8u); // the failed erase is not logged
+  EXPECT_FALSE(jm.recovery().torn);
+
+  jm.clear();
+  jm.emplace(4, 40);
+  jm.commit();
+  auto replayed = replay<MultiMap<int, int>>(file.log());
+  EXPECT_EQ(replayed.size(), 1u);
+  EXPECT_THAT(replayed.view(4), ElementsAre(40));
+}
+
+// Test std::string keys and values with a hashed dictionary
+TEST(JournalTest, Strings) {
+  TempJournal file("strings");
+  using Map = JournaledMultiMap<std::string, std::string, std::vector,
+                                std::unordered_map>;
+  {
+    Map jm(file.path);
+    jm.emplace("fruit", "apple");
+    jm.emplace("veg", "leek");
+    jm.emplace("fruit", "");
+    jm.emplace("", "empty");
+    jm.erase("veg", "leek");
+  }
+  Map jm(file.path);
+  EXPECT_THAT(jm.view("fruit"), ElementsAre("apple", ""));
+  EXPECT_THAT(jm.view(""), ElementsAre("empty"));
+  EXPECT_EQ(jm.count("veg"), 0u);
+}
+
+// Test records are batched until commit() or the group size is reached
+TEST(JournalTest, GroupCommit) {
+  TempJournal file("group");
+  JournalOptions options;
+  options.group_bytes = 1000;
+  JournaledMultiMap<int, int> jm(file.path, options);
+  uint64_t header = jm.log_bytes();
+  EXPECT_EQ(std::filesystem::file_size(file.log()), header);
+
+  jm.emplace(1, 1);
+  EXPECT_GT(jm.pending_bytes(), 0u);
+  EXPECT_EQ(std::filesystem::file_size(file.log()), header);
+  jm.commit();
+  EXPECT_EQ(jm.pending_bytes(), 0u);
+  EXPECT_GT(std::filesystem::file_size(file.log()), header);
+
+  // Each record is 17 bytes: the group is written in one go at 1000
+  for (int i = 0; i < 100; ++i) {
+    jm.emplace(i, i);
+  }
+  EXPECT_LT(jm.pending_bytes(), 1000u);
+  EXPECT_GT(jm.log_bytes(), header + 1000);
+  EXPECT_EQ(std::filesystem::file_size(file.log()), jm.log_bytes());
+
+  // The pending batch is lost without commit or a clean close
+  auto pending = replay<MultiMap<int, int>>(file.log());
+  EXPECT_LT(pending.size(), jm.size());
+}
+
+// Test a log cut at any byte replays its complete records only, and that
+// reopening drops the torn tail so new records are readable
+TEST(JournalTest, TruncatedTail) {
+  TempJournal file("truncated");
+  {
+    JournaledMultiMap<int, std::string> jm(file.path);
+    for (int i = 0; i < 5; ++i) {
+      jm.emplace(i, std::string(static_cast<size_t>(i), 'x'));
+    }
+  }
+  auto full = std::filesystem::file_size(file.log());
+  std::string bytes;
+  {
+    std::ifstream in(file.log(), std::ios::binary);
+    bytes.assign(std::istreambuf_iterator<char>(in), {});
+  }
+
+  size_t last_records = 5;
+  for (size_t cut = full + 1; cut-- > 0;) {
+    {
+      std::ofstream out(file.log(), std::ios::binary | std::ios::trunc);
+      out.write(bytes.data(), static_cast<std::streamsize>(cut));
+    }
+    MultiMap<int, std::string> mm;
+    auto result = replay(file.log(), mm);
+    EXPECT_EQ(result.records, mm.size());
+    EXPECT_LE(result.valid_bytes, cut);
+    EXPECT_EQ(result.torn, result.valid_bytes != cut);
+    EXPECT_LE(mm.size(), last_records);
+    last_records = mm.size();
+  }
+  EXPECT_EQ(last_records, 0u);
+
+  // Cut in the middle of the last record, then reopen and append
+  {
+    std::ofstream out(file.log(), std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), static_cast<std::streamsize>(full - 2));
+  }
+  {
+    JournaledMultiMap<int, std::string> jm(file.path);
+    EXPECT_TRUE(jm.recovery().torn);
+    EXPECT_EQ(jm.size(), 4u);
+    EXPECT_FALSE(jm.contains(4));
+    jm.emplace(7, "seven");
+  }
+  JournaledMultiMap<int, std::string> jm(file.path);
+  EXPECT_FALSE(jm.recovery().torn);
+  EXPECT_EQ(jm.size(), 5u);
+  EXPECT_THAT(jm.view(7), ElementsAre("seven"));
+}
+
+// Test a corrupt record stops replay there, even if later records are
+// intact
+TEST(JournalTest, CorruptTail) {
+  TempJournal file("corrupt");
+  uint64_t second_record = 0;
+  {
+    JournaledMultiMap<int, int> jm(file.path);
+    jm.emplace(1, 1);
+    jm.commit();
+    second_record = jm.log_bytes();
+    jm.emplace(2, 2);
+    jm.emplace(3, 3);
+  }
+
+  // Flip a payload byte of the second record
+  poke(file.log(), static_cast<long>(second_record) + 10, 0x55);
+  MultiMap<int, int> mm;
+  auto result = replay(file.log(), mm);
+  EXPECT_TRUE(result.torn);
+  EXPECT_EQ(result.records, 1u);
+  EXPECT_EQ(result.valid_bytes, second_record);
+  EXPECT_THAT(mm.view(1), ElementsAre(1));
+  EXPECT_FALSE(mm.contains(3));
+
+  JournaledMultiMap<int, int> jm(file.path);
+  EXPECT_EQ(jm.log_bytes(), second_record);
+  EXPECT_EQ(std::filesystem::file_size(file.log()), second_record);
+}
+
+// Test compaction folds the log into a snapshot that reopening loads
+TEST(JournalTest, Compact) {
+  TempJournal file("compact");
+  {
+    JournaledMultiMap<int, int> jm(file.path);
+    for (int i = 0; i < 100; ++i) {
+      jm.emplace(i % 10, i);
+    }
+    jm.erase(3);
+    uint64_t before = jm.log_bytes() + jm.pending_bytes();
+    jm.compact();
+    EXPECT_LT(jm.log_bytes(), before);
+    EXPECT_TRUE(std::filesystem::exists(file.snap()));
+    jm.emplace(3, 300);
+  }
+
+  JournaledMultiMap<int, int> jm(file.path);
+  EXPECT_EQ(jm.size(), 91u);
+  EXPECT_EQ(jm.recovery().records, 1u);
+  EXPECT_THAT(jm.view(3), ElementsAre(300));
+  EXPECT_EQ(jm.count(4), 10u);
+}
+
+// Test a crash between writing the snapshot and replacing the log: the
+// old log is recognized as already folded and not applied twice
+TEST(JournalTest, StaleLogAfterCompact) {
+  TempJournal file("stale");
+  std::string old_log;
+  {
+    JournaledMultiMap<int, int> jm(file.path);
+    jm.emplace(1, 1);
+    jm.emplace(1, 2);
+    jm.commit();
+    std::ifstream in(file.log(), std::ios::binary);
+    old_log.assign(std::istreambuf_iterator<char>(in), {});
+    jm.compact();
+  }
+  {
+    std::ofstream out(file.log(), std::ios::binary | std::ios::trunc);
+    out << old_log;
+  }
+  {
+    JournaledMultiMap<int, int> jm(file.path);
+    EXPECT_THAT(jm.view(1), ElementsAre(1, 2));
+    EXPECT_EQ(jm.recovery().records, 0u);
+  }
+
+  // A log that extends a snapshot is unusable without it
+  std::remove(file.snap().c_str());
+  EXPECT_THROW((JournaledMultiMap<int, int>(file.path)), std::runtime_error);
+}
+
+// Test a compaction that replaces the snapshot but not the log: commits
+// fail instead of going to the stale log, and a later compact recovers
+TEST(JournalTest, CompactLogNotReplaced) {
+  TempJournal file("log_not_replaced");
+  {
+    JournaledMultiMap<int, int> jm(file.path);
+    jm.emplace(1, 1);
+
+    // A directory in place of the log makes its rename fail
+    std::filesystem::remove(file.log());
+    std::filesystem::create_directory(file.log());
+    EXPECT_THROW(jm.compact(), std::runtime_error);
+    jm.emplace(1, 2);
+    EXPECT_THROW(jm.commit(), std::runtime_error);
+    EXPECT_GT(jm.pending_bytes(), 0u);
+
+    std::filesystem::remove(file.log());
+    jm.compact();
+    EXPECT_EQ(jm.pending_bytes(), 0u);
+    jm.emplace(1, 3);
+  }
+
+  JournaledMultiMap<int, int> jm(file.path);
+  EXPECT_THAT(jm.view(1), ElementsAre(1, 2, 3));
+  EXPECT_EQ(jm.recovery().records, 1u);
+}
+
+// Test foreign or mismatched logs are rejected
+TEST(JournalTest, Errors) {
+  TempJournal file("errors");
+  EXPECT_THROW((replay<MultiMap<int, int>>(file.log())), std::runtime_error);
+  {
+    JournaledMultiMap<int, int> jm(file.path);
+    jm.emplace(1, 1);
+  }
+  EXPECT_THROW((replay<MultiMap<int, double>>(file.log())),
+               std::runtime_error);
+  EXPECT_THROW((JournaledMultiMap<std::string, int>(file.path)),
+               std::runtime_error);
+
+  poke(file.log(), 0, 'X');
+  EXPECT_THROW((replay<MultiMap<int, int>>(file.log())), std::runtime_error);
+  EXPECT_THROW((JournaledMultiMap<int, int>(file.path)), std::runtime_error);
+}
+
+// Test the wrapped map's Stats policy sees logged and replayed writes
+TEST(JournalTest, CountingStats) {
+  TempJournal file("counting");
+  using Journaled =
+      JournaledMultiMap<int, int, std::vector, std::map, CountingStats>;
+  {
+    Journaled jm(file.path);
+    jm.emplace(1, 1);
+    jm.emplace(1, 2);
+    jm.erase(1, 1);
+    EXPECT_EQ(jm.map().counters().inserts, 2u);
+    EXPECT_EQ(jm.map().counters().erases, 1u);
+  }
+
+  Journaled jm(file.path);
+  EXPECT_THAT(jm.view(1), ElementsAre(2));
+  EXPECT_EQ(jm.map().counters().inserts, 2u);
+  EXPECT_EQ(jm.map().counters().erases, 1u);
+}
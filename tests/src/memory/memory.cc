@@ -0,0 +1,253 @@
+#include "dictool/ConcurrentMultiMap.h"
+#include "dictool/FlatHashMap.h"
+#include "dictool/FlatMap.h"
+#include "dictool/FrozenMultiMap.h"
+#include "dictool/MemoryUsage.h"
+#include "dictool/MultiDict.h"
+#include "dictool/SmallVector.h"
+#include "dictool/Snapshot.h"
+#include "dictool/VersionedMultiMap.h"
+#include "heap.h"
+#include <cstdio>
+#include <filesystem>
+#include <gtest/gtest.h>
+#include <list>
+#include <memory>
+#include <sstream>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+using namespace dictool;
+
+namespace {
+
+// A value type owning a heap buffer, measured through HeapUsage
+struct Blob {
+  std::unique_ptr<char[]> bytes;
+  size_t length = 0;
+
+  explicit Blob(size_t n) : bytes(new char[n]), length(n) {}
+};
+
+// Fill a map with keys 0..keys-1, key k holding k + 1 values
+template <typename Map> void fill(Map &m, int keys) {
+  for (int k = 0; k < keys; ++k) {
+    for (int i = 0; i <= k; ++i) {
+      m.emplace(k, i);
+    }
+  }
+}
+
+// Expect the estimate to match the heap blocks allocated by make(): the
+// bytes requested, and the number of blocks
+template <typename Make> void expect_exact(Make make) {
+  size_t bytes = counting_heap::live_bytes();
+  size_t blocks = counting_heap::live_blocks();
+  auto m = make();
+  bytes = counting_heap::live_bytes() - bytes;
+  blocks = counting_heap::live_blocks() - blocks;
+  auto usage = m.memory_usage();
+  EXPECT_EQ(usage.total() - usage.object - usage.allocator, bytes)
+      << usage.to_json();
+  EXPECT_EQ(usage.allocations, blocks) << usage.to_json();
+}
+
+} // namespace
+
+template <> struct dictool::HeapUsage<Blob> {
+  static constexpr bool owns_heap = true;
+
+  static void add(const Blob &b, MemoryUsage &usage) {
+    usage.payload += b.length;
+    usage.add_block(b.length);
+  }
+};
+
+// Test an empty map is just its object
+TEST(MemoryUsageTest, Empty) {
+  MultiMap<int, int> mm;
+  auto usage = mm.memory_usage();
+  EXPECT_EQ(usage.object, sizeof(mm));
+  EXPECT_EQ(usage.total(), sizeof(mm));
+  EXPECT_EQ(usage.allocations, 0u);
+}
+
+// Test the breakdown of the default layout
+TEST(MemoryUsageTest, Breakdown) {
+  MultiMap<int, int> mm;
+  fill(mm, 10);
+  auto usage = mm.memory_usage();
+  EXPECT_EQ(usage.keys, 10 * sizeof(int));
+  EXPECT_EQ(usage.headers, 10 * sizeof(std::vector<int>));
+  EXPECT_EQ(usage.values, 55 * sizeof(int));
+  EXPECT_GT(usage.structure, 0u);
+  EXPECT_EQ(usage.value_nodes, 0u);
+  EXPECT_EQ(usage.payload, 0u);
+  EXPECT_EQ(usage.allocations, 20u); // a node and a vector block per key
+
+  // Reserving shows up as slack only
+  size_t spare = (mm.at(1).capacity() - 2) * sizeof(int);
+  mm.reserve_values(1, 1000);
+  auto reserved = mm.memory_usage();
+  EXPECT_EQ(reserved.values, usage.values);
+  EXPECT_EQ(reserved.slack, usage.slack - spare + 998 * sizeof(int));
+}
+
+// Test the estimates match the heap blocks actually allocated
+TEST(MemoryUsageTest, MatchesHeap) {
+  expect_exact([] {
+    MultiMap<int, int> mm;
+    fill(mm, 50);
+    return mm;
+  });
+  expect_exact([] {
+    MultiMap<int, int, std::set, std::unordered_map> mm;
+    fill(mm, 50);
+    return mm;
+  });
+  expect_exact([] {
+    MultiMap<int, int, std::unordered_set, std::map> mm;
+    fill(mm, 50);
+    return mm;
+  });
+  expect_exact([] {
+    MultiMap<int, int, std::list> mm;
+    fill(mm, 20);
+    return mm;
+  });
+  expect_exact([] {
+    MultiMap<std::string, std::string, std::vector, std::unordered_map> mm;
+    for (int i = 0; i < 100; ++i) {
+      mm.emplace(std::to_string(i), std::string(static_cast<size_t>(i), 'x'));
+    }
+    return mm;
+  });
+  expect_exact([] {
+    MultiMap<int, int, small_vector, flat_map> mm;
+    fill(mm, 50);
+    return mm;
+  });
+  expect_exact([] {
+    MultiMap<int, int> mm;
+    fill(mm, 50);
+    return FrozenMultiMap<int, int>(mm);
+  });
+}
+
+// Test heap memory of keys and values is found, short strings are not
+TEST(MemoryUsageTest, Payload) {
+  MultiMap<std::string, std::string> mm;
+  mm.emplace("short", "s");
+  EXPECT_EQ(mm.memory_usage().payload, 0u);
+  std::string long_key(100, 'k');
+  mm.emplace(long_key, std::string(200, 'v'));
+  EXPECT_GE(mm.memory_usage().payload, 302u);
+
+  MultiMap<int, Blob> blobs;
+  blobs.emplace(1, 1000);
+  blobs.emplace(1, 24);
+  EXPECT_EQ(blobs.memory_usage().payload, 1024u);
+}
+
+// Test small vectors keep short value lists inline
+TEST(MemoryUsageTest, SmallVector) {
+  MultiMap<int, int, small_vector> mm;
+  mm.emplace(1, 1);
+  mm.emplace(1, 2);
+  auto usage = mm.memory_usage();
+  EXPECT_EQ(usage.values, 2 * sizeof(int));
+  EXPECT_EQ(usage.slack, sizeof(int)); // one free inline slot
+  EXPECT_EQ(usage.allocations, 1u);    // the map node only
+
+  for (int i = 0; i < 10; ++i) {
+    mm.emplace(1, i);
+  }
+  usage = mm.memory_usage();
+  EXPECT_EQ(usage.values, 12 * sizeof(int));
+  EXPECT_EQ(usage.allocations, 2u);
+  EXPECT_GE(usage.slack, small_vector_default_capacity * sizeof(int));
+}
+
+// Test hashed layouts count their bucket arrays and empty slots
+TEST(MemoryUsageTest, HashedDictionaries) {
+  MultiMap<int, int, std::vector, std::unordered_map> hashed;
+  MultiMap<int, int, std::vector, flat_hash_map> flat;
+  MultiMap<int, int> ordered;
+  fill(hashed, 100);
+  fill(flat, 100);
+  fill(ordered, 100);
+  auto h = hashed.memory_usage();
+  auto f = flat.memory_usage();
+  auto o = ordered.memory_usage();
+  EXPECT_EQ(h.keys, o.keys);
+  EXPECT_EQ(f.keys, o.keys);
+  EXPECT_EQ(h.values, o.values);
+  EXPECT_EQ(f.values, o.values);
+  EXPECT_LT(f.allocations, o.allocations);
+  EXPECT_GE(f.structure, (flat.cdata().bucket_count() - 100) *
+                             sizeof(std::pair<const int, std::vector<int>>));
+}
+
+// Test the other containers report comparable breakdowns
+TEST(MemoryUsageTest, OtherContainers) {
+  MultiMap<int, int> mm;
+  fill(mm, 100);
+  auto base = mm.memory_usage();
+
+  FrozenMultiMap<int, int> frozen(mm);
+  auto f = frozen.memory_usage();
+  EXPECT_EQ(f.keys, base.keys);
+  EXPECT_EQ(f.values, base.values);
+  EXPECT_EQ(f.headers, 0u);
+  EXPECT_LT(f.total(), base.total());
+
+  ConcurrentMultiMap<int, int> concurrent(4);
+  for (const auto &[key, value] : mm) {
+    concurrent.emplace(key, value);
+  }
+  auto c = concurrent.memory_usage();
+  EXPECT_EQ(c.keys, base.keys);
+  EXPECT_EQ(c.values, base.values);
+  EXPECT_GT(c.structure, base.structure);
+
+  const VersionedMultiMap<MultiMap<int, int>> versioned(mm);
+  auto v = versioned.memory_usage();
+  EXPECT_EQ(versioned.retired_count(), 0u);
+  EXPECT_EQ(v.keys, base.keys);
+  EXPECT_EQ(v.values, base.values);
+
+  auto path = (std::filesystem::temp_directory_path() / "dictool_memory.snap")
+                  .string();
+  save_binary(mm, path);
+  {
+    auto mapped = load_mmap<int, int>(path);
+    auto m = mapped.memory_usage();
+    EXPECT_EQ(m.mapped, std::filesystem::file_size(path));
+    EXPECT_EQ(m.total(), sizeof(mapped));
+  }
+  std::remove(path.c_str());
+}
+
+// Test the JSON and text output
+TEST(MemoryUsageTest, Output) {
+  MultiMap<int, int> mm;
+  fill(mm, 3);
+  auto usage = mm.memory_usage();
+  std::string json = usage.to_json();
+  EXPECT_NE(json.find("\"keys\":" + std::to_string(3 * sizeof(int))),
+            std::string::npos);
+  EXPECT_NE(json.find("\"total\":" + std::to_string(usage.total()) + "}"),
+            std::string::npos);
+
+  std::ostringstream text;
+  usage.print(text);
+  EXPECT_EQ(text.str().rfind("Total bytes: " + std::to_string(usage.total()),
+                             0),
+            0u);
+
+  MemoryUsage sum = usage;
+  sum += usage;
+  EXPECT_EQ(sum.total(), 2 * usage.total());
+}
@@ -1,4 +1,6 @@
 #include "fixture.h"
+#include <gmock/gmock.h>
+#include <unordered_map>
 
 // Test default constructor
 TEST_F(MultiMapTest, DefaultConstructor) {
@@ -21,4 +23,48 @@ TEST_F(MultiMapTest, InitializerListConstructor) {
   EXPECT_EQ(mm.key_count(), 2);
   EXPECT_TRUE(mm.contains(1));
   EXPECT_TRUE(mm.contains(2));
-}
\ No newline at end of file
+}
+
+// Test from_unsorted groups keys and keeps value order within a key
+TEST_F(MultiMapTest, FromUnsorted) {
+  std::vector<std::pair<int, int>> pairs = {
+      {3, 30}, {1, 10}, {2, 20}, {1, 11}, {3, 31}, {1, 12}};
+  auto mm = MultiMap<int, int>::from_unsorted(pairs);
+
+  EXPECT_EQ(mm.size(), 6);
+  EXPECT_EQ(mm.key_count(), 3);
+  EXPECT_THAT(mm.get(1), ::testing::ElementsAre(10, 11, 12));
+  EXPECT_THAT(mm.get(3), ::testing::ElementsAre(30, 31));
+  // each container is reserved before filling; reserve may round up
+  EXPECT_GE(mm.at(1).capacity(), 3);
+}
+
+// Test bulk_load appends to an existing multimap
+TEST_F(MultiMapTest, BulkLoadExisting) {
+  std::vector<std::pair<int, int>> pairs = {{2, 31}, {0, 1}, {1, 21}, {5, 50}};
+  mm_int_int.bulk_load(pairs.begin(), pairs.end());
+
+  EXPECT_EQ(mm_int_int.size(), 7);
+  EXPECT_EQ(mm_int_int.key_count(), 4);
+  EXPECT_THAT(mm_int_int.get(1), ::testing::ElementsAre(10, 20, 21));
+  EXPECT_THAT(mm_int_int.get(2), ::testing::ElementsAre(30, 31));
+  EXPECT_THAT(mm_int_int.keys(), ::testing::ElementsAre(0, 1, 2, 5));
+}
+
+// Test bulk_load on hashed dictionaries and set containers
+TEST_F(MultiMapTest, BulkLoadHashedAndSet) {
+  std::vector<std::pair<std::string, int>> pairs = {
+      {"b", 2}, {"a", 1}, {"b", 3}, {"a", 1}, {"c", 4}};
+  auto hashed =
+      MultiMap<std::string, int, std::vector, std::unordered_map>::from_unsorted(
+          pairs);
+  EXPECT_EQ(hashed.size(), 5);
+  EXPECT_EQ(hashed.key_count(), 3);
+  EXPECT_THAT(hashed.get("b"), ::testing::ElementsAre(2, 3));
+
+  auto unique =
+      MultiMap<std::string, int, std::set>::from_unsorted(pairs.begin(),
+                                                          pairs.end());
+  EXPECT_EQ(unique.size(), 4);
+  EXPECT_THAT(unique.get("a"), ::testing::ElementsAre(1));
+}
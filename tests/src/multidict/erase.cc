@@ -1,5 +1,5 @@
-
 #include "fixture.h"
+#include <gmock/gmock.h>
 
 // Test erase by key
 TEST_F(MultiMapTest, EraseByKey) {
@@ -30,3 +30,131 @@ TEST_F(MultiMapTest, EraseByKeyValue) {
   EXPECT_FALSE(mm_int_int.erase(1, 999));  // Non-existent value
   EXPECT_FALSE(mm_int_int.erase(999, 10)); // Non-existent key
 }
+
+// Value comparing equal on v only, so duplicates stay distinguishable
+struct Tagged {
+  int v;
+  int tag;
+  bool operator==(const Tagged &other) const { return v == other.v; }
+};
+
+// Test erase by iterator removes the pointed-at duplicate
+TEST_F(MultiMapTest, EraseByIteratorDuplicates) {
+  MultiMap<int, Tagged> mm;
+  mm.emplace(1, Tagged{10, 0});
+  mm.emplace(1, Tagged{10, 1});
+  mm.emplace(1, Tagged{20, 2});
+
+  auto it = std::next(mm.find(1));
+  ASSERT_EQ(it.value().tag, 1);
+  it = mm.erase(it);
+  EXPECT_EQ(it.value().tag, 2);
+  ASSERT_EQ(mm.count(1), 2);
+  EXPECT_EQ(mm.at(1)[0].tag, 0);
+  EXPECT_EQ(mm.at(1)[1].tag, 2);
+}
+
+// Test erase by iterator drops emptied keys and returns the next key
+TEST_F(MultiMapTest, EraseByIteratorLastValue) {
+  auto it = mm_int_int.find(2);
+  it = mm_int_int.erase(it);
+  EXPECT_EQ(it, mm_int_int.end());
+  EXPECT_FALSE(mm_int_int.contains(2));
+
+  it = mm_int_int.erase(mm_int_int.begin());
+  EXPECT_EQ(it.key(), 1);
+  EXPECT_EQ(it.value(), 20);
+  it = mm_int_int.erase(it);
+  EXPECT_EQ(it, mm_int_int.end());
+  EXPECT_TRUE(mm_int_int.empty());
+}
+
+// Test erase through a const_iterator
+TEST_F(MultiMapTest, EraseByConstIterator) {
+  const auto &cmm = mm_int_int;
+  MultiMap<int, int>::const_iterator pos = cmm.find(1);
+  auto it = mm_int_int.erase(pos);
+  EXPECT_EQ(it.value(), 20);
+  EXPECT_EQ(mm_int_int.size(), 2);
+}
+
+// Test range erase spanning several keys
+TEST_F(MultiMapTest, EraseRange) {
+  MultiMap<int, int> mm = {{1, 10}, {1, 11}, {2, 20}, {3, 30}, {3, 31}};
+  auto first = std::next(mm.begin());   // (1, 11)
+  auto last = std::next(mm.begin(), 4); // (3, 31)
+  auto it = mm.erase(first, last);
+  EXPECT_EQ(it.key(), 3);
+  EXPECT_EQ(it.value(), 31);
+  EXPECT_EQ(mm.size(), 2);
+  EXPECT_FALSE(mm.contains(2));
+  EXPECT_THAT(mm.get(1), ::testing::ElementsAre(10));
+  EXPECT_THAT(mm.get(3), ::testing::ElementsAre(31));
+
+  EXPECT_EQ(mm.erase(mm.begin(), mm.begin()), mm.begin());
+  EXPECT_EQ(mm.erase(mm.begin(), mm.end()), mm.end());
+  EXPECT_TRUE(mm.empty());
+  EXPECT_EQ(mm.size(), 0);
+}
+
+// Test range erase within a set container
+TEST(MultiMapSetTest, EraseRange) {
+  MultiMap<int, int, std::set> mm = {{1, 1}, {1, 2}, {1, 3}, {2, 4}};
+  auto [first, last] = mm.equal_range(1);
+  auto it = mm.erase(std::next(first), last);
+  EXPECT_EQ(it.key(), 2);
+  EXPECT_EQ(mm.size(), 2);
+  EXPECT_THAT(mm.get(1), ::testing::ElementsAre(1));
+}
+
+// Test writing a value through a mutable iterator
+TEST_F(MultiMapTest, MutableIterator) {
+  for (auto it = mm_int_int.begin(); it != mm_int_int.end(); ++it) {
+    it.value() += 1;
+  }
+  EXPECT_THAT(mm_int_int.get(1), ::testing::ElementsAre(11, 21));
+  EXPECT_EQ(std::distance(mm_int_int.cbegin(), mm_int_int.cend()), 3);
+}
+
+// Test erase_if with a per-value predicate
+TEST_F(MultiMapTest, EraseIfValue) {
+  MultiMap<int, int> mm = {{1, 1}, {1, 2}, {1, 3}, {2, 4}, {3, 5}, {3, 7}};
+  auto removed = erase_if(mm, [](int, int v) { return v % 2 == 1; });
+  EXPECT_EQ(removed, 4);
+  EXPECT_EQ(mm.size(), 2);
+  EXPECT_EQ(mm.key_count(), 2);
+  EXPECT_FALSE(mm.contains(3));
+  EXPECT_THAT(mm.get(1), ::testing::ElementsAre(2));
+  EXPECT_THAT(mm.get(2), ::testing::ElementsAre(4));
+}
+
+// Test erase_if with a per-key group predicate
+TEST_F(MultiMapTest, EraseIfGroup) {
+  auto removed = erase_if(mm_int_int, [](int, const std::vector<int> &c) {
+    return c.size() > 1;
+  });
+  EXPECT_EQ(removed, 2);
+  EXPECT_EQ(mm_int_int.size(), 1);
+  EXPECT_FALSE(mm_int_int.contains(1));
+  EXPECT_TRUE(mm_int_int.contains(2));
+}
+
+// Test retain keeps only matching values
+TEST_F(MultiMapTest, Retain) {
+  auto removed = retain(mm_int_int, [](int k, int v) { return v == 10 * k; });
+  EXPECT_EQ(removed, 2);
+  EXPECT_EQ(mm_int_int.size(), 1);
+  EXPECT_THAT(mm_int_int.get(1), ::testing::ElementsAre(10));
+  EXPECT_FALSE(mm_int_int.contains(2));
+}
+
+// Test erase_if on set containers and drops empty keys
+TEST(MultiMapSetTest, EraseIf) {
+  MultiMap<int, int, std::set> mm = {{1, 1}, {1, 2}, {2, 3}};
+  mm[4]; // empty key
+  EXPECT_EQ(erase_if(mm, [](int, int v) { return v >= 2; }), 2);
+  EXPECT_EQ(mm.size(), 1);
+  EXPECT_EQ(mm.key_count(), 1);
+  EXPECT_EQ(mm.retain([](int, const std::set<int> &) { return false; }), 1);
+  EXPECT_TRUE(mm.empty());
+}
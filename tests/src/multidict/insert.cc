@@ -58,3 +58,76 @@ TEST_F(MultiMapTest, Insert) {
   EXPECT_EQ(mm.value_count(1), 2);
   EXPECT_EQ(mm.value_count(2), 1);
 }
+
+// Key type counting copies, to check emplace does not copy existing keys
+struct CountedKey {
+  static inline int copies = 0;
+  int id;
+  CountedKey(int id) : id(id) {}
+  CountedKey(const CountedKey &other) : id(other.id) { ++copies; }
+  CountedKey(CountedKey &&other) noexcept = default;
+  CountedKey &operator=(const CountedKey &other) = default;
+  bool operator<(const CountedKey &other) const { return id < other.id; }
+};
+
+// Comparator counting calls, to check the number of tree probes
+struct CountingLess {
+  static inline int calls = 0;
+  bool operator()(int a, int b) const {
+    ++calls;
+    return a < b;
+  }
+};
+template <typename K, typename C>
+using CountingMap = std::map<K, C, CountingLess>;
+
+// Test try_emplace constructs the value in place
+TEST_F(MultiMapTest, TryEmplace) {
+  MultiMap<int, std::string> mm;
+  auto it = mm.try_emplace(1, 3, 'x');
+  EXPECT_EQ(it.key(), 1);
+  EXPECT_EQ(it.value(), "xxx");
+  mm.try_emplace(1, "abc", 2);
+  EXPECT_THAT(mm.get(1), ::testing::ElementsAre("xxx", "ab"));
+  EXPECT_EQ(mm.size(), 2);
+}
+
+// Test emplace with piecewise arguments
+TEST_F(MultiMapTest, EmplacePiecewise) {
+  MultiMap<std::string, std::string> mm;
+  auto it = mm.emplace(std::piecewise_construct, std::forward_as_tuple("key"),
+                       std::forward_as_tuple(2, 'v'));
+  EXPECT_EQ(it.key(), "key");
+  EXPECT_EQ(it.value(), "vv");
+  EXPECT_EQ(mm.size(), 1);
+}
+
+// Test emplace does not copy a key that is already present
+TEST_F(MultiMapTest, EmplaceExistingKeyNoCopy) {
+  MultiMap<CountedKey, int> mm;
+  CountedKey key(1);
+  mm.emplace(key, 10);
+  CountedKey::copies = 0;
+  mm.emplace(key, 20);
+  mm.insert({key, 30});
+  EXPECT_EQ(CountedKey::copies, 1); // only the initializer list pair
+  EXPECT_EQ(mm.count(key), 3);
+}
+
+// Test emplace_hint keeps sorted input at a constant number of probes
+TEST_F(MultiMapTest, EmplaceHintSorted) {
+  MultiMap<int, int, std::vector, CountingMap> mm;
+  for (int i = 0; i < 64; ++i) {
+    mm.emplace(i, i);
+  }
+  CountingLess::calls = 0;
+  auto it = mm.end();
+  for (int i = 64; i < 1024; ++i) {
+    it = mm.emplace_hint(it, i, i);
+    it = mm.emplace_hint(it, i, i + 1);
+  }
+  EXPECT_LE(CountingLess::calls, 4 * 2 * (1024 - 64));
+  EXPECT_EQ(mm.size(), 64 + 2 * (1024 - 64));
+  EXPECT_EQ(mm.key_count(), 1024);
+  EXPECT_THAT(mm.get(100), ::testing::ElementsAre(100, 101));
+}
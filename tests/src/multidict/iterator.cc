@@ -49,3 +49,34 @@ TEST_F(MultiMapTest, IteratorEquality) {
   auto end_it = mm_int_int.end();
   EXPECT_NE(it1, end_it);
 }
+
+// Test groups hands out each key once with a view of its values
+TEST_F(MultiMapTest, Groups) {
+  std::vector<int> keys;
+  std::vector<int> values;
+  for (auto [key, group] : mm_int_int.groups()) {
+    keys.push_back(key);
+    values.insert(values.end(), group.begin(), group.end());
+  }
+  EXPECT_THAT(keys, ::testing::ElementsAre(1, 2));
+  EXPECT_THAT(values, ::testing::ElementsAre(10, 20, 30));
+  EXPECT_EQ(mm_int_int.groups().size(), 2);
+  EXPECT_TRUE(empty_mm.groups().empty());
+}
+
+// Test for_each_group over vector and set containers
+TEST_F(MultiMapTest, ForEachGroup) {
+  int sum = 0;
+  mm_int_int.for_each_group([&](int key, Span<const int> group) {
+    for (int v : group) {
+      sum += key * v;
+    }
+  });
+  EXPECT_EQ(sum, 1 * 10 + 1 * 20 + 2 * 30);
+
+  MultiMap<int, int, std::set> mm = {{1, 2}, {1, 1}, {3, 4}};
+  std::vector<size_t> sizes;
+  mm.for_each_group(
+      [&](int, const auto &group) { sizes.push_back(group.size()); });
+  EXPECT_THAT(sizes, ::testing::ElementsAre(2, 1));
+}
@@ -1,4 +1,7 @@
 #include "fixture.h"
+#include <gmock/gmock.h>
+#include <memory>
+#include <unordered_map>
 
 // Test keys method
 TEST_F(MultiMapTest, Keys) {
@@ -100,3 +103,83 @@ TEST_F(MultiMapTest, PrintMethods) {
   std::string all_output = testing::internal::GetCapturedStdout();
   EXPECT_FALSE(all_output.empty());
 }
+
+// Traits used to check which capacity methods are enabled
+template <typename MM, typename = void>
+struct CanReserve : std::false_type {};
+template <typename MM>
+struct CanReserve<MM, std::void_t<decltype(std::declval<MM>().reserve(1))>>
+    : std::true_type {};
+template <typename MM, typename = void>
+struct CanReserveValues : std::false_type {};
+template <typename MM>
+struct CanReserveValues<
+    MM, std::void_t<decltype(std::declval<MM>().reserve_values({}, 1))>>
+    : std::true_type {};
+
+// Test reserve, reserve_values and shrink_to_fit
+TEST_F(MultiMapTest, ReserveAndShrink) {
+  MultiMap<int, int, std::vector, std::unordered_map> mm;
+  mm.reserve(100);
+  EXPECT_GE(mm.cdata().bucket_count(), 100);
+
+  mm.reserve_values(1, 64);
+  EXPECT_GE(mm.at(1).capacity(), 64);
+  EXPECT_EQ(mm.size(), 0);
+  for (int i = 0; i < 10; ++i) {
+    mm.emplace(1, i);
+  }
+  mm.shrink_to_fit();
+  EXPECT_EQ(mm.at(1).capacity(), 10);
+  EXPECT_EQ(mm.size(), 10);
+
+  static_assert(CanReserve<decltype(mm)>::value);
+  static_assert(!CanReserve<MultiMap<int, int>>::value);
+  static_assert(CanReserveValues<MultiMap<int, int>>::value);
+  static_assert(!CanReserveValues<MultiMap<int, int, std::set>>::value);
+}
+
+// Test merging an rvalue splices missing keys and moves values
+TEST_F(MultiMapTest, MergeMove) {
+  MultiMap<int, int> mm1 = {{1, 10}, {2, 20}};
+  mm1[4]; // empty container, receives the other container whole
+  MultiMap<int, int> mm2 = {{1, 30}, {3, 40}, {3, 41}, {4, 50}};
+  const auto *spliced = &mm2.at(3);
+  const auto *buffer = mm2.at(4).data();
+
+  mm1.merge(std::move(mm2));
+
+  EXPECT_EQ(mm1.size(), 6);
+  EXPECT_THAT(mm1.get(1), ::testing::ElementsAre(10, 30));
+  EXPECT_THAT(mm1.get(3), ::testing::ElementsAre(40, 41));
+  EXPECT_EQ(&mm1.at(3), spliced);
+  EXPECT_EQ(mm1.at(4).data(), buffer);
+  EXPECT_TRUE(mm2.empty());
+  EXPECT_EQ(mm2.size(), 0);
+}
+
+// Test merging an rvalue works with move-only values
+TEST_F(MultiMapTest, MergeMoveOnly) {
+  MultiMap<int, std::unique_ptr<int>, std::vector, std::unordered_map> mm1;
+  MultiMap<int, std::unique_ptr<int>, std::vector, std::unordered_map> mm2;
+  mm1.emplace(1, std::make_unique<int>(10));
+  mm2.emplace(1, std::make_unique<int>(20));
+  mm2.emplace(2, std::make_unique<int>(30));
+
+  mm1.merge(std::move(mm2));
+
+  EXPECT_EQ(mm1.size(), 3);
+  EXPECT_EQ(*mm1.at(1)[1], 20);
+  EXPECT_EQ(*mm1.at(2)[0], 30);
+  EXPECT_EQ(mm2.size(), 0);
+}
+
+// Test merging an rvalue with set containers
+TEST(MultiMapSetTest, MergeMove) {
+  MultiMap<int, int, std::set> mm1 = {{1, 1}, {1, 2}};
+  MultiMap<int, int, std::set> mm2 = {{1, 2}, {1, 3}, {2, 4}};
+  mm1.merge(std::move(mm2));
+  EXPECT_EQ(mm1.size(), 4);
+  EXPECT_EQ(mm1.count(1), 3);
+  EXPECT_TRUE(mm2.empty());
+}
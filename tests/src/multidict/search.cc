@@ -1,5 +1,6 @@
 #include "fixture.h"
 #include <gmock/gmock.h>
+#include <string_view>
 
 // Test contains method
 TEST_F(MultiMapTest, Contains) {
@@ -95,4 +96,80 @@ TEST_F(MultiMapTest, EqualRange) {
   }
   EXPECT_EQ(values.size(), 2);
   EXPECT_THAT(values, ::testing::ElementsAre('a', 'b'));
-}
\ No newline at end of file
+}
+
+// Test lookups by std::string_view on a transparent dictionary
+TEST(MultiMapTransparentTest, StringViewLookup) {
+  MultiMap<std::string, int, std::vector, TransparentMap> mm = {
+      {"apple", 1}, {"apple", 2}, {"banana", 3}};
+  std::string_view apple = "apple";
+  std::string_view cherry = "cherry";
+
+  EXPECT_TRUE(mm.contains(apple));
+  EXPECT_FALSE(mm.contains(cherry));
+  EXPECT_EQ(mm.count(apple), 2);
+  EXPECT_EQ(mm.count(cherry), 0);
+  EXPECT_EQ(mm.find(apple).key(), "apple");
+  EXPECT_EQ(mm.find(cherry), mm.end());
+  EXPECT_THAT(mm.get(apple), ::testing::ElementsAre(1, 2));
+  EXPECT_TRUE(mm.get(cherry).empty());
+  EXPECT_EQ(mm.at(apple).size(), 2);
+  EXPECT_THROW(auto foo = mm.at(cherry), std::out_of_range);
+
+  auto [first, last] = mm.equal_range(apple);
+  std::vector<int> values;
+  for (auto it = first; it != last; ++it) {
+    values.push_back(it.value());
+  }
+  EXPECT_THAT(values, ::testing::ElementsAre(1, 2));
+
+  EXPECT_EQ(mm.erase(std::string_view("banana")), 1);
+  EXPECT_EQ(mm.erase(cherry), 0);
+  EXPECT_EQ(mm.size(), 2);
+  EXPECT_TRUE(mm.contains("apple"));
+}
+
+// Test view returns a span over contiguous containers
+TEST_F(MultiMapTest, View) {
+  auto values = mm_int_int.view(1);
+  static_assert(std::is_same_v<decltype(values), Span<const int>>);
+  ASSERT_EQ(values.size(), 2);
+  EXPECT_EQ(values.data(), mm_int_int.at(1).data());
+  EXPECT_EQ(values[0], 10);
+  EXPECT_THAT(values, ::testing::ElementsAre(10, 20));
+
+  auto missing = mm_int_int.view(999);
+  EXPECT_TRUE(missing.empty());
+  EXPECT_EQ(missing.begin(), missing.end());
+  EXPECT_FALSE(mm_int_int.contains(999));
+}
+
+// Test view returns an iterator range over set containers
+TEST(MultiMapSetTest, View) {
+  MultiMap<int, int, std::set> mm = {{1, 30}, {1, 10}, {1, 20}};
+  auto values = mm.view(1);
+  EXPECT_EQ(values.size(), 3);
+  EXPECT_THAT(values, ::testing::ElementsAre(10, 20, 30));
+
+  auto missing = mm.view(2);
+  EXPECT_TRUE(missing.empty());
+  EXPECT_EQ(missing.begin(), missing.end());
+  EXPECT_EQ(mm.key_count(), 1);
+}
+
+// Test view with a string_view key on a transparent dictionary
+TEST(MultiMapTransparentTest, View) {
+  MultiMap<std::string, int, std::vector, TransparentMap> mm = {{"a", 1}};
+  EXPECT_THAT(mm.view(std::string_view("a")), ::testing::ElementsAre(1));
+  EXPECT_TRUE(mm.view(std::string_view("b")).empty());
+}
+
+// Test find_view returns a view of present keys and nullopt for absent ones
+TEST_F(MultiMapTest, FindView) {
+  auto values = mm_int_int.find_view(1);
+  ASSERT_TRUE(values.has_value());
+  EXPECT_EQ(values->data(), mm_int_int.at(1).data());
+  EXPECT_THAT(*values, ::testing::ElementsAre(10, 20));
+  EXPECT_FALSE(mm_int_int.find_view(999).has_value());
+  EXPECT_FALSE(mm_int_int.contains(999));
+}
@@ -0,0 +1,126 @@
+#include "fixture.h"
+
+// Sum the values key by key, independent of the maintained counter
+template <typename MM> static size_t brute_size(const MM &mm) {
+  size_t count = 0;
+  for (const auto &[key, container] : mm.cdata()) {
+    count += container.size();
+  }
+  return count;
+}
+
+#define EXPECT_COUNTS(mm)                                                      \
+  do {                                                                         \
+    EXPECT_EQ((mm).size(), brute_size(mm));                                    \
+    EXPECT_EQ((mm).total_value_count(), brute_size(mm));                       \
+  } while (0)
+
+// Test counter after emplace and every insert overload
+TEST_F(MultiMapTest, SizeAfterInsert) {
+  EXPECT_COUNTS(mm_int_int);
+
+  MultiMap<int, int> mm;
+  mm.emplace(1, 10);
+  EXPECT_COUNTS(mm);
+  mm.insert({1, 20});
+  EXPECT_COUNTS(mm);
+  std::pair<const int, int> kv(2, 30);
+  mm.insert(kv);
+  EXPECT_COUNTS(mm);
+  std::vector<std::pair<const int, int>> range = {{3, 40}, {3, 50}};
+  mm.insert(range.begin(), range.end());
+  EXPECT_COUNTS(mm);
+  mm.insert({{4, 60}, {5, 70}});
+  EXPECT_COUNTS(mm);
+  std::vector<int> vals = {80, 90, 100};
+  mm.insert(6, vals.begin(), vals.end());
+  EXPECT_COUNTS(mm);
+  EXPECT_EQ(mm.size(), 10);
+}
+
+// Test counter after every erase overload
+TEST_F(MultiMapTest, SizeAfterErase) {
+  MultiMap<int, int> mm = {{1, 10}, {1, 20}, {2, 30}, {3, 40}, {3, 50}};
+  mm.erase(mm.find(1));
+  EXPECT_COUNTS(mm);
+  EXPECT_TRUE(mm.erase(3, 40));
+  EXPECT_FALSE(mm.erase(3, 999));
+  EXPECT_COUNTS(mm);
+  EXPECT_EQ(mm.erase(2), 1);
+  EXPECT_EQ(mm.erase(2), 0);
+  EXPECT_COUNTS(mm);
+  mm.erase(mm.begin(), mm.end());
+  EXPECT_COUNTS(mm);
+  EXPECT_EQ(mm.size(), 0);
+}
+
+// Test counter after merge and clear
+TEST_F(MultiMapTest, SizeAfterMergeAndClear) {
+  MultiMap<int, int> other = {{1, 30}, {7, 70}};
+  mm_int_int.merge(other);
+  EXPECT_COUNTS(mm_int_int);
+  EXPECT_EQ(mm_int_int.size(), 5);
+
+  mm_int_int.clear();
+  EXPECT_COUNTS(mm_int_int);
+  EXPECT_EQ(mm_int_int.size(), 0);
+}
+
+// Test counter after writes through operator[]
+TEST_F(MultiMapTest, SizeAfterOperatorBracket) {
+  mm_int_int[1].push_back(40);
+  EXPECT_COUNTS(mm_int_int);
+  EXPECT_EQ(mm_int_int.size(), 4);
+
+  mm_int_int[2].clear();
+  EXPECT_COUNTS(mm_int_int);
+  mm_int_int.emplace(5, 50);
+  EXPECT_COUNTS(mm_int_int);
+  EXPECT_EQ(mm_int_int.size(), 4);
+}
+
+// Test counter with a set container dropping duplicates
+TEST(MultiMapSetTest, SizeIgnoresDuplicates) {
+  MultiMap<int, int, std::set> mm;
+  mm.emplace(1, 10);
+  mm.emplace(1, 10);
+  std::vector<int> vals = {10, 20, 20};
+  mm.insert(1, vals.begin(), vals.end());
+  EXPECT_COUNTS(mm);
+  EXPECT_EQ(mm.size(), 2);
+  EXPECT_TRUE(mm.erase(1, 10));
+  EXPECT_FALSE(mm.erase(1, 10));
+  EXPECT_COUNTS(mm);
+}
+
+// Test counter across copy and move
+TEST_F(MultiMapTest, SizeAfterCopyAndMove) {
+  MultiMap<int, int> copy = mm_int_int;
+  EXPECT_COUNTS(copy);
+  MultiMap<int, int> moved = std::move(mm_int_int);
+  EXPECT_COUNTS(moved);
+  EXPECT_COUNTS(mm_int_int);
+  EXPECT_EQ(mm_int_int.size(), 0);
+
+  copy = std::move(moved);
+  EXPECT_COUNTS(copy);
+  EXPECT_EQ(moved.size(), 0);
+}
+
+// Test writes through a reference held across size() are still counted,
+// and recount() makes the count O(1) again
+TEST_F(MultiMapTest, SizeWithHeldReference) {
+  auto &values = mm_int_int[1];
+  values.push_back(40);
+  EXPECT_EQ(mm_int_int.size(), 4);
+  values.push_back(50);
+  EXPECT_EQ(mm_int_int.size(), 5);
+  EXPECT_COUNTS(mm_int_int);
+
+  mm_int_int.recount();
+  EXPECT_EQ(mm_int_int.size(), 5);
+  mm_int_int.emplace(3, 30);
+  mm_int_int.erase(2);
+  EXPECT_COUNTS(mm_int_int);
+  EXPECT_EQ(mm_int_int.size(), 5);
+}
@@ -0,0 +1,184 @@
+#include "fixture.h"
+#include <sstream>
+#include <string>
+#include <unordered_map>
+
+using CountingMap =
+    MultiMap<int, int, std::vector, std::map, dictool::CountingStats>;
+
+// The default policy adds no state to the map
+static_assert(sizeof(MultiMap<int, int>) ==
+              sizeof(MultiMap<int, int, std::vector, std::map, NoStats>));
+static_assert(sizeof(MultiMap<int, int>) < sizeof(CountingMap));
+
+// Test lookups, hits and misses are counted by every read-only lookup
+TEST(MultiMapStatsTest, CountsLookups) {
+  CountingMap mm;
+  mm.emplace(1, 10);
+  mm.emplace(1, 11);
+  mm.emplace(2, 20);
+  mm.reset_counters();
+
+  EXPECT_TRUE(mm.contains(1));
+  EXPECT_FALSE(mm.contains(3));
+  EXPECT_EQ(mm.count(1), 2u);
+  EXPECT_NE(mm.find(2), mm.end());
+  EXPECT_EQ(mm.find(4), mm.end());
+  EXPECT_EQ(mm.at(1).size(), 2u);
+  EXPECT_THROW(static_cast<void>(mm.at(5)), std::out_of_range);
+
+  auto counts = mm.counters();
+  EXPECT_EQ(counts.lookups, 7u);
+  EXPECT_EQ(counts.hits, 4u);
+  EXPECT_EQ(counts.misses, 3u);
+  EXPECT_EQ(counts.inserts, 0u);
+}
+
+// Test inserted and erased values are counted, growths are seen
+TEST(MultiMapStatsTest, CountsUpdates) {
+  CountingMap mm;
+  for (int i = 0; i < 100; ++i) {
+    mm.emplace(i % 4, i);
+  }
+  mm.insert({{7, 1}, {7, 2}});
+  auto counts = mm.counters();
+  EXPECT_EQ(counts.inserts, 102u);
+  EXPECT_GT(counts.growths, 4u);
+  EXPECT_EQ(counts.rehashes, 0u);
+
+  mm.erase(0);
+  mm.erase(1, 1);
+  mm.erase(mm.begin());
+  EXPECT_EQ(mm.counters().erases, 27u);
+  mm.clear();
+  EXPECT_EQ(mm.counters().erases, 102u);
+
+  mm.reset_counters();
+  counts = mm.counters();
+  EXPECT_EQ(counts.inserts, 0u);
+  EXPECT_EQ(counts.erases, 0u);
+  EXPECT_EQ(counts.growths, 0u);
+}
+
+// Test writes through operator[] are reported at recount() and clear()
+TEST(MultiMapStatsTest, OperatorBracket) {
+  CountingMap mm;
+  mm.emplace(1, 1);
+  mm[1].push_back(2);
+  mm[2].push_back(3);
+  EXPECT_EQ(mm.counters().inserts, 1u);
+  mm.recount();
+  EXPECT_EQ(mm.counters().inserts, 3u);
+
+  mm[1].clear();
+  mm.recount();
+  EXPECT_EQ(mm.counters().erases, 2u);
+
+  // erase() takes away values the running count never saw
+  mm[3].assign(5, 0);
+  mm.erase(3);
+  EXPECT_EQ(mm.counters().erases, 7u);
+  mm.clear();
+  auto counts = mm.counters();
+  EXPECT_EQ(counts.inserts, 8u);
+  EXPECT_EQ(counts.erases, 8u);
+}
+
+// Test copies carry the counts, and NoStats maps report none
+TEST(MultiMapStatsTest, CopyAndNoStats) {
+  CountingMap mm;
+  mm.emplace(1, 1);
+  CountingMap copy(mm);
+  EXPECT_EQ(copy.counters().inserts, 1u);
+  CountingMap moved(std::move(copy));
+  EXPECT_EQ(moved.counters().inserts, 1u);
+
+  MultiMap<int, int> plain;
+  plain.emplace(1, 1);
+  EXPECT_FALSE(plain.contains(2));
+  EXPECT_EQ(plain.counters().inserts, 0u);
+  EXPECT_EQ(plain.counters().lookups, 0u);
+  EXPECT_FALSE(plain.stats().counts.has_value());
+}
+
+// Test the histogram buckets values per key on a log scale
+TEST(MultiMapStatsTest, Histogram) {
+  MultiMap<int, int> mm;
+  mm.emplace(0, 0);
+  mm.erase(0, 0); // leaves a key without values
+  mm.emplace(1, 1);
+  for (int i = 0; i < 3; ++i) {
+    mm.emplace(2, i);
+  }
+  for (int i = 0; i < 8; ++i) {
+    mm.emplace(3, i);
+  }
+
+  auto stats = mm.stats();
+  EXPECT_EQ(stats.keys, 4u);
+  EXPECT_EQ(stats.values, 12u);
+  EXPECT_EQ(stats.max_values, 8u);
+  EXPECT_DOUBLE_EQ(stats.mean_values(), 3.0);
+  EXPECT_EQ(stats.histogram, (std::vector<size_t>{1, 1, 1, 0, 1}));
+  EXPECT_FALSE(stats.load_factor.has_value());
+}
+
+// Test the heaviest keys are reported in order, ties in key order
+TEST(MultiMapStatsTest, TopKeys) {
+  MultiMap<int, int> mm;
+  for (int key = 0; key < 50; ++key) {
+    for (int i = 0; i < key % 7; ++i) {
+      mm.emplace(key, i);
+    }
+  }
+
+  auto stats = mm.stats(4);
+  ASSERT_EQ(stats.top_keys.size(), 4u);
+  EXPECT_EQ(stats.top_keys[0], std::make_pair(6, size_t{6}));
+  EXPECT_EQ(stats.top_keys[1], std::make_pair(13, size_t{6}));
+  EXPECT_EQ(stats.top_keys[2], std::make_pair(20, size_t{6}));
+  EXPECT_EQ(stats.top_keys[3], std::make_pair(27, size_t{6}));
+
+  EXPECT_TRUE(mm.stats(0).top_keys.empty());
+  EXPECT_EQ(mm.stats(1000).top_keys.size(), mm.key_count());
+}
+
+// Test hashed maps report their load factor and rehashes
+TEST(MultiMapStatsTest, HashedMap) {
+  MultiMap<std::string, int, std::vector, std::unordered_map,
+           dictool::CountingStats>
+      mm;
+  for (int i = 0; i < 1000; ++i) {
+    mm.emplace(std::to_string(i), i);
+  }
+  auto stats = mm.stats();
+  ASSERT_TRUE(stats.load_factor.has_value());
+  EXPECT_GT(*stats.load_factor, 0.0);
+  ASSERT_TRUE(stats.counts.has_value());
+  EXPECT_GT(stats.counts->rehashes, 0u);
+}
+
+// Test the JSON and text summaries
+TEST(MultiMapStatsTest, Output) {
+  MultiMap<std::string, int, std::vector, std::map, dictool::CountingStats>
+      mm;
+  mm.emplace("a\"b", 1);
+  mm.emplace("a\"b", 2);
+  mm.emplace("c", 3);
+  EXPECT_TRUE(mm.contains("c"));
+
+  std::string json = mm.stats().to_json();
+  EXPECT_EQ(json.front(), '{');
+  EXPECT_EQ(json.back(), '}');
+  EXPECT_NE(json.find("\"keys\":2"), std::string::npos);
+  EXPECT_NE(json.find("\"values\":3"), std::string::npos);
+  EXPECT_NE(json.find("{\"key\":\"a\\\"b\",\"values\":2}"),
+            std::string::npos);
+  EXPECT_NE(json.find("\"load_factor\":null"), std::string::npos);
+  EXPECT_NE(json.find("\"lookups\":1,\"hits\":1"), std::string::npos);
+
+  std::ostringstream text;
+  mm.print_stats(text);
+  EXPECT_EQ(text.str().rfind("Total keys: 2\nTotal values: 3\n", 0), 0u);
+  EXPECT_NE(text.str().find("Lookups: 1"), std::string::npos);
+}
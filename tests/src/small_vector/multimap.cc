@@ -0,0 +1,61 @@
+#include "dictool/MultiDict.h"
+#include "dictool/SmallVector.h"
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <string>
+#include <unordered_map>
+
+using namespace dictool;
+using ::testing::ElementsAre;
+
+// Test small_vector as the value container of a MultiMap
+TEST(SmallVectorMultiMapTest, Basic) {
+  MultiMap<std::string, int, small_vector> mm;
+  mm.emplace("a", 1);
+  mm.emplace("a", 2);
+  mm.emplace("b", 3);
+  for (int i = 0; i < 5; ++i) {
+    mm.emplace("c", i);
+  }
+
+  EXPECT_EQ(mm.size(), 8u);
+  EXPECT_EQ(mm.count("c"), 5u);
+  EXPECT_TRUE(mm.at("a").is_inline());
+  EXPECT_FALSE(mm.at("c").is_inline());
+  EXPECT_THAT(mm.view("a"), ElementsAre(1, 2));
+
+  size_t visited = 0;
+  for (auto it = mm.begin(); it != mm.end(); ++it) {
+    ++visited;
+  }
+  EXPECT_EQ(visited, 8u);
+}
+
+// Test erase, merge and bulk load on small_vector containers
+TEST(SmallVectorMultiMapTest, Modifiers) {
+  using Map = MultiMap<int, int, small_vector>;
+  auto mm = Map::from_unsorted({{2, 1}, {1, 1}, {2, 2}, {1, 2}, {1, 3}});
+  EXPECT_THAT(mm.view(1), ElementsAre(1, 2, 3));
+
+  EXPECT_EQ(mm.erase_if([](int, int v) { return v == 2; }), 2u);
+  EXPECT_THAT(mm.view(1), ElementsAre(1, 3));
+
+  mm.merge(Map{{1, 4}, {1, 5}, {3, 1}});
+  EXPECT_THAT(mm.view(1), ElementsAre(1, 3, 4, 5));
+  EXPECT_EQ(mm.size(), 6u);
+
+  mm.erase(mm.cbegin());
+  EXPECT_EQ(mm.size(), 5u);
+  mm.shrink_to_fit();
+  EXPECT_EQ(mm.size(), 5u);
+}
+
+// Test a custom inline capacity with a hashed dictionary
+TEST(SmallVectorMultiMapTest, CustomCapacity) {
+  MultiMap<int, int, small_vector_of<8>::type, std::unordered_map> mm;
+  for (int i = 0; i < 8; ++i) {
+    mm.emplace(1, i);
+  }
+  EXPECT_TRUE(mm.at(1).is_inline());
+  EXPECT_EQ(mm.at(1).capacity(), 8u);
+}
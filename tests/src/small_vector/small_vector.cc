@@ -0,0 +1,235 @@
+#include "dictool/SmallVector.h"
+#include <gmock/gmock.h>
+#include <cstddef>
+#include <gtest/gtest.h>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+using namespace dictool;
+using ::testing::ElementsAre;
+
+namespace {
+
+// Element whose copy throws once copies_left reaches 0. It has no move
+// constructor, so growth copies it
+struct Fragile {
+  static inline int live = 0;
+  static inline int copies_left = -1;
+
+  Fragile() { ++live; }
+  Fragile(const Fragile &) {
+    if (copies_left == 0) {
+      throw std::runtime_error("copy");
+    }
+    --copies_left;
+    ++live;
+  }
+  ~Fragile() { --live; }
+};
+
+// Random access range of n characters that is never read, to ask for more
+// elements than fit
+struct HugeRange {
+  using iterator_category = std::random_access_iterator_tag;
+  using value_type = char;
+  using difference_type = std::ptrdiff_t;
+  using pointer = const char *;
+  using reference = char;
+
+  difference_type i = 0;
+
+  char operator*() const { return 'x'; }
+  HugeRange &operator++() {
+    ++i;
+    return *this;
+  }
+  difference_type operator-(const HugeRange &other) const {
+    return i - other.i;
+  }
+  bool operator==(const HugeRange &other) const { return i == other.i; }
+  bool operator!=(const HugeRange &other) const { return i != other.i; }
+};
+
+} // namespace
+
+// Test elements stay inline up to N and spill to the heap beyond
+TEST(SmallVectorTest, InlineThenHeap) {
+  basic_small_vector<int, 3> v;
+  EXPECT_TRUE(v.empty());
+  EXPECT_TRUE(v.is_inline());
+  EXPECT_EQ(v.capacity(), 3u);
+
+  v.push_back(1);
+  v.emplace_back(2);
+  v.push_back(3);
+  EXPECT_TRUE(v.is_inline());
+
+  v.push_back(4);
+  EXPECT_FALSE(v.is_inline());
+  EXPECT_GE(v.capacity(), 4u);
+  EXPECT_THAT(v, ElementsAre(1, 2, 3, 4));
+  EXPECT_EQ(v.front(), 1);
+  EXPECT_EQ(v.back(), 4);
+  EXPECT_EQ(v.at(2), 3);
+  EXPECT_THROW(v.at(4), std::out_of_range);
+}
+
+// Test constructors
+TEST(SmallVectorTest, Constructors) {
+  small_vector<int> filled(5, 7);
+  EXPECT_THAT(filled, ElementsAre(7, 7, 7, 7, 7));
+
+  small_vector<int> sized(2);
+  EXPECT_THAT(sized, ElementsAre(0, 0));
+
+  std::list<int> source{1, 2, 3, 4};
+  small_vector<int> ranged(source.begin(), source.end());
+  EXPECT_THAT(ranged, ElementsAre(1, 2, 3, 4));
+
+  small_vector<int> listed{5, 6};
+  EXPECT_THAT(listed, ElementsAre(5, 6));
+}
+
+// Test copy and move of inline and heap vectors
+TEST(SmallVectorTest, CopyMove) {
+  small_vector<std::string> small{"a", "b"};
+  small_vector<std::string> large{"a", "b", "c", "d", "e"};
+
+  auto small_copy = small;
+  auto large_copy = large;
+  EXPECT_EQ(small_copy, small);
+  EXPECT_EQ(large_copy, large);
+
+  auto small_moved = std::move(small_copy);
+  auto large_moved = std::move(large_copy);
+  EXPECT_EQ(small_moved, small);
+  EXPECT_EQ(large_moved, large);
+  EXPECT_TRUE(small_copy.empty());
+  EXPECT_TRUE(large_copy.empty());
+  EXPECT_TRUE(large_copy.is_inline());
+
+  small_moved = large;
+  EXPECT_EQ(small_moved, large);
+  large_moved = std::move(small);
+  EXPECT_THAT(large_moved, ElementsAre("a", "b"));
+
+  swap(small_moved, large_moved);
+  EXPECT_THAT(small_moved, ElementsAre("a", "b"));
+  EXPECT_EQ(large_moved.size(), 5u);
+}
+
+// Test insert and erase in the middle
+TEST(SmallVectorTest, InsertErase) {
+  small_vector<int> v{1, 5};
+  int more[] = {2, 3, 4};
+  auto it = v.insert(v.begin() + 1, std::begin(more), std::end(more));
+  EXPECT_EQ(*it, 2);
+  EXPECT_THAT(v, ElementsAre(1, 2, 3, 4, 5));
+
+  v.insert(v.begin(), 0);
+  v.insert(v.end(), 2, 6);
+  EXPECT_THAT(v, ElementsAre(0, 1, 2, 3, 4, 5, 6, 6));
+
+  it = v.erase(v.begin() + 1, v.begin() + 4);
+  EXPECT_EQ(*it, 4);
+  EXPECT_THAT(v, ElementsAre(0, 4, 5, 6, 6));
+
+  v.erase(v.begin());
+  v.pop_back();
+  EXPECT_THAT(v, ElementsAre(4, 5, 6));
+}
+
+// Test appending elements of the vector itself across a reallocation
+TEST(SmallVectorTest, SelfReferencingInsert) {
+  small_vector<std::string> v{"x", "y", "z"};
+  v.push_back(v[0]);
+  EXPECT_THAT(v, ElementsAre("x", "y", "z", "x"));
+
+  v.insert(v.end(), v.begin(), v.end());
+  EXPECT_THAT(v, ElementsAre("x", "y", "z", "x", "x", "y", "z", "x"));
+}
+
+// Test resize, reserve and shrinking back inline
+TEST(SmallVectorTest, Capacity) {
+  small_vector<int> v;
+  v.reserve(10);
+  EXPECT_FALSE(v.is_inline());
+  EXPECT_GE(v.capacity(), 10u);
+
+  v.resize(4, 9);
+  EXPECT_THAT(v, ElementsAre(9, 9, 9, 9));
+  v.shrink_to_fit();
+  EXPECT_EQ(v.capacity(), 4u);
+
+  v.resize(2);
+  v.shrink_to_fit();
+  EXPECT_TRUE(v.is_inline());
+  EXPECT_THAT(v, ElementsAre(9, 9));
+
+  v.clear();
+  EXPECT_TRUE(v.empty());
+}
+
+// Test move-only elements
+TEST(SmallVectorTest, MoveOnly) {
+  small_vector<std::unique_ptr<int>> v;
+  for (int i = 0; i < 6; ++i) {
+    v.push_back(std::make_unique<int>(i));
+  }
+  auto moved = std::move(v);
+  EXPECT_EQ(*moved[5], 5);
+  moved.erase(moved.begin());
+  EXPECT_EQ(*moved.front(), 1);
+}
+
+// Test constructors that throw partway free what they built
+TEST(SmallVectorTest, ConstructorsThrow) {
+  using Vector = basic_small_vector<Fragile, 2>;
+  {
+    Vector v(8);
+    Fragile::copies_left = 4;
+    EXPECT_THROW(Vector copy(v), std::runtime_error);
+    Fragile::copies_left = 4;
+    EXPECT_THROW(Vector ranged(v.begin(), v.end()), std::runtime_error);
+    Fragile::copies_left = 4;
+    EXPECT_THROW(Vector filled(8, v.front()), std::runtime_error);
+    Fragile::copies_left = -1;
+    EXPECT_EQ(Fragile::live, 8);
+  }
+  EXPECT_EQ(Fragile::live, 0);
+}
+
+// Test growth that throws while copying the old elements leaves the small
+// vector as it was
+TEST(SmallVectorTest, GrowthThrows) {
+  {
+    basic_small_vector<Fragile, 2> v(4);
+    ASSERT_EQ(v.capacity(), 4u);
+    Fragile::copies_left = 2;
+    EXPECT_THROW(v.emplace_back(), std::runtime_error);
+    EXPECT_EQ(v.size(), 4u);
+    EXPECT_EQ(v.capacity(), 4u);
+    EXPECT_EQ(Fragile::live, 4);
+
+    Fragile::copies_left = 3;
+    EXPECT_THROW(v.insert(v.end(), v.begin(), v.begin() + 2),
+                 std::runtime_error);
+    EXPECT_EQ(v.size(), 4u);
+    EXPECT_EQ(Fragile::live, 4);
+    Fragile::copies_left = -1;
+  }
+  EXPECT_EQ(Fragile::live, 0);
+}
+
+// Test sizes beyond max_size() are refused before anything is allocated
+TEST(SmallVectorTest, LengthLimit) {
+  small_vector<char> v{'a'};
+  HugeRange first;
+  HugeRange last{static_cast<std::ptrdiff_t>(v.max_size())};
+  EXPECT_THROW(v.insert(v.end(), first, last), std::length_error);
+  EXPECT_THAT(v, ElementsAre('a'));
+  EXPECT_THROW(v.reserve(v.max_size() + 1), std::length_error);
+}
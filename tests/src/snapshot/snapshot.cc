@@ -0,0 +1,184 @@
+#include "dictool/Snapshot.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <string>
+#include <unordered_map>
+
+using namespace dictool;
+using ::testing::ElementsAre;
+
+namespace {
+
+// Snapshot file in the temp directory, removed at the end of the test
+struct TempFile {
+  std::string path;
+
+  explicit TempFile(const std::string &name)
+      : path((std::filesystem::temp_directory_path() /
+              ("dictool_" + name + ".snap"))
+                 .string()) {}
+  ~TempFile() { std::remove(path.c_str()); }
+};
+
+// Overwrite one byte of a file
+void poke(const std::string &path, long offset, char byte) {
+  std::fstream f(path, std::ios::in | std::ios::out | std::ios::binary);
+  f.seekp(offset);
+  f.put(byte);
+}
+
+// Read the header of a snapshot file
+detail::SnapshotHeader read_header(const std::string &path) {
+  detail::SnapshotHeader header{};
+  std::ifstream f(path, std::ios::binary);
+  f.read(reinterpret_cast<char *>(&header), sizeof(header));
+  return header;
+}
+
+// Overwrite the header of a snapshot file
+void write_header(const std::string &path,
+                  const detail::SnapshotHeader &header) {
+  std::fstream f(path, std::ios::in | std::ios::out | std::ios::binary);
+  f.write(reinterpret_cast<const char *>(&header), sizeof(header));
+}
+
+struct Point {
+  int x;
+  int y;
+};
+
+} // namespace
+
+// Test trivially copyable keys and values round-trip
+TEST(SnapshotTest, RoundTripInts) {
+  TempFile file("ints");
+  MultiMap<int, double> mm{{3, 0.5}, {1, 1.5}, {3, 2.5}};
+  save_binary(mm, file.path);
+
+  auto mapped = load_mmap<int, double>(file.path);
+  EXPECT_EQ(mapped.size(), 3u);
+  EXPECT_EQ(mapped.key_count(), 2u);
+  EXPECT_THAT(mapped.view(3), ElementsAre(0.5, 2.5));
+  EXPECT_EQ(mapped.count(1), 1u);
+  EXPECT_FALSE(mapped.contains(2));
+  EXPECT_TRUE(mapped.view(2).empty());
+  EXPECT_EQ(mapped.key_at(0), 1);
+
+  // Views point into the mapping, not into a copy
+  auto view = mapped.view(3);
+  EXPECT_EQ(view.data(), mapped.view(3).data());
+}
+
+// Test an unordered MultiMap is written in key order
+TEST(SnapshotTest, UnorderedSource) {
+  TempFile file("unordered");
+  MultiMap<int, Point, std::vector, std::unordered_map> mm;
+  for (int k = 9; k >= 0; --k) {
+    mm.emplace(k, Point{k, -k});
+  }
+  save_binary(mm, file.path);
+
+  auto mapped = load_mmap<int, Point>(file.path);
+  std::vector<int> keys;
+  mapped.for_each_group([&](int key, auto values) {
+    keys.push_back(key);
+    EXPECT_EQ(values[0].y, -key);
+  });
+  EXPECT_THAT(keys, ElementsAre(0, 1, 2, 3, 4, 5, 6, 7, 8, 9));
+}
+
+// Test std::string keys and values go through the string table
+TEST(SnapshotTest, Strings) {
+  TempFile file("strings");
+  MultiMap<std::string, std::string> mm{
+      {"fruit", "apple"}, {"veg", "leek"}, {"fruit", "fig"}, {"", "empty"}};
+  save_binary(mm, file.path);
+
+  auto mapped = load_mmap<std::string, std::string>(file.path);
+  EXPECT_THAT(mapped.view("fruit"), ElementsAre("apple", "fig"));
+  EXPECT_THAT(mapped.view(""), ElementsAre("empty"));
+  EXPECT_FALSE(mapped.contains("fruits"));
+
+  auto back = mapped.materialize();
+  EXPECT_EQ(back.size(), 4u);
+  EXPECT_THAT(back.view("veg"), ElementsAre("leek"));
+}
+
+// Test mixed string keys with trivially copyable values
+TEST(SnapshotTest, StringKeys) {
+  TempFile file("string_keys");
+  FrozenMultiMap<std::string, int> frozen(
+      MultiMap<std::string, int>{{"b", 2}, {"a", 1}, {"b", 3}});
+  save_binary(frozen, file.path);
+
+  auto mapped = load_mmap<std::string, int>(file.path);
+  EXPECT_THAT(mapped.view("b"), ElementsAre(2, 3));
+  EXPECT_EQ(mapped.materialize().size(), 3u);
+}
+
+// Test an empty map round-trips
+TEST(SnapshotTest, Empty) {
+  TempFile file("empty");
+  save_binary(MultiMap<int, int>(), file.path);
+  auto mapped = load_mmap<int, int>(file.path);
+  EXPECT_TRUE(mapped.empty());
+  EXPECT_FALSE(mapped.contains(0));
+}
+
+// Test damaged or mismatched files are rejected
+TEST(SnapshotTest, Errors) {
+  TempFile file("errors");
+  EXPECT_THROW((load_mmap<int, int>(file.path)), std::runtime_error);
+
+  save_binary(MultiMap<int, int>{{1, 1}, {2, 2}}, file.path);
+  EXPECT_THROW((load_mmap<int, double>(file.path)), std::runtime_error);
+  EXPECT_THROW((load_mmap<std::string, int>(file.path)), std::runtime_error);
+
+  // Flip a value byte: only the checksum notices
+  auto size = std::filesystem::file_size(file.path);
+  detail::SnapshotLayout layout(read_header(file.path));
+  poke(file.path, static_cast<long>(layout.values), 0x7f);
+  EXPECT_THROW((load_mmap<int, int>(file.path)), std::runtime_error);
+  auto unverified = load_mmap<int, int>(file.path, false);
+  EXPECT_NE(unverified.view(1)[0], 1);
+
+  poke(file.path, 0, 'X');
+  EXPECT_THROW((load_mmap<int, int>(file.path, false)), std::runtime_error);
+
+  save_binary(MultiMap<int, int>{{1, 1}}, file.path);
+  std::filesystem::resize_file(file.path, size - 8);
+  EXPECT_THROW((load_mmap<int, int>(file.path, false)), std::runtime_error);
+}
+
+// Test counts that wrap around to the real file size are rejected
+TEST(SnapshotTest, HeaderOverflow) {
+  TempFile file("overflow");
+  save_binary(MultiMap<int, int>{{1, 1}, {2, 2}}, file.path);
+
+  // key_count * key_size and (key_count + 1) * 8 both wrap to their
+  // original values, so the layout still ends at the file size
+  auto header = read_header(file.path);
+  header.key_count += uint64_t(1) << 62;
+  write_header(file.path, header);
+  EXPECT_THROW((load_mmap<int, int>(file.path, false)), std::runtime_error);
+  EXPECT_THROW((load_mmap<int, int>(file.path)), std::runtime_error);
+}
+
+// Test saving over a mapped snapshot leaves the old mapping readable
+TEST(SnapshotTest, SaveOverMapped) {
+  TempFile file("replace");
+  save_binary(MultiMap<int, int>{{1, 1}, {2, 2}}, file.path);
+  auto old = load_mmap<int, int>(file.path);
+
+  save_binary(MultiMap<int, int>{{3, 3}}, file.path);
+  EXPECT_FALSE(std::filesystem::exists(file.path + ".tmp"));
+  EXPECT_THAT(old.view(2), ElementsAre(2));
+  EXPECT_EQ(old.size(), 2u);
+
+  auto fresh = load_mmap<int, int>(file.path);
+  EXPECT_THAT(fresh.view(3), ElementsAre(3));
+  EXPECT_FALSE(fresh.contains(1));
+}
@@ -0,0 +1,93 @@
+#include "dictool/VersionedMultiMap.h"
+#include <atomic>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+using namespace dictool;
+
+// One writer publishing while readers pin. Every version holds key k with
+// values 0..k-1 for k < n, so a reader that sees a freed or half-built
+// version notices. Build with -Ddictool_SANITIZER=thread or address to
+// have the sanitizers check reclamation.
+TEST(VersionedMultiMapStressTest, WriterAndReaders) {
+  auto build = [](int n) {
+    MultiMap<int, int> m;
+    for (int k = 0; k < n; ++k) {
+      for (int v = 0; v < k; ++v) {
+        m.emplace(k, v);
+      }
+    }
+    return m;
+  };
+
+  VersionedMultiMap<MultiMap<int, int>> vm(build(8));
+  std::atomic<bool> done{false};
+  std::atomic<bool> bad{false};
+  std::atomic<long> reads{0};
+
+  std::vector<std::thread> readers;
+  for (int r = 0; r < 4; ++r) {
+    readers.emplace_back([&] {
+      auto reader = vm.reader();
+      while (!done) {
+        auto snap = reader.pin();
+        for (int k = 0; k < 8; ++k) {
+          auto values = snap->view(k);
+          bad = bad || values.size() != size_t(k);
+          for (size_t v = 0; v < values.size(); ++v) {
+            bad = bad || values[v] != int(v);
+          }
+        }
+        ++reads;
+      }
+    });
+  }
+
+  for (int i = 0; i < 2000; ++i) {
+    if (i % 2 == 0) {
+      vm.publish(build(8 + i % 5));
+    } else {
+      vm.update([](MultiMap<int, int> &m) { m.emplace(100, 0); });
+    }
+  }
+  done = true;
+  for (auto &t : readers) {
+    t.join();
+  }
+
+  EXPECT_FALSE(bad);
+  EXPECT_EQ(vm.version(), 2000u);
+  vm.reclaim();
+  EXPECT_EQ(vm.retired_count(), 0u);
+}
+
+// Readers calling size() on a version patched through operator[]. size()
+// is const and must not write, which the thread sanitizer checks.
+TEST(VersionedMultiMapStressTest, SizeAfterOperatorBracket) {
+  VersionedMultiMap<MultiMap<int, int>> vm(MultiMap<int, int>{{1, 1}});
+  std::atomic<bool> done{false};
+  std::atomic<bool> bad{false};
+
+  std::vector<std::thread> readers;
+  for (int r = 0; r < 4; ++r) {
+    readers.emplace_back([&] {
+      auto reader = vm.reader();
+      while (!done) {
+        auto snap = reader.pin();
+        bad = bad || snap->size() != snap->at(1).size();
+      }
+    });
+  }
+
+  for (int i = 0; i < 500; ++i) {
+    vm.update([](MultiMap<int, int> &m) { m[1].push_back(0); });
+  }
+  done = true;
+  for (auto &t : readers) {
+    t.join();
+  }
+
+  EXPECT_FALSE(bad);
+  EXPECT_EQ(vm.reader().pin()->size(), 501u);
+}
@@ -0,0 +1,110 @@
+#include "dictool/FrozenMultiMap.h"
+#include "dictool/VersionedMultiMap.h"
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+using namespace dictool;
+using ::testing::ElementsAre;
+
+namespace {
+
+// Map stand-in that counts live instances
+struct Counted {
+  static inline int live = 0;
+  int value = 0;
+
+  Counted(int value = 0) : value(value) { ++live; }
+  Counted(const Counted &other) : value(other.value) { ++live; }
+  Counted(Counted &&other) noexcept : value(other.value) { ++live; }
+  ~Counted() { --live; }
+};
+
+} // namespace
+
+// Test readers see the version current at pin time
+TEST(VersionedMultiMapTest, PublishAndPin) {
+  VersionedMultiMap<MultiMap<int, int>> vm(MultiMap<int, int>{{1, 10}});
+  auto reader = vm.reader();
+
+  auto before = reader.pin();
+  EXPECT_THAT(before->view(1), ElementsAre(10));
+
+  vm.publish(MultiMap<int, int>{{1, 11}, {2, 20}});
+  EXPECT_EQ(vm.version(), 1u);
+  EXPECT_THAT(before->view(1), ElementsAre(10));
+  EXPECT_FALSE(before->contains(2));
+  before.release();
+
+  auto after = reader.pin();
+  EXPECT_THAT(after->view(1), ElementsAre(11));
+  EXPECT_EQ((*after).size(), 2u);
+}
+
+// Test update patches a copy of the current version
+TEST(VersionedMultiMapTest, Update) {
+  VersionedMultiMap<MultiMap<int, int>> vm;
+  vm.update([](MultiMap<int, int> &m) { m.emplace(1, 1); });
+  vm.update([](MultiMap<int, int> &m) { m.emplace(1, 2); });
+
+  auto reader = vm.reader();
+  EXPECT_THAT(reader.pin()->view(1), ElementsAre(1, 2));
+  EXPECT_EQ(vm.version(), 2u);
+}
+
+// Test retired versions are freed only once no reader pins them
+TEST(VersionedMultiMapTest, Reclaim) {
+  {
+    VersionedMultiMap<Counted> vm(Counted(0));
+    auto reader = vm.reader();
+    EXPECT_EQ(Counted::live, 1);
+
+    // Nobody reads: the old version goes right away
+    vm.publish(Counted(1));
+    EXPECT_EQ(Counted::live, 1);
+    EXPECT_EQ(vm.retired_count(), 0u);
+
+    // A pinned version survives any number of publishes
+    auto pinned = reader.pin();
+    vm.publish(Counted(2));
+    vm.publish(Counted(3));
+    EXPECT_EQ(pinned->value, 1);
+    EXPECT_EQ(vm.retired_count(), 2u);
+    EXPECT_EQ(Counted::live, 3);
+
+    pinned.release();
+    EXPECT_EQ(vm.reclaim(), 2u);
+    EXPECT_EQ(Counted::live, 1);
+    EXPECT_EQ(reader.pin()->value, 3);
+  }
+  EXPECT_EQ(Counted::live, 0);
+}
+
+// Test reader slots are recycled after a Reader goes away
+TEST(VersionedMultiMapTest, ReaderReuse) {
+  VersionedMultiMap<Counted> vm;
+  {
+    auto a = vm.reader();
+    auto pinned = a.pin();
+    vm.publish(Counted(1));
+    EXPECT_EQ(vm.retired_count(), 1u);
+  }
+  // The dropped reader no longer holds the retired version back
+  EXPECT_EQ(vm.reclaim(), 1u);
+
+  auto b = vm.reader();
+  auto moved = std::move(b);
+  EXPECT_EQ(moved.pin()->value, 1);
+}
+
+// Test a frozen layout as the published version
+TEST(VersionedMultiMapTest, Frozen) {
+  using Frozen = FrozenMultiMap<int, int>;
+  VersionedMultiMap<Frozen> vm(Frozen(MultiMap<int, int>{{1, 1}, {1, 2}}));
+  auto reader = vm.reader();
+  EXPECT_THAT(reader.pin()->view(1), ElementsAre(1, 2));
+
+  vm.publish(Frozen(MultiMap<int, int>{{3, 3}}));
+  auto snap = reader.pin();
+  EXPECT_FALSE(snap->contains(1));
+  EXPECT_EQ(snap->count(3), 1u);
+}